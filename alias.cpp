@@ -0,0 +1,74 @@
+#include "alias.h"
+#include <climits>
+using namespace std;
+
+AliasTable::AliasTable() : columnHeight(1) {
+}
+
+AliasTable::AliasTable(const vector<int>& weights)
+    : columnHeight(0), threshold(weights.size()), alias(weights.size()) {
+    int count = (int)weights.size();
+    for (int weight : weights) {
+        columnHeight += weight;
+    }
+    
+    // Scale every weight by the entry count, so the columns are exactly columnHeight high on average
+    vector<long long> scaled(count);
+    vector<int> small, large;
+    for (int i = 0; i < count; i++) {
+        scaled[i] = (long long)weights[i] * count;
+        alias[i] = i;
+        (scaled[i] < columnHeight ? small : large).push_back(i);
+    }
+    
+    // Fill each short column with part of a tall one (Vose's pairing)
+    while (!small.empty() && !large.empty()) {
+        int shortColumn = small.back();
+        int tallColumn = large.back();
+        small.pop_back();
+        threshold[shortColumn] = (int)scaled[shortColumn];
+        alias[shortColumn] = tallColumn;
+        scaled[tallColumn] -= columnHeight - scaled[shortColumn];
+        if (scaled[tallColumn] < columnHeight) {
+            large.pop_back();
+            small.push_back(tallColumn);
+        }
+    }
+    for (int i : large) {
+        threshold[i] = columnHeight;
+    }
+    for (int i : small) {
+        threshold[i] = columnHeight;
+    }
+}
+
+bool AliasTable::isValid(const vector<int>& weights, string& error) {
+    long long total = 0;
+    for (int weight : weights) {
+        if (weight < 0) {
+            error = "negative weight";
+            return false;
+        }
+        total += weight;
+    }
+    if (total <= 0) {
+        error = "all weights are 0";
+        return false;
+    }
+    if (total * (long long)weights.size() > INT_MAX) {
+        error = "weights too large";
+        return false;
+    }
+    return true;
+}
+
+void AliasTable::sampleMany(Random& rng, int* indices, int count) const {
+    const int* thresholds = threshold.data();
+    const int* aliases = alias.data();
+    int bound = size() * columnHeight;
+    for (int i = 0; i < count; i++) {
+        int roll = rng.nextInt(bound);
+        int column = roll / columnHeight;
+        indices[i] = roll - column * columnHeight < thresholds[column] ? column : aliases[column];
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef ALIAS_H
+#define ALIAS_H
+
+#include "rng.h"
+#include <string>
+#include <vector>
+
+// Weighted random choice in O(1) with the Walker alias method, in exact integer arithmetic.
+// Each of the n entries owns one column of height W (the total weight): a column keeps its own entry
+// below its threshold and hands the rest to its alias. One nextInt(n * W) picks the column and the
+// height at once, so a draw costs a single random number however large the table grows.
+// With equal weights every threshold is W, and a draw returns the same entry as rng.nextInt(n).
+class AliasTable {
+private:
+    int columnHeight;
+    std::vector<int> threshold;
+    std::vector<int> alias;
+    
+public:
+    // What it does: Creates an empty table (sample must not be called on it)
+    // Inputs: None
+    // Outputs: None
+    AliasTable();
+    
+    // What it does: Builds the table for a list of weights (see isValid)
+    // Inputs: weights - relative weight of each entry
+    // Outputs: None
+    explicit AliasTable(const std::vector<int>& weights);
+    
+    // What it does: Checks that weights can be turned into a table: none negative, a positive total,
+    // and entry count * total weight small enough for one nextInt draw
+    // Inputs: weights - relative weight of each entry, error - reference to store the reason if they cannot
+    // Outputs: Returns true if the weights are usable, false otherwise
+    static bool isValid(const std::vector<int>& weights, std::string& error);
+    
+    // What it does: Draws one entry with probability weight / total weight
+    // Inputs: rng - random number generator to draw from
+    // Outputs: Index of the chosen entry
+    int sample(Random& rng) const {
+        int roll = rng.nextInt(size() * columnHeight);
+        int column = roll / columnHeight;
+        return roll - column * columnHeight < threshold[column] ? column : alias[column];
+    }
+    
+    // What it does: Draws several entries, one random number each
+    // Inputs: rng - random number generator to draw from, indices - array to store the chosen entries, count - number of draws
+    // Outputs: None
+    void sampleMany(Random& rng, int* indices, int count) const;
+    
+    // What it does: Returns number of entries
+    // Inputs: None
+    // Outputs: Entry count (int)
+    int size() const { return (int)threshold.size(); }
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "arena.h"
+#include <cstdlib>
+#include <algorithm>
+using namespace std;
+
+namespace {
+    // Smallest heap block an arena allocates after its own buffer is used up
+    const size_t MIN_BLOCK_SIZE = 4096;
+    
+#ifdef COUNT_HEAP_ALLOCATIONS
+    // Heap allocations made by this thread (counted by the operator new replacements below)
+    thread_local uint64_t heapAllocations = 0;
+#endif
+    
+    // What it does: Rounds an address up to an alignment
+    // Inputs: address - address to align, alignment - alignment (power of two)
+    // Outputs: Aligned address
+    uintptr_t alignUp(uintptr_t address, size_t alignment) {
+        return (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+}
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+uint64_t getHeapAllocationCount() {
+    return heapAllocations;
+}
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        void* memory = malloc(size);
+        if (memory) {
+            return memory;
+        }
+        new_handler handler = get_new_handler();
+        if (!handler) {
+            throw bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return operator new(size, nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+#endif
+
+Arena::Arena(void* buffer, size_t size)
+    : buffer(static_cast<unsigned char*>(buffer)), bufferSize(size), blocks(nullptr), used(0), blockCount(0) {
+}
+
+Arena::~Arena() {
+    while (blocks) {
+        Block* next = blocks->next;
+        operator delete(blocks);
+        blocks = next;
+    }
+}
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    unsigned char* base = blocks ? reinterpret_cast<unsigned char*>(blocks + 1) : buffer;
+    size_t limit = blocks ? blocks->size : bufferSize;
+    uintptr_t start = alignUp((uintptr_t)(base + used), alignment);
+    if (start + size > (uintptr_t)(base + limit)) {
+        nextBlock(size, alignment);
+        base = reinterpret_cast<unsigned char*>(blocks + 1);
+        start = alignUp((uintptr_t)base, alignment);
+    }
+    used = start + size - (uintptr_t)base;
+    return reinterpret_cast<void*>(start);
+}
+
+void Arena::nextBlock(size_t size, size_t alignment) {
+    size_t blockSize = max(size + alignment, MIN_BLOCK_SIZE);
+    Block* block = static_cast<Block*>(operator new(sizeof(Block) + blockSize));
+    block->size = blockSize;
+    block->next = blocks;
+    blocks = block;
+    used = 0;
+    blockCount++;
+}
+
+uint64_t Arena::getBlockCount() const {
+    return blockCount;
+}
@@ -0,0 +1,96 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+// What it does: Returns number of heap allocations (calls of operator new) the calling thread has made so far.
+// Only builds with COUNT_HEAP_ALLOCATIONS defined (the bench build) count them, by replacing the global
+// operator new in arena.cpp; every other build keeps the standard allocator and always gets 0.
+// Inputs: None
+// Outputs: Allocation count (uint64_t)
+#ifdef COUNT_HEAP_ALLOCATIONS
+uint64_t getHeapAllocationCount();
+#else
+inline uint64_t getHeapAllocationCount() {
+    return 0;
+}
+#endif
+
+// Bump allocator for objects that live exactly as long as their owner (e.g. one battle). Memory is
+// carved from a buffer the owner supplies, then from heap blocks once that is used up, and is all
+// given back when the arena is destroyed. Objects are never destroyed one by one, so only trivially
+// destructible types can be allocated.
+class Arena {
+private:
+    // Heap block used after the owner's buffer is full (its data follows the header)
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+    
+    unsigned char* buffer;
+    size_t bufferSize;
+    Block* blocks;
+    size_t used;
+    uint64_t blockCount;
+    
+    // What it does: Starts a new heap block with room for an allocation (blocks is the one being filled)
+    // Inputs: size - bytes needed, alignment - alignment needed
+    // Outputs: None
+    void nextBlock(size_t size, size_t alignment);
+    
+public:
+    // What it does: Creates an arena over a buffer owned by the caller
+    // Inputs: buffer - memory to allocate from first, size - size of the buffer in bytes
+    // Outputs: None
+    Arena(void* buffer, size_t size);
+    
+    // What it does: Frees the heap blocks of the arena
+    // Inputs: None
+    // Outputs: None
+    ~Arena();
+    
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    
+    // What it does: Allocates memory from the arena
+    // Inputs: size - bytes to allocate, alignment - required alignment (power of two)
+    // Outputs: Pointer to the memory (valid until the arena is destroyed)
+    void* allocate(size_t size, size_t alignment);
+    
+    // What it does: Allocates an array of value-initialized objects
+    // Inputs: count - number of objects
+    // Outputs: Pointer to the first object
+    template <typename T>
+    T* allocateArray(int count) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena objects are never destroyed");
+        T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (int i = 0; i < count; i++) {
+            new (data + i) T();
+        }
+        return data;
+    }
+    
+    // What it does: Returns number of heap blocks the arena had to allocate (0 while the owner's buffer is big enough)
+    // Inputs: None
+    // Outputs: Block count (uint64_t)
+    uint64_t getBlockCount() const;
+};
+
+// Arena with its first buffer stored inline, so an owner allocated on the stack needs no heap memory at all
+template <size_t Size>
+class InlineArena : public Arena {
+private:
+    alignas(std::max_align_t) unsigned char storage[Size];
+    
+public:
+    // What it does: Creates the arena over its inline buffer
+    // Inputs: None
+    // Outputs: None
+    InlineArena() : Arena(storage, Size) {}
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "autosave.h"
+#include "metrics.h"
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+using namespace std;
+
+namespace {
+    // Histogram of the waits that did happen: exact below 8 ns, then 8 buckets per power of two
+    const int STALL_SUB_BUCKETS = 8;
+    const int STALL_BUCKETS = 62 * STALL_SUB_BUCKETS;
+    
+    atomic<uint64_t> stallCount(0);
+    atomic<uint64_t> stallWaits(0);
+    atomic<uint64_t> stallMax(0);
+    atomic<uint64_t> stallBuckets[STALL_BUCKETS];
+    
+    // What it does: Returns the stall histogram bucket of a duration
+    // Inputs: nanoseconds - stall duration
+    // Outputs: Bucket index (0 to STALL_BUCKETS - 1)
+    int stallBucket(uint64_t nanoseconds) {
+        if (nanoseconds < STALL_SUB_BUCKETS) {
+            return (int)nanoseconds;
+        }
+        int log = 63 - __builtin_clzll(nanoseconds);
+        return (log - 2) * STALL_SUB_BUCKETS + (int)((nanoseconds >> (log - 3)) & (STALL_SUB_BUCKETS - 1));
+    }
+    
+    // What it does: Returns the largest duration that falls into a stall histogram bucket
+    // Inputs: bucket - bucket index
+    // Outputs: Upper bound in nanoseconds
+    uint64_t stallBucketBound(int bucket) {
+        if (bucket < STALL_SUB_BUCKETS) {
+            return bucket;
+        }
+        int log = bucket / STALL_SUB_BUCKETS + 2;
+        uint64_t width = 1ULL << (log - 3);
+        return (uint64_t)(STALL_SUB_BUCKETS + bucket % STALL_SUB_BUCKETS) * width + width - 1;
+    }
+    
+    // What it does: Counts one hand-off of the game thread to the writer and how long it waited
+    // Inputs: nanoseconds - time the game thread waited for the writer (0 if it did not wait)
+    // Outputs: None
+    void recordStall(uint64_t nanoseconds) {
+        stallCount.fetch_add(1, memory_order_relaxed);
+        if (nanoseconds == 0) {
+            return;
+        }
+        stallWaits.fetch_add(1, memory_order_relaxed);
+        stallBuckets[stallBucket(nanoseconds)].fetch_add(1, memory_order_relaxed);
+        uint64_t longest = stallMax.load(memory_order_relaxed);
+        while (nanoseconds > longest && !stallMax.compare_exchange_weak(longest, nanoseconds, memory_order_relaxed)) {
+        }
+    }
+    
+    // What it does: Returns the nanoseconds elapsed since a time point
+    // Inputs: start - time point
+    // Outputs: Elapsed nanoseconds (at least 1, so a measured wait never counts as none)
+    uint64_t nanosecondsSince(chrono::steady_clock::time_point start) {
+        int64_t elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        return elapsed > 0 ? (uint64_t)elapsed : 1;
+    }
+}
+
+// Writer thread shared by every Autosave of the process: takes slots with pending saves in the order
+// they were submitted and writes them one at a time, so fsyncs of different games never run in parallel
+class AutosaveWriter {
+private:
+    thread worker;
+    bool stopping;
+    
+    // What it does: Writes queued slots until the writer is stopped and the queue is empty
+    // Inputs: None
+    // Outputs: None
+    void run() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            Autosave* autosave = queue.front();
+            queue.pop_front();
+            int back = autosave->front;
+            autosave->front = 1 - back;
+            autosave->queued = false;
+            autosave->writing = true;
+            guard.unlock();
+            
+            bool ok = autosave->writeBuffer(back);
+            
+            guard.lock();
+            autosave->writing = false;
+            autosave->written++;
+            autosave->failed = autosave->failed || !ok;
+            done.notify_all();
+        }
+    }
+    
+public:
+    mutex lock;
+    condition_variable wake;
+    condition_variable done;
+    deque<Autosave*> queue;
+    
+    // What it does: Starts the writer thread
+    // Inputs: None
+    // Outputs: None
+    AutosaveWriter() : stopping(false) {
+        worker = thread(&AutosaveWriter::run, this);
+    }
+    
+    // What it does: Writes whatever is still queued and stops the writer thread
+    // Inputs: None
+    // Outputs: None
+    ~AutosaveWriter() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+    
+    // What it does: Returns the writer of the process, starting it on first use
+    // Inputs: None
+    // Outputs: Reference to the writer
+    static AutosaveWriter& get() {
+        static AutosaveWriter writer;
+        return writer;
+    }
+};
+
+Autosave::Autosave(SaveManager* saveManager)
+    : saveManager(saveManager), front(0), startingOver(false), queued(false), writing(false), failed(false), submitted(0), written(0) {
+    for (Buffer& buffer : buffers) {
+        buffer.hasLatest = false;
+        buffer.replaceJournal = false;
+    }
+}
+
+Autosave::~Autosave() {
+    flush();
+}
+
+bool Autosave::writeBuffer(int back) {
+    Buffer& buffer = buffers[back];
+    bool ok = true;
+    if (buffer.replaceJournal) {
+        // First save of a new run: the save file first, then a journal holding only the new run's checkpoints
+        ok = saveManager->saveState(buffer.latest);
+        ok = saveManager->replaceCheckpoints(buffer.checkpoints.data(), (int)buffer.checkpoints.size()) && ok;
+        buffer.checkpoints.clear();
+        buffer.hasLatest = false;
+        buffer.replaceJournal = false;
+    }
+    if (!buffer.checkpoints.empty()) {
+        ok = saveManager->appendCheckpoints(buffer.checkpoints.data(), (int)buffer.checkpoints.size());
+        buffer.checkpoints.clear();
+    }
+    if (buffer.hasLatest) {
+        ok = saveManager->saveState(buffer.latest) && ok;
+        buffer.hasLatest = false;
+    }
+    return ok;
+}
+
+bool Autosave::submit(Player* player, PotionManager* potionManager, int currentLevel, int difficulty, bool checkpoint) {
+    METRIC_TIME(MetricPhase::SaveStall);
+    SaveState state;
+    SaveManager::captureState(player, potionManager, currentLevel, difficulty, state);
+    
+    // Only a wait for the lock is timed: two clock reads would cost more than the whole hand-off
+    AutosaveWriter& writer = AutosaveWriter::get();
+    unique_lock<mutex> guard(writer.lock, try_to_lock);
+    if (guard.owns_lock()) {
+        recordStall(0);
+    } else {
+        auto waitStart = chrono::steady_clock::now();
+        guard.lock();
+        recordStall(nanosecondsSince(waitStart));
+    }
+    Buffer& buffer = buffers[front];
+    buffer.latest = state;
+    buffer.hasLatest = true;
+    if (startingOver) {
+        buffer.replaceJournal = true;
+        startingOver = false;
+    }
+    if (checkpoint) {
+        buffer.checkpoints.push_back(state);
+    }
+    submitted++;
+    if (!queued) {
+        queued = true;
+        writer.queue.push_back(this);
+        writer.wake.notify_one();
+    }
+    
+    bool ok = !failed;
+    failed = false;
+    return ok;
+}
+
+void Autosave::startOver() {
+    lock_guard<mutex> guard(AutosaveWriter::get().lock);
+    startingOver = true;
+}
+
+bool Autosave::flush() {
+    if (submitted == 0) {
+        return true;
+    }
+    METRIC_TIME(MetricPhase::SaveStall);
+    AutosaveWriter& writer = AutosaveWriter::get();
+    unique_lock<mutex> guard(writer.lock);
+    if (queued || writing) {
+        auto waitStart = chrono::steady_clock::now();
+        writer.done.wait(guard, [this] { return !queued && !writing; });
+        recordStall(nanosecondsSince(waitStart));
+    } else {
+        recordStall(0);
+    }
+    bool ok = !failed;
+    failed = false;
+    return ok;
+}
+
+uint64_t Autosave::getSubmittedCount() const {
+    lock_guard<mutex> guard(AutosaveWriter::get().lock);
+    return submitted;
+}
+
+uint64_t Autosave::getWrittenCount() const {
+    lock_guard<mutex> guard(AutosaveWriter::get().lock);
+    return written;
+}
+
+AutosaveStallStats Autosave::getStallStats() {
+    AutosaveStallStats stats;
+    // Waits first: every counted wait was counted as a hand-off before it
+    stats.waits = stallWaits.load(memory_order_relaxed);
+    stats.count = stallCount.load(memory_order_relaxed);
+    stats.maxNanoseconds = stallMax.load(memory_order_relaxed);
+    stats.p99Nanoseconds = 0;
+    // Rank of the 99th percentile among all hand-offs, rounded up; the ones that did not wait come first
+    uint64_t rank = stats.count - stats.count / 100;
+    uint64_t seen = stats.count - stats.waits;
+    for (int b = 0; b < STALL_BUCKETS && seen < rank; b++) {
+        seen += stallBuckets[b].load(memory_order_relaxed);
+        if (seen >= rank) {
+            stats.p99Nanoseconds = min(stallBucketBound(b), stats.maxNanoseconds);
+            break;
+        }
+    }
+    return stats;
+}
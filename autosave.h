@@ -0,0 +1,101 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include "save.h"
+#include <vector>
+#include <cstdint>
+
+// Game-thread stalls in Autosave::submit and flush of every autosave in the process: the time the
+// game thread waited for the writer (for its lock in submit, for pending saves in flush)
+struct AutosaveStallStats {
+    uint64_t count;            // hand-offs (submit and flush calls that reached the writer)
+    uint64_t waits;            // hand-offs that had to wait
+    uint64_t p99Nanoseconds;   // upper bound of the histogram bucket holding the 99th percentile (at most 1/8 above it)
+    uint64_t maxNanoseconds;
+};
+
+// Background autosave of one save slot. The game thread only copies the game state into the front
+// half of a double buffer (captureState, no serialization or I/O) and returns; one writer thread
+// shared by every game in the process swaps the halves, then serializes the back half and writes it
+// with its fsyncs while the game keeps playing. Saves submitted while the writer is busy coalesce:
+// the save file is written once with the newest state, and the checkpoints collected in the
+// meantime are appended with a single write and fsync. Every build counts how long the game thread
+// waits for the writer in submit and flush (getStallStats); builds with metrics also record the whole
+// time spent in them as the save_stall metric.
+class Autosave {
+private:
+    SaveManager* saveManager;
+    
+    // Double buffer: the game thread fills buffers[front], the writer writes buffers[1 - front]
+    struct Buffer {
+        SaveState latest;
+        bool hasLatest;
+        bool replaceJournal;
+        std::vector<SaveState> checkpoints;
+    };
+    Buffer buffers[2];
+    int front;
+    bool startingOver;
+    bool queued;
+    bool writing;
+    bool failed;
+    uint64_t submitted;
+    uint64_t written;
+    
+    friend class AutosaveWriter;
+    
+    // What it does: Writes the back half of the buffer (called by the writer thread without the lock held)
+    // Inputs: back - index of the half to write
+    // Outputs: Returns true if everything was written
+    bool writeBuffer(int back);
+    
+public:
+    // What it does: Creates the autosave of a slot (the writer thread starts with the first autosave in the process)
+    // Inputs: saveManager - save manager of the slot (must outlive the autosave; the game thread must not write
+    //         through it while saves are pending, see flush)
+    // Outputs: None
+    explicit Autosave(SaveManager* saveManager);
+    
+    // What it does: Waits until every pending save of the slot is written
+    // Inputs: None
+    // Outputs: None
+    ~Autosave();
+    
+    Autosave(const Autosave&) = delete;
+    Autosave& operator=(const Autosave&) = delete;
+    
+    // What it does: Hands the game state to the writer thread (returns without waiting for the disk)
+    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, currentLevel - level the save resumes at,
+    //         difficulty - difficulty mode, checkpoint - true to also append it to the journal as a level checkpoint
+    // Outputs: Returns false if an earlier autosave of the slot failed to write (reported once), true otherwise
+    bool submit(Player* player, PotionManager* potionManager, int currentLevel, int difficulty, bool checkpoint);
+    
+    // What it does: Starts the slot over for a new run: the next save replaces the journal with the new run's checkpoints
+    // instead of appending to it (the previous run's save file and journal stay intact until then)
+    // Inputs: None
+    // Outputs: None
+    void startOver();
+    
+    // What it does: Waits until every save submitted so far is written (call before reading, deleting or leaving the slot)
+    // Inputs: None
+    // Outputs: Returns false if a save failed to write since the last failure was reported, true otherwise
+    bool flush();
+    
+    // What it does: Returns number of saves submitted
+    // Inputs: None
+    // Outputs: Submitted count (uint64_t)
+    uint64_t getSubmittedCount() const;
+    
+    // What it does: Returns number of times the writer wrote the slot (several submitted saves coalesce into one write)
+    // Inputs: None
+    // Outputs: Write count (uint64_t)
+    uint64_t getWrittenCount() const;
+    
+    // What it does: Returns the stalls the game threads of the process have had in submit and flush so far
+    // (a hand-off that does not wait costs one relaxed atomic add; only waits read the clock)
+    // Inputs: None
+    // Outputs: Hand-off and wait counts, 99th percentile and maximum wait (AutosaveStallStats, all zero if nothing was saved)
+    static AutosaveStallStats getStallStats();
+};
+
+#endif
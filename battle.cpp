@@ -1,76 +1,152 @@
 #include "battle.h"
-#include <iostream>
-#include <cstdlib>
-#include <ctime>
-#include <limits>
-#include <algorithm>
+#include "metrics.h"
+#include <utility>
 using namespace std;
 
-Battle::Battle(Player* player, PotionManager* potionManager,
+namespace {
+    // What it does: Returns the enemy pool capacity of a battle created with a number of enemies
+    // Inputs: enemyCount - number of enemies the battle starts with
+    // Outputs: Capacity between Battle::MAX_ENEMIES and Battle::MAX_HORDE_ENEMIES
+    int hordeCapacity(int enemyCount) {
+        if (enemyCount < Battle::MAX_ENEMIES) return Battle::MAX_ENEMIES;
+        if (enemyCount > Battle::MAX_HORDE_ENEMIES) return Battle::MAX_HORDE_ENEMIES;
+        return enemyCount;
+    }
+}
+
+template <EnemyType Type>
+void Battle::enemyAct(int enemyIndex) {
+    if (EnemyKind<Type>::Summoner::value) {
+        bossAction(enemyIndex);
+    } else {
+        enemyAttack(enemyIndex);
+    }
+}
+
+// Table of Battle::enemyAct instantiations, one per entry of ENEMY_TRAITS
+// (Sequence is std::make_index_sequence<ENEMY_TYPE_COUNT>)
+template <typename Sequence>
+struct EnemyActionTable;
+
+template <size_t... Types>
+struct EnemyActionTable<index_sequence<Types...>> {
+    typedef void (Battle::*Action)(int);
+    
+    // What it does: Returns the action of an enemy type
+    // Inputs: type - enemy type
+    // Outputs: Member function acting for that type
+    static Action get(EnemyType type) {
+        static const Action actions[] = {&Battle::enemyAct<(EnemyType)Types>...};
+        return actions[(int)type];
+    }
+};
+
+Battle::Battle(Player* player, PotionManager* potionManager, Random* rng,
                const vector<string>& enemyTypes, bool playerFirst,
                bool enemyDoubleHP, const string& disabledEquip)
-    : player(player), potionManager(potionManager), 
-      playerTurnFirst(playerFirst), turnCount(0) {
+    : player(player), potionManager(potionManager), rng(rng), 
+      enemies(MAX_ENEMIES, arena), playerTurnFirst(playerFirst), turnCount(0), actionsLeft(0),
+      turnHeapAllocations(0), policy(nullptr), sink(nullptr) {
     
-    for (const auto& type : enemyTypes) {
-        if (type == "Slim") {
-            enemies.push_back(make_unique<Slim>());
-        } else if (type == "Batho") {
-            enemies.push_back(make_unique<Batho>());
-        } else if (type == "Goust") {
-            enemies.push_back(make_unique<Goust>());
-        } else if (type == "Boss") {
-            enemies.push_back(make_unique<Boss>());
+    for (const auto& name : enemyTypes) {
+        EnemyType type;
+        if (parseEnemyType(name, type)) {
+            enemies.add(type);
         }
     }
     
-    while (enemies.size() > 3) {
-        enemies.pop_back();
+    if (enemyDoubleHP) {
+        enemies.doubleHealth();
+    }
+    
+    player->setDisabledEquipment(disabledEquip);
+}
+
+Battle::Battle(Player* player, PotionManager* potionManager, Random* rng, const Level& level, bool playerFirst,
+               bool enemyDoubleHP, const string& disabledEquip)
+    : player(player), potionManager(potionManager), rng(rng), 
+      enemies(MAX_ENEMIES, arena), playerTurnFirst(playerFirst), turnCount(0), actionsLeft(0),
+      turnHeapAllocations(0), policy(nullptr), sink(nullptr) {
+    
+    for (int i = 0; i < level.getEnemyCount(); i++) {
+        enemies.add(level.getEnemyType(i));
     }
     
     if (enemyDoubleHP) {
-        for (auto& enemy : enemies) {
-            enemy->doubleHealth();
-        }
+        enemies.doubleHealth();
     }
     
     player->setDisabledEquipment(disabledEquip);
 }
 
+Battle::Battle(Player* player, PotionManager* potionManager, Random* rng, const EnemyType* enemyTypes, int enemyCount,
+               bool playerFirst, bool enemyDoubleHP, const string& disabledEquip)
+    : player(player), potionManager(potionManager), rng(rng),
+      enemies(hordeCapacity(enemyCount), arena), playerTurnFirst(playerFirst),
+      turnCount(0), actionsLeft(0), turnHeapAllocations(0), policy(nullptr), sink(nullptr) {
+    
+    for (int i = 0; i < enemyCount; i++) {
+        enemies.add(enemyTypes[i]);
+    }
+    
+    if (enemyDoubleHP) {
+        enemies.doubleHealth();
+    }
+    
+    player->setDisabledEquipment(disabledEquip);
+}
+
+Battle::Battle(const Battle& source, Player* player, PotionManager* potionManager, Random* rng)
+    : player(player), potionManager(potionManager), rng(rng), enemies(source.enemies, arena),
+      playerTurnFirst(source.playerTurnFirst), turnCount(source.turnCount), actionsLeft(source.actionsLeft),
+      turnHeapAllocations(0), policy(nullptr), sink(nullptr) {
+}
+
 Battle::~Battle() {
 }
 
-void Battle::displayStatus() const {
-    cout << "\n=== Battle Status ===" << endl;
-    cout << "Player HP: " << player->getCurrentHealth() << "/" << player->getMaxHealth() << endl;
-    cout << "Turn: " << turnCount << endl;
-    cout << "\nEnemies:" << endl;
-    for (size_t i = 0; i < enemies.size(); i++) {
-        if (enemies[i]->isAlive()) {
-            cout << "  " << (i + 1) << ". " << enemies[i]->getName() 
-                 << " HP: " << enemies[i]->getCurrentHealth() << "/" 
-                 << enemies[i]->getMaxHealth() << endl;
-        }
+void Battle::emit(BattleEventType type, int enemyIndex, int amount, const string& name) const {
+    if (sink) {
+        BattleEvent event = {type, enemyIndex, amount, name};
+        sink->onEvent(*this, event);
     }
-    cout << "====================\n" << endl;
 }
 
-bool Battle::execute() {
+bool Battle::execute(BattlePolicy& policy, BattleEventSink* sink) {
+    this->policy = &policy;
+    this->sink = sink;
+    
     player->restoreToFull();
-    int shoesCount = 0;
-    if (player->getDisabledEquipment() != "Shoes") {
-        shoesCount = player->countEquipment("Shoes");
-    }
-    player->setExtraActions(shoesCount);
+    player->setExtraActions(player->getDerivedStats().extraActions);
     
-    cout << "\n=== BATTLE BEGINS ===" << endl;
-    displayStatus();
+    emit(BattleEventType::Start);
+    emit(BattleEventType::Status);
     
-    while (!isWon() && !isLost()) {
-        turnCount++;
+    uint64_t allocations = getHeapAllocationCount();
+    bool won = runTurns(false);
+    turnHeapAllocations += getHeapAllocationCount() - allocations;
+    METRIC_BATTLE_TURNS(turnCount);
+    return won;
+}
+
+bool Battle::resume(BattlePolicy& policy) {
+    this->policy = &policy;
+    this->sink = nullptr;
+    uint64_t allocations = getHeapAllocationCount();
+    bool won = runTurns(true);
+    turnHeapAllocations += getHeapAllocationCount() - allocations;
+    return won;
+}
+
+bool Battle::runTurns(bool midTurn) {
+    while (midTurn || (!isWon() && !isLost())) {
+        METRIC_TIME(MetricPhase::BattleTurn);
+        if (!midTurn) {
+            turnCount++;
+        }
         
         if (playerTurnFirst) {
-            if (!playerTurn()) {
+            if (!playerTurn(midTurn)) {
                 return false;
             }
             removeDeadEnemies();
@@ -79,72 +155,57 @@ bool Battle::execute() {
             enemyTurn();
             removeDeadEnemies();
         } else {
-            enemyTurn();
-            removeDeadEnemies();
-            if (isWon()) break;
+            if (!midTurn) {
+                enemyTurn();
+                removeDeadEnemies();
+                if (isWon()) break;
+            }
             
-            if (!playerTurn()) {
+            if (!playerTurn(midTurn)) {
                 return false;
             }
             removeDeadEnemies();
         }
+        midTurn = false;
         
-        displayStatus();
+        emit(BattleEventType::Status);
     }
     
-    player->setDisabledEquipment("");
+    player->setDisabledEquipment(EquipmentType::None);
     
     if (isWon()) {
-        cout << "\n=== VICTORY! ===" << endl;
+        emit(BattleEventType::Victory);
         return true;
     } else {
-        cout << "\n=== DEFEAT ===" << endl;
+        emit(BattleEventType::Defeat);
         return false;
     }
 }
 
-bool Battle::playerTurn() {
-    int actions = 1 + player->getExtraActions();
+bool Battle::playerTurn(bool resumeTurn) {
+    int actions = resumeTurn ? actionsLeft : 1 + player->getExtraActions();
     player->setExtraActions(0);
     
     for (int actionNum = 0; actionNum < actions; actionNum++) {
         if (isWon() || isLost()) break;
         
-        cout << "\n--- Player Turn ---" << endl;
-        cout << "Choose action:" << endl;
-        cout << "1. Attack" << endl;
-        cout << "2. Use Potion" << endl;
-        cout << "3. Skip" << endl;
-        
-        int choice;
-        cin >> choice;
+        actionsLeft = actions - actionNum;
+        emit(BattleEventType::PlayerTurn);
         
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Invalid input. Please enter a number." << endl;
-            actionNum--;
-            continue;
-        }
-        
-        switch (choice) {
-            case 1:
+        switch (policy->chooseAction(*this)) {
+            case BattleAction::Attack:
                 playerAttack();
                 break;
-            case 2:
+            case BattleAction::UsePotion:
                 playerUsePotion();
                 break;
-            case 3:
-                cout << "You skip your turn." << endl;
+            case BattleAction::Skip:
+                emit(BattleEventType::Skip);
                 break;
-            default:
-                cout << "Invalid choice. Try again." << endl;
-                actionNum--;
-                continue;
         }
         
         if (actions > 1 && actionNum < actions - 1) {
-            cout << "You have " << (actions - actionNum - 1) << " more action(s)." << endl;
+            emit(BattleEventType::ActionsRemaining, -1, actions - actionNum - 1);
         }
     }
     
@@ -152,195 +213,202 @@ bool Battle::playerTurn() {
 }
 
 void Battle::playerAttack() {
-    if (enemies.empty()) return;
-    
-    vector<int> aliveIndices;
-    for (size_t i = 0; i < enemies.size(); i++) {
-        if (enemies[i]->isAlive()) {
-            aliveIndices.push_back(i);
-        }
-    }
+    if (enemies.size() == 0) return;
     
-    if (aliveIndices.empty()) return;
+    int aliveCount = enemies.countAlive();
+    if (aliveCount == 0) return;
     
-    int targetIndex;
-    if (aliveIndices.size() == 1) {
-        targetIndex = aliveIndices[0];
+    int targetIndex = -1;
+    if (aliveCount == 1) {
+        targetIndex = enemies.findAlive(0);
     } else {
-        cout << "Select target:" << endl;
-        for (size_t i = 0; i < aliveIndices.size(); i++) {
-            int idx = aliveIndices[i];
-            cout << (i + 1) << ". " << enemies[idx]->getName() 
-                 << " (HP: " << enemies[idx]->getCurrentHealth() << ")" << endl;
-        }
-        
-        int choice;
-        cin >> choice;
-        if (cin.fail() || choice < 1 || choice > (int)aliveIndices.size()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Invalid choice. Attack cancelled." << endl;
+        targetIndex = policy->chooseTarget(*this);
+        if (targetIndex < 0 || targetIndex >= enemies.size() || !enemies.isAlive(targetIndex)) {
+            emit(BattleEventType::AttackCancelled);
             return;
         }
-        targetIndex = aliveIndices[choice - 1];
     }
     
     int damage = player->getAttack();
-    enemies[targetIndex]->takeDamage(damage);
-    cout << "You attack " << enemies[targetIndex]->getName() 
-         << " for " << damage << " damage!" << endl;
+    enemies.takeDamage(targetIndex, damage);
+    emit(BattleEventType::PlayerAttack, targetIndex, damage, enemies.getName(targetIndex));
     
-    if (!enemies[targetIndex]->isAlive()) {
-        cout << enemies[targetIndex]->getName() << " is defeated!" << endl;
+    if (!enemies.isAlive(targetIndex)) {
+        emit(BattleEventType::EnemyDefeated, targetIndex, 0, enemies.getName(targetIndex));
     }
 }
 
 void Battle::playerUsePotion() {
-    auto allPotions = potionManager->getAllPotions();
-    if (allPotions.empty()) {
-        cout << "You have no potions!" << endl;
+    if (potionManager->isEmpty()) {
+        emit(BattleEventType::NoPotions);
         return;
     }
     
-    cout << "Available potions:" << endl;
-    vector<string> potionList;
-    int index = 1;
-    for (const auto& pair : allPotions) {
-        if (pair.second > 0) {
-            cout << index << ". " << pair.first << " x" << pair.second << endl;
-            potionList.push_back(pair.first);
-            index++;
-        }
-    }
-    
-    int choice;
-    cin >> choice;
-    if (cin.fail() || choice < 1 || choice > (int)potionList.size()) {
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        cout << "Invalid choice. Potion use cancelled." << endl;
+    string potionName = policy->choosePotion(*this, *potionManager);
+    if (potionName.empty()) {
+        emit(BattleEventType::PotionCancelled);
         return;
     }
     
-    string potionName = potionList[choice - 1];
-    if (!potionManager->usePotion(potionName)) {
-        cout << "Cannot use potion!" << endl;
+    PotionType type = parsePotionType(potionName);
+    if (!potionManager->usePotion(type)) {
+        emit(BattleEventType::PotionFailed, -1, 0, potionName);
         return;
     }
     
-    if (potionName == "Strength Potion") {
-        player->increaseMaxHealth(20);
-        player->heal(20);
-        cout << "You used Strength Potion! Max HP +20, Current HP +20" << endl;
-    } else if (potionName == "Attacker Potion") {
-        player->increaseAttack(5);
-        cout << "You used Attacker Potion! Attack +5" << endl;
-    } else if (potionName == "Life Potion") {
-        player->heal(50);
-        cout << "You used Life Potion! HP +50" << endl;
-    } else if (potionName == "Mystery Potion") {
-        player->increaseMaxHealth(40);
-        player->heal(40);
-        player->increaseAttack(10);
-        cout << "You used Mystery Potion! Max HP +40, Current HP +40, Attack +10" << endl;
+    const PotionTraits& effect = getPotionTraits(type);
+    if (effect.maxHealth > 0) {
+        player->increaseMaxHealth(effect.maxHealth);
+    }
+    if (effect.heal > 0) {
+        player->heal(effect.heal);
+    }
+    if (effect.attack > 0) {
+        player->increaseAttack(effect.attack);
     }
+    emit(BattleEventType::PotionUsed, -1, 0, potionName);
 }
 
 void Battle::enemyTurn() {
-    cout << "\n--- Enemy Turn ---" << endl;
+    METRIC_TIME(MetricPhase::EnemyTurn);
+    emit(BattleEventType::EnemyTurn);
     
-    for (auto& enemy : enemies) {
-        if (!enemy->isAlive() || !player->isAlive()) continue;
-        
-        if (enemy->getType() == "Boss") {
-            bossAction(enemy.get());
-        } else {
-            int damage = enemy->getAttack();
-            player->takeDamage(damage);
-            cout << enemy->getName() << " attacks you for " << damage << " damage!" << endl;
+    int enemyCount = enemies.size();
+    if (sink) {
+        for (int i = 0; i < enemyCount; i++) {
+            if (!enemies.isAlive(i) || !player->isAlive()) continue;
+            
+            (this->*EnemyActionTable<make_index_sequence<ENEMY_TYPE_COUNT>>::get(enemies.getType(i)))(i);
         }
-    }
-}
-
-void Battle::bossAction(Enemy* boss) {
-    static bool initialized = false;
-    if (!initialized) {
-        srand(static_cast<unsigned int>(time(nullptr)));
-        initialized = true;
+        return;
     }
     
-    int aliveCount = 0;
-    for (const auto& e : enemies) {
-        if (e->isAlive()) aliveCount++;
+    double damageMultiplier = player->getDerivedStats().damageMultiplier;
+    int begin = 0;
+    if (enemies.getBossCount() > 0) {
+        for (int i = 0; i < enemyCount; i++) {
+            if (!isEnemySummoner(enemies.getType(i))) continue;
+            player->loseHealth(enemies.sumAttackDamage(begin, i, damageMultiplier));
+            if (enemies.isAlive(i) && player->isAlive()) {
+                bossAction(i);
+            }
+            begin = i + 1;
+        }
     }
+    player->loseHealth(enemies.sumAttackDamage(begin, enemyCount, damageMultiplier));
+}
+
+void Battle::enemyAttack(int enemyIndex) {
+    int damage = enemies.getAttack(enemyIndex);
+    player->takeDamage(damage);
+    emit(BattleEventType::EnemyAttack, enemyIndex, damage, enemies.getName(enemyIndex));
+}
+
+void Battle::bossAction(int bossIndex) {
+    METRIC_TIME(MetricPhase::BossAction);
+    int aliveCount = enemies.countAlive();
     
     if (aliveCount >= 3) {
-        int damage = boss->getAttack();
-        player->takeDamage(damage);
-        cout << boss->getName() << " attacks you for " << damage << " damage!" << endl;
+        enemyAttack(bossIndex);
     } else if (aliveCount == 2) {
-        int roll = rand() % 2;
+        int roll = rng->nextInt(2);
         if (roll == 0) {
-            int damage = boss->getAttack();
-            player->takeDamage(damage);
-            cout << boss->getName() << " attacks you for " << damage << " damage!" << endl;
+            enemyAttack(bossIndex);
         } else {
-            if (enemies.size() < 3) {
-                enemies.push_back(make_unique<Goust>());
-                cout << boss->getName() << " summons a Goust!" << endl;
+            if (enemies.add(EnemyType::Goust)) {
+                emit(BattleEventType::Summon, bossIndex, 1, "Goust");
             } else {
-                int damage = boss->getAttack();
-                player->takeDamage(damage);
-                cout << boss->getName() << " attacks you for " << damage << " damage!" << endl;
+                enemyAttack(bossIndex);
             }
         }
     } else {
-        int roll = rand() % 100;
+        int roll = rng->nextInt(100);
         if (roll < 34) {
-            int damage = boss->getAttack();
-            player->takeDamage(damage);
-            cout << boss->getName() << " attacks you for " << damage << " damage!" << endl;
+            enemyAttack(bossIndex);
         } else if (roll < 67) {
-            int canAdd = 3 - enemies.size();
+            int canAdd = enemies.getCapacity() - enemies.size();
             int toAdd = (canAdd > 2) ? 2 : canAdd;
             for (int i = 0; i < toAdd; i++) {
-                enemies.push_back(make_unique<Batho>());
+                enemies.add(EnemyType::Batho);
             }
-            cout << boss->getName() << " summons " << toAdd << " Batho(s)!" << endl;
+            emit(BattleEventType::Summon, bossIndex, toAdd, "Batho");
         } else {
-            if (enemies.size() < 3) {
-                enemies.push_back(make_unique<Goust>());
-                cout << boss->getName() << " summons a Goust!" << endl;
+            if (enemies.add(EnemyType::Goust)) {
+                emit(BattleEventType::Summon, bossIndex, 1, "Goust");
             } else {
-                int damage = boss->getAttack();
-                player->takeDamage(damage);
-                cout << boss->getName() << " attacks you for " << damage << " damage!" << endl;
+                enemyAttack(bossIndex);
             }
         }
     }
 }
 
 void Battle::removeDeadEnemies() {
-    enemies.erase(
-        remove_if(enemies.begin(), enemies.end(),
-            [](const unique_ptr<Enemy>& e) { return !e->isAlive(); }),
-        enemies.end()
-    );
+    enemies.removeDead();
 }
 
 bool Battle::isWon() const {
-    for (const auto& enemy : enemies) {
-        if (enemy->isAlive()) {
-            return false;
-        }
-    }
-    return true;
+    return !enemies.anyAlive();
 }
 
 bool Battle::isLost() const {
     return !player->isAlive() || turnCount > 50;
 }
 
+bool Battle::saveSnapshot(BattleSnapshot& snapshot) const {
+    int enemyCount = enemies.saveSnapshot(snapshot.enemies, MAX_ENEMIES);
+    if (enemyCount < 0) {
+        return false;
+    }
+    player->saveSnapshot(snapshot.player);
+    potionManager->saveSnapshot(snapshot.potions);
+    for (int i = 0; i < 4; i++) {
+        snapshot.random[i] = rng->getState(i);
+    }
+    snapshot.enemyCount = enemyCount;
+    snapshot.turnCount = turnCount;
+    snapshot.actionsLeft = actionsLeft;
+    snapshot.playerTurnFirst = playerTurnFirst;
+    return true;
+}
+
+void Battle::restoreSnapshot(const BattleSnapshot& snapshot, bool restoreRandom) {
+    player->restoreSnapshot(snapshot.player);
+    potionManager->restoreSnapshot(snapshot.potions);
+    if (restoreRandom) {
+        for (int i = 0; i < 4; i++) {
+            rng->setState(i, snapshot.random[i]);
+        }
+    }
+    enemies.restoreSnapshot(snapshot.enemies, snapshot.enemyCount);
+    turnCount = snapshot.turnCount;
+    actionsLeft = snapshot.actionsLeft;
+    playerTurnFirst = snapshot.playerTurnFirst != 0;
+}
+
 int Battle::getTurnCount() const {
     return turnCount;
 }
+
+int Battle::getActionsLeft() const {
+    return actionsLeft;
+}
+
+const Player& Battle::getPlayer() const {
+    return *player;
+}
+
+const PotionManager& Battle::getPotionManager() const {
+    return *potionManager;
+}
+
+uint64_t Battle::getTurnHeapAllocations() const {
+    return turnHeapAllocations;
+}
+
+const EnemyPool& Battle::getEnemies() const {
+    return enemies;
+}
+
+int Battle::getAliveEnemyCount() const {
+    return enemies.countAlive();
+}
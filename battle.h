@@ -2,48 +2,163 @@
 #define BATTLE_H
 
 #include "player.h"
-#include "enemy.h"
+#include "enemypool.h"
 #include "potion.h"
+#include "rng.h"
+#include "level.h"
 #include <vector>
-#include <memory>
+#include <string>
+#include <type_traits>
+
+class Battle;
+struct BattleSnapshot;
+
+// Bytes of the arena every battle keeps inline for its battle-scoped objects (the enemy pool);
+// enough for Battle::MAX_ENEMIES with room to spare, so battles never need heap blocks (a horde
+// battle allocates its larger pool once, when it is created)
+const size_t BATTLE_ARENA_SIZE = 256;
+
+// Actions a player can take on each action of their turn (values match the battle menu)
+enum class BattleAction {
+    Attack = 1,
+    UsePotion = 2,
+    Skip = 3
+};
+
+// Kinds of results the battle engine reports to an event sink
+enum class BattleEventType {
+    Start,
+    Status,
+    PlayerTurn,
+    PlayerAttack,
+    EnemyDefeated,
+    AttackCancelled,
+    NoPotions,
+    PotionCancelled,
+    PotionFailed,
+    PotionUsed,
+    Skip,
+    ActionsRemaining,
+    EnemyTurn,
+    EnemyAttack,
+    Summon,
+    Victory,
+    Defeat
+};
+
+// One result reported by the battle engine
+// enemyIndex - index of the enemy involved (-1 if none), amount - damage dealt, enemies summoned
+// or actions remaining, name - enemy type or potion name involved (empty if none)
+struct BattleEvent {
+    BattleEventType type;
+    int enemyIndex;
+    int amount;
+    std::string name;
+};
+
+// Source of player decisions during a battle (console input, scripted or automatic players)
+class BattlePolicy {
+public:
+    // What it does: Cleans up policy resources
+    // Inputs: None
+    // Outputs: None
+    virtual ~BattlePolicy() {}
+    
+    // What it does: Chooses the next player action
+    // Inputs: battle - battle being played
+    // Outputs: Chosen action
+    virtual BattleAction chooseAction(const Battle& battle) = 0;
+    
+    // What it does: Chooses which enemy to attack (only asked when more than one enemy is alive)
+    // Inputs: battle - battle being played
+    // Outputs: Index of an alive enemy, or -1 to cancel the attack
+    virtual int chooseTarget(const Battle& battle) = 0;
+    
+    // What it does: Chooses which potion to drink (only asked when the player owns a potion)
+    // Inputs: battle - battle being played, potions - player's potion inventory
+    // Outputs: Name of the potion to use, or empty string to cancel
+    virtual std::string choosePotion(const Battle& battle, const PotionManager& potions) = 0;
+};
+
+// Optional receiver of battle results (console output, logs, statistics)
+class BattleEventSink {
+public:
+    // What it does: Cleans up sink resources
+    // Inputs: None
+    // Outputs: None
+    virtual ~BattleEventSink() {}
+    
+    // What it does: Receives one battle result
+    // Inputs: battle - battle being played, event - result that happened
+    // Outputs: None
+    virtual void onEvent(const Battle& battle, const BattleEvent& event) = 0;
+};
 
 class Battle {
 private:
     Player* player;
     PotionManager* potionManager;
-    std::vector<std::unique_ptr<Enemy>> enemies;
+    Random* rng;
+    InlineArena<BATTLE_ARENA_SIZE> arena;
+    EnemyPool enemies;
     bool playerTurnFirst;
     int turnCount;
+    int actionsLeft;
+    uint64_t turnHeapAllocations;
+    BattlePolicy* policy;
+    BattleEventSink* sink;
     
-    // What it does: Displays current battle status including player HP and all enemy HP
-    // Inputs: None
+    // What it does: Sends an event to the sink if one is attached
+    // Inputs: type - event type, enemyIndex - enemy involved (-1 if none), amount - event amount, name - name involved
     // Outputs: None
-    void displayStatus() const;
+    void emit(BattleEventType type, int enemyIndex = -1, int amount = 0, const std::string& name = "") const;
     
-    // What it does: Handles player's turn, allowing player to choose action (attack, use potion, or skip)
-    // Inputs: None
+    // What it does: Plays turns until the battle is won or lost
+    // Inputs: midTurn - true to start inside the player's turn at the pending action (see resume)
+    // Outputs: Returns true if player wins, false if player loses
+    bool runTurns(bool midTurn);
+    
+    // What it does: Handles player's turn, asking the policy for each action (attack, use potion, or skip)
+    // Inputs: resumeTurn - true to continue the current turn with the actions it has left instead of starting a new one
     // Outputs: Returns true if player wants to continue battle, false if they quit
-    bool playerTurn();
+    bool playerTurn(bool resumeTurn);
     
-    // What it does: Handles player attack action, allowing player to select target enemy
+    // What it does: Handles player attack action, asking the policy for a target when needed
     // Inputs: None
     // Outputs: None
     void playerAttack();
     
-    // What it does: Handles player potion usage, allowing player to select and use a potion
+    // What it does: Handles player potion usage, asking the policy which potion to use
     // Inputs: None
     // Outputs: None
     void playerUsePotion();
     
     // What it does: Handles enemy turn where all alive enemies attack the player
+    // (without a sink, normal enemy attacks are summed in one pass over the enemy pool)
     // Inputs: None
     // Outputs: None
     void enemyTurn();
     
+    // What it does: Lets one enemy act with the behavior its type has in ENEMY_TRAITS, emitting its events
+    // (one instantiation per type, picked through a table indexed by EnemyType; only used while a sink is attached,
+    // the sink-free enemy turn reads the same ENEMY_TRAITS flags through getSummonerMask)
+    // Inputs: enemyIndex - index of the acting enemy in the enemy pool
+    // Outputs: None
+    template <EnemyType Type>
+    void enemyAct(int enemyIndex);
+    
+    template <typename Sequence>
+    friend struct EnemyActionTable;
+    
     // What it does: Handles boss enemy special actions (attack or summon enemies)
-    // Inputs: boss - pointer to boss enemy
+    // Inputs: bossIndex - index of the boss in the enemy pool
+    // Outputs: None
+    void bossAction(int bossIndex);
+    
+    // What it does: Deals a normal enemy attack to the player
+    // Inputs: enemyIndex - index of the attacking enemy in the enemy pool
     // Outputs: None
-    void bossAction(Enemy* boss);
+    void enemyAttack(int enemyIndex);
     
     // What it does: Removes dead enemies from the battle
     // Inputs: None
@@ -61,27 +176,123 @@ private:
     bool isLost() const;
     
 public:
+    // Maximum number of enemies fighting at once (including summoned ones)
+    static const int MAX_ENEMIES = 3;
+    
+    // Maximum number of enemies of a horde battle
+    static const int MAX_HORDE_ENEMIES = 1 << 16;
+    
     // What it does: Initializes battle with enemies, sets turn order, and applies battle modifiers
-    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, enemyTypes - vector of enemy type strings to create, playerFirst - true if player acts first, enemyDoubleHP - true if enemies should have double HP, disabledEquip - name of disabled equipment (empty if none)
+    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, rng - random number generator of this session, enemyTypes - vector of enemy type strings to create, playerFirst - true if player acts first, enemyDoubleHP - true if enemies should have double HP, disabledEquip - name of disabled equipment (empty if none)
     // Outputs: None
-    Battle(Player* player, PotionManager* potionManager, 
+    Battle(Player* player, PotionManager* potionManager, Random* rng,
            const std::vector<std::string>& enemyTypes, bool playerFirst,
            bool enemyDoubleHP = false, const std::string& disabledEquip = "");
     
+    // What it does: Initializes battle with the enemies of a level (no enemy names are parsed), sets turn order, and applies battle modifiers
+    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, rng - random number generator of this session, level - battle level to fight, playerFirst - true if player acts first, enemyDoubleHP - true if enemies should have double HP, disabledEquip - name of disabled equipment (empty if none)
+    // Outputs: None
+    Battle(Player* player, PotionManager* potionManager, Random* rng, const Level& level, bool playerFirst,
+           bool enemyDoubleHP = false, const std::string& disabledEquip = "");
+    
+    // What it does: Initializes a battle with any number of enemies (a horde battle when there are more than MAX_ENEMIES),
+    // sets turn order, and applies battle modifiers. The enemy pool holds the larger of MAX_ENEMIES and the enemy count,
+    // so a boss only summons while fewer than MAX_ENEMIES enemies are left, as in normal battles.
+    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, rng - random number generator of this session,
+    //         enemyTypes - enemy type ids, enemyCount - number of enemies (at most MAX_HORDE_ENEMIES are kept), playerFirst - true if player acts first,
+    //         enemyDoubleHP - true if enemies should have double HP, disabledEquip - name of disabled equipment (empty if none)
+    // Outputs: None
+    Battle(Player* player, PotionManager* potionManager, Random* rng, const EnemyType* enemyTypes, int enemyCount,
+           bool playerFirst, bool enemyDoubleHP = false, const std::string& disabledEquip = "");
+    
+    // What it does: Copies a battle that is waiting for a player action, so it can be played on from there
+    // (used by search policies; the copy fights with its own player, potions and random number generator)
+    // Inputs: source - battle to copy, player - copy of the source's player, potionManager - copy of the source's potions, rng - random number generator for the copy
+    // Outputs: None
+    Battle(const Battle& source, Player* player, PotionManager* potionManager, Random* rng);
+    
+    Battle(const Battle&) = delete;
+    Battle& operator=(const Battle&) = delete;
+    
     // What it does: Cleans up battle resources
     // Inputs: None
     // Outputs: None
     ~Battle();
     
-    // What it does: Starts and executes the battle, managing turns until victory or defeat
-    // Inputs: None
+    // What it does: Runs the battle without any terminal I/O, managing turns until victory or defeat
+    // Inputs: policy - source of player decisions, sink - receiver of battle results (nullptr for none)
+    // Outputs: Returns true if player wins, false if player loses
+    bool execute(BattlePolicy& policy, BattleEventSink* sink = nullptr);
+    
+    // What it does: Continues a copied battle from the player action it was waiting for, without terminal I/O or events
+    // Inputs: policy - source of player decisions (asked for the pending action first)
     // Outputs: Returns true if player wins, false if player loses
-    bool execute();
+    bool resume(BattlePolicy& policy);
+    
+    // What it does: Copies the whole state of the battle (player, potions, random generator, enemies, turn) into a snapshot
+    // Inputs: snapshot - snapshot to fill
+    // Outputs: Returns false if the battle holds more than MAX_ENEMIES enemies (a horde battle; the snapshot is not filled,
+    //          so callers must check the result)
+    __attribute__((warn_unused_result)) bool saveSnapshot(BattleSnapshot& snapshot) const;
+    
+    // What it does: Puts the battle, its player and its potions back into the state of a snapshot in O(size of the
+    // snapshot) without heap allocation. A snapshot taken while the battle waited for a player action is played on with resume.
+    // Inputs: snapshot - snapshot taken with saveSnapshot (of this battle or one of its copies),
+    //         restoreRandom - false to keep the generator's current state (search policies explore different futures)
+    // Outputs: None
+    void restoreSnapshot(const BattleSnapshot& snapshot, bool restoreRandom = true);
     
     // What it does: Returns number of turns taken in battle
     // Inputs: None
     // Outputs: Turn count (int)
     int getTurnCount() const;
+    
+    // What it does: Returns number of player actions left in the current turn, including the one being chosen
+    // Inputs: None
+    // Outputs: Action count (int, more than 1 only on a turn with extra actions)
+    int getActionsLeft() const;
+    
+    // What it does: Returns number of heap allocations made while this battle played its turns (by the engine,
+    // the policy and the sink together); in steady state it is 0 when the policy and sink do not allocate.
+    // Only the bench build counts allocations (see getHeapAllocationCount), every other build reports 0
+    // Inputs: None
+    // Outputs: Allocation count (uint64_t)
+    uint64_t getTurnHeapAllocations() const;
+    
+    // What it does: Returns the player fighting in this battle
+    // Inputs: None
+    // Outputs: Reference to the player
+    const Player& getPlayer() const;
+    
+    // What it does: Returns the potion inventory used in this battle
+    // Inputs: None
+    // Outputs: Reference to the potion manager
+    const PotionManager& getPotionManager() const;
+    
+    // What it does: Returns the enemies currently in the battle (alive or just defeated)
+    // Inputs: None
+    // Outputs: Reference to the enemy pool
+    const EnemyPool& getEnemies() const;
+    
+    // What it does: Returns number of enemies still alive
+    // Inputs: None
+    // Outputs: Alive enemy count (int)
+    int getAliveEnemyCount() const;
 };
 
+// Complete state of a battle as plain values. It is trivially copyable, so forking a battle is a memcpy
+// of about a hundred bytes and snapshots can be kept in bulk (e.g. in a SnapshotHistory for undo).
+struct BattleSnapshot {
+    PlayerSnapshot player;
+    PotionSnapshot potions;
+    uint64_t random[4];
+    EnemySnapshot enemies[Battle::MAX_ENEMIES];
+    int32_t enemyCount;
+    int32_t turnCount;
+    int32_t actionsLeft;
+    uint8_t playerTurnFirst;
+};
+
+static_assert(std::is_trivially_copyable<BattleSnapshot>::value, "BattleSnapshot must stay trivially copyable");
+
 #endif
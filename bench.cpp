@@ -0,0 +1,658 @@
+#include "player.h"
+#include "potion.h"
+#include "battle.h"
+#include "level.h"
+#include "event.h"
+#include "save.h"
+#include "rng.h"
+#include "session.h"
+#include "snapshot.h"
+#include "policy.h"
+#include "autosave.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+using namespace std;
+
+// Version of the JSON result layout written by --json (version 1 files have no spread_pct and are still read)
+const int BENCH_FORMAT_VERSION = 2;
+
+// Enemies of the horde_battle benchmark
+const int HORDE_BENCH_SIZE = 10000;
+
+// Games kept in flight by the session_loop benchmark, all driven by the benchmark thread
+const int SESSION_BENCH_CONCURRENCY = 2000;
+
+// Choices every session_loop game gets before its input ends
+const int SESSION_BENCH_DECISIONS = 2000;
+
+// Name prefix of the benchmarks timed against the filesystem. Their times follow the disk (they change
+// severalfold between runs of the same code on a busy machine), so --compare reports them without gating on them.
+const char* const DISK_BENCH_PREFIX = "save_";
+
+// Timing of one microbenchmark
+struct BenchResult {
+    string name;
+    long long iterations;
+    double nsPerOp;
+    double spread;      // slowest repetition over the fastest one, in percent (0 for a single repetition)
+};
+
+// Games of the session_loop benchmark. They stay in flight across repetitions of the suite, since
+// starting them at staggered points takes far longer than measuring them.
+struct SessionPool {
+    vector<LocalSession*> sessions;
+    int next;
+};
+
+// Battle policy that plays a fixed script (attack, attack, attack, drink the first potion) so every
+// run of the battle benchmark makes the same decisions without any heuristics in the measurement
+class ScriptedBattlePolicy : public BattlePolicy {
+private:
+    int step;
+    
+public:
+    // What it does: Starts the script at its first action
+    // Inputs: None
+    // Outputs: None
+    ScriptedBattlePolicy() : step(0) {
+    }
+    
+    // What it does: Returns the next action of the script
+    // Inputs: battle - battle being played
+    // Outputs: Attack three times out of four, potion otherwise
+    BattleAction chooseAction(const Battle& battle) override {
+        (void)battle;
+        return (step++ % 4 == 3) ? BattleAction::UsePotion : BattleAction::Attack;
+    }
+    
+    // What it does: Targets the first alive enemy
+    // Inputs: battle - battle being played
+    // Outputs: Index of the enemy
+    int chooseTarget(const Battle& battle) override {
+        const EnemyPool& enemies = battle.getEnemies();
+        for (int i = 0; i < enemies.size(); i++) {
+            if (enemies.isAlive(i)) return i;
+        }
+        return -1;
+    }
+    
+    // What it does: Drinks the first potion in the inventory (in name order; the view does not copy the
+    // inventory, so the script makes no heap allocations)
+    // Inputs: battle - battle being played, potions - player's potion inventory
+    // Outputs: Name of the potion
+    string choosePotion(const Battle& battle, const PotionManager& potions) override {
+        (void)battle;
+        for (PotionStack stack : potions.getAllPotions()) {
+            return stack.name;
+        }
+        return "";
+    }
+};
+
+// What it does: Keeps the compiler from optimizing away a value computed by a benchmark
+// Inputs: value - value to keep
+// Outputs: None
+template <typename T>
+static inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// What it does: Times a benchmark body: doubles the batch size until one batch takes a tenth of the time budget,
+// then runs five batches and keeps the median time per operation
+// Inputs: name - benchmark name, body - function running a batch of n operations, minSeconds - time budget of the benchmark
+// Outputs: Timing result
+template <typename Body>
+static BenchResult measure(const string& name, Body body, double minSeconds) {
+    long long batch = 1;
+    while (true) {
+        auto start = chrono::steady_clock::now();
+        body(batch);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (seconds >= minSeconds / 10 || batch >= (1LL << 40)) break;
+        batch *= 2;
+    }
+    
+    vector<double> samples;
+    for (int i = 0; i < 5; i++) {
+        auto start = chrono::steady_clock::now();
+        body(batch);
+        samples.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / batch);
+    }
+    sort(samples.begin(), samples.end());
+    return {name, batch * 5, samples[2], 0};
+}
+
+// What it does: Ends every game of the session pool and deletes their save files
+// Inputs: pool - session pool (left empty), scratchDir - directory of the save files
+// Outputs: None
+static void closeSessionPool(SessionPool& pool, const string& scratchDir) {
+    for (size_t slot = 0; slot < pool.sessions.size(); slot++) {
+        delete pool.sessions[slot];
+        for (int saveSlot = 1; saveSlot <= SAVE_SLOT_COUNT; saveSlot++) {
+            SaveManager(scratchDir + "/session" + to_string(slot) + "_" + SaveManager::getSlotFileName(saveSlot)).deleteSave();
+        }
+    }
+    pool.sessions.clear();
+}
+
+// What it does: Runs every benchmark whose name contains the filter
+// Inputs: filter - name substring to select benchmarks (empty for all), minSeconds - time budget per benchmark, scratchDir - directory for save files,
+//         sessionPool - games of session_loop (started on first use, kept for the next run),
+//         battleAllocations - reference to store the heap allocations battle_execute made while playing turns (0 if it did not run)
+// Outputs: Results in run order
+static vector<BenchResult> runBenchmarks(const string& filter, double minSeconds, const string& scratchDir,
+                                         SessionPool& sessionPool, uint64_t& battleAllocations) {
+    vector<BenchResult> results;
+    battleAllocations = 0;
+    auto selected = [&](const string& name) {
+        return filter.empty() || name.find(filter) != string::npos;
+    };
+    
+    if (selected("player_get_attack")) {
+        Player player;
+        player.addEquipment("Sword");
+        player.addEquipment("Shield");
+        results.push_back(measure("player_get_attack", [&](long long n) {
+            int total = 0;
+            for (long long i = 0; i < n; i++) {
+                keep(player);
+                total += player.getAttack();
+            }
+            keep(total);
+        }, minSeconds));
+    }
+    
+    if (selected("player_take_damage")) {
+        Player player;
+        player.addEquipment("Shield");
+        player.addEquipment("Armor");
+        results.push_back(measure("player_take_damage", [&](long long n) {
+            for (long long i = 0; i < n; i++) {
+                player.takeDamage(7);
+                if (!player.isAlive()) {
+                    player.restoreToFull();
+                }
+            }
+            keep(player);
+        }, minSeconds));
+    }
+    
+    if (selected("battle_execute")) {
+        Level level = Level::createLevel(12);
+        vector<string> enemies = level.getEnemies();
+        Random rng(42);
+        results.push_back(measure("battle_execute", [&](long long n) {
+            for (long long i = 0; i < n; i++) {
+                Player player;
+                player.addEquipment("Sword");
+                player.addEquipment("Armor");
+                PotionManager potions;
+                potions.addPotion("Life Potion", 2);
+                potions.addPotion("Strength Potion", 1);
+                ScriptedBattlePolicy policy;
+                rng.seed(i);
+                Battle battle(&player, &potions, &rng, enemies, true);
+                bool won = battle.execute(policy, nullptr);
+                battleAllocations += battle.getTurnHeapAllocations();
+                keep(won);
+            }
+        }, minSeconds));
+    }
+    
+    if (selected("horde_battle")) {
+        // One operation is a whole horde battle under the automatic policy: a boss and HORDE_BENCH_SIZE - 1
+        // Slims, Bathos and Gousts against a player with enough HP to play every turn up to the limit
+        vector<EnemyType> horde(HORDE_BENCH_SIZE);
+        int hordeAttack = 0;
+        for (int i = 0; i < HORDE_BENCH_SIZE; i++) {
+            horde[i] = i == 0 ? EnemyType::Boss : (EnemyType)(i % 3);
+            hordeAttack += getEnemyTypeAttack(horde[i]);
+        }
+        AutoBattlePolicy policy;
+        Random rng(42);
+        results.push_back(measure("horde_battle", [&](long long n) {
+            for (long long i = 0; i < n; i++) {
+                Player player;
+                player.setBaseMaxHealth(hordeAttack * 51 + 100);
+                PotionManager potions;
+                rng.seed(i);
+                Battle battle(&player, &potions, &rng, horde.data(), HORDE_BENCH_SIZE, true);
+                bool won = battle.execute(policy, nullptr);
+                keep(won);
+            }
+        }, minSeconds));
+    }
+    
+    if (selected("battle_snapshot_fork")) {
+        // One operation forks a battle: snapshot it onto a branch of the history, then restore the branch's previous snapshot
+        Level level = Level::createLevel(12);
+        Random rng(3);
+        Player player;
+        player.addEquipment("Sword");
+        PotionManager potions;
+        potions.addPotion("Life Potion", 2);
+        potions.addPotion("Mystery Potion", 1);
+        Battle battle(&player, &potions, &rng, level, true);
+        SnapshotHistory<BattleSnapshot> history;
+        history.reserve(1024);
+        BattleSnapshot start;
+        bool saved = battle.saveSnapshot(start);
+        results.push_back(measure("battle_snapshot_fork", [&](long long n) {
+            SnapshotHistory<BattleSnapshot>::Branch branch = history.push(SnapshotHistory<BattleSnapshot>::EMPTY, start);
+            for (long long i = 0; i < n; i++) {
+                if (history.size() == 1024) {
+                    history.clear();
+                    branch = history.push(SnapshotHistory<BattleSnapshot>::EMPTY, start);
+                }
+                BattleSnapshot snapshot;
+                saved = battle.saveSnapshot(snapshot) && saved;
+                branch = history.push(branch, snapshot);
+                battle.restoreSnapshot(history.top(history.undo(branch)));
+            }
+            keep(battle);
+            history.clear();
+        }, minSeconds));
+        if (!saved) {
+            // A level battle always fits in a snapshot; a result built from unfilled snapshots would be meaningless
+            results.pop_back();
+            cout << "battle_snapshot_fork: the battle did not fit in a snapshot" << endl;
+        }
+    }
+    
+    if (selected("level_create_level")) {
+        results.push_back(measure("level_create_level", [&](long long n) {
+            size_t total = 0;
+            for (long long i = 0; i < n; i++) {
+                Level level = Level::createLevel((int)(i % Level::getTotalLevels()) + 1);
+                total += level.getEnemies().size();
+            }
+            keep(total);
+        }, minSeconds));
+    }
+    
+    if (selected("event_roll")) {
+        Random rng(11);
+        EventManager events(&rng, true);
+        results.push_back(measure("event_roll", [&](long long n) {
+            int total = 0;
+            for (long long i = 0; i < n; i++) {
+                total += (int)events.rollEvent();
+            }
+            keep(total);
+        }, minSeconds));
+    }
+    
+    if (selected("event_roll_batch")) {
+        Random rng(11);
+        EventManager events(&rng, true);
+        EventOutcome outcomes[256];
+        results.push_back(measure("event_roll_batch", [&](long long n) {
+            int total = 0;
+            for (long long done = 0; done < n; done += 256) {
+                int count = (int)min<long long>(256, n - done);
+                events.rollEvents(outcomes, count);
+                total += (int)outcomes[count - 1];
+            }
+            keep(total);
+        }, minSeconds));
+    }
+    
+    if (selected("potion_add_use")) {
+        PotionManager potions;
+        results.push_back(measure("potion_add_use", [&](long long n) {
+            int total = 0;
+            for (long long i = 0; i < n; i++) {
+                potions.addPotion("Life Potion", 2);
+                potions.usePotion("Life Potion");
+                total += potions.getQuantity("Life Potion");
+            }
+            keep(total);
+        }, minSeconds));
+    }
+    
+    if (selected("potion_random")) {
+        Random rng(7);
+        results.push_back(measure("potion_random", [&](long long n) {
+            size_t total = 0;
+            for (long long i = 0; i < n; i++) {
+                total += PotionManager::getRandomPotion(rng).size();
+            }
+            keep(total);
+        }, minSeconds));
+    }
+    
+    if (selected("session_loop")) {
+        // One operation is one finished game. Every game runs as a coroutine that suspends at each choice;
+        // the loop answers "1" to every prompt (new game, easy, slot 1, then every battle and shop choice)
+        // round-robin, so the result is how many whole sessions one core can serve. Games are started
+        // at staggered points, so sessions finish at a steady rate instead of in waves.
+        const string choice = "1\n";
+        vector<LocalSession*>& pool = sessionPool.sessions;
+        auto startSession = [&](int slot) {
+            pool[slot] = new LocalSession(Random::deriveSeed(17, slot), scratchDir + "/session" + to_string(slot) + "_");
+            pool[slot]->setDurableSaves(false);
+            pool[slot]->start();
+        };
+        auto step = [&](int slot) {
+            LocalSession* session = pool[slot];
+            if (session->getDecisions() > SESSION_BENCH_DECISIONS) {
+                session->hangUp();
+            } else {
+                session->send(choice);
+            }
+            if (session->isFinished()) {
+                delete session;
+                startSession(slot);
+                return true;
+            }
+            return false;
+        };
+        if (pool.empty()) {
+            pool.resize(SESSION_BENCH_CONCURRENCY);
+            sessionPool.next = 0;
+            for (int slot = 0; slot < SESSION_BENCH_CONCURRENCY; slot++) {
+                startSession(slot);
+                long long headStart = (long long)slot * SESSION_BENCH_DECISIONS / SESSION_BENCH_CONCURRENCY;
+                for (long long i = 0; i < headStart; i++) {
+                    step(slot);
+                }
+            }
+        }
+        
+        int& next = sessionPool.next;
+        results.push_back(measure("session_loop", [&](long long n) {
+            long long finished = 0;
+            while (finished < n) {
+                finished += step(next);
+                next = (next + 1) % SESSION_BENCH_CONCURRENCY;
+            }
+        }, minSeconds));
+    }
+    
+    Player player;
+    player.addEquipment("Sword");
+    player.addEquipment("Shoes");
+    player.addGold(3);
+    PotionManager potions;
+    potions.addPotion("Mystery Potion", 2);
+    potions.addPotion("Life Potion", 1);
+    
+    if (selected("save_round_trip")) {
+        SaveManager saveManager(scratchDir + "/" + SaveManager::getSlotFileName(1));
+        saveManager.setDurable(false);
+        results.push_back(measure("save_round_trip", [&](long long n) {
+            for (long long i = 0; i < n; i++) {
+                Player loadedPlayer;
+                PotionManager loadedPotions;
+                int level = 0;
+                int difficulty = 0;
+                saveManager.saveGame(&player, &potions, 5, 1);
+                bool loaded = saveManager.loadGame(&loadedPlayer, &loadedPotions, level, difficulty);
+                keep(loaded);
+            }
+        }, minSeconds));
+        saveManager.deleteSave();
+    }
+    
+    if (selected("save_checkpoint_append")) {
+        SaveManager saveManager(scratchDir + "/" + SaveManager::getSlotFileName(2));
+        saveManager.setDurable(false);
+        results.push_back(measure("save_checkpoint_append", [&](long long n) {
+            for (long long i = 0; i < n; i++) {
+                if (i % 1024 == 0) {
+                    saveManager.deleteSave();
+                }
+                bool ok = saveManager.appendCheckpoint(&player, &potions, (int)(i % 11) + 2, 0);
+                keep(ok);
+            }
+        }, minSeconds));
+        saveManager.deleteSave();
+    }
+    
+    if (selected("save_durable")) {
+        SaveManager saveManager(scratchDir + "/" + SaveManager::getSlotFileName(3));
+        results.push_back(measure("save_durable", [&](long long n) {
+            for (long long i = 0; i < n; i++) {
+                bool ok = saveManager.saveGame(&player, &potions, 5, 1);
+                keep(ok);
+            }
+        }, minSeconds));
+        saveManager.deleteSave();
+    }
+    
+    if (selected("autosave_level")) {
+        // One operation is the autosave after a level (durable save file plus a checkpoint), timed from the
+        // game thread only: the writer thread serializes and fsyncs in the background, and saves submitted
+        // faster than the disk takes them coalesce. autosave_level is the mean stall per save and
+        // autosave_level_p99 the 99th percentile; compare both with save_durable. Every 1024 saves the slot
+        // is flushed and deleted outside the timed calls, so the journal stays small.
+        SaveManager saveManager(scratchDir + "/" + SaveManager::getSlotFileName(3));
+        vector<double> stalls;
+        {
+            Autosave autosave(&saveManager);
+            auto benchStart = chrono::steady_clock::now();
+            while (chrono::duration<double>(chrono::steady_clock::now() - benchStart).count() < minSeconds) {
+                for (int i = 0; i < 1024; i++) {
+                    auto start = chrono::steady_clock::now();
+                    bool ok = autosave.submit(&player, &potions, i % 11 + 2, 1, true);
+                    stalls.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - start).count());
+                    keep(ok);
+                }
+                autosave.flush();
+                saveManager.deleteSave();
+            }
+        }
+        double total = 0;
+        for (double stall : stalls) {
+            total += stall;
+        }
+        sort(stalls.begin(), stalls.end());
+        results.push_back({"autosave_level", (long long)stalls.size(), total / stalls.size(), 0});
+        results.push_back({"autosave_level_p99", (long long)stalls.size(), stalls[stalls.size() * 99 / 100], 0});
+    }
+    
+    return results;
+}
+
+// What it does: Combines repetitions of the suite: every benchmark keeps its fastest repetition (the one least
+// disturbed by the rest of the system) and the spread between its fastest and slowest repetition
+// Inputs: runs - results of every repetition
+// Outputs: One result per benchmark, in the order of the first repetition that ran it
+static vector<BenchResult> combineRepetitions(const vector<vector<BenchResult>>& runs) {
+    vector<BenchResult> combined;
+    map<string, size_t> index;
+    map<string, double> slowest;
+    for (const auto& run : runs) {
+        for (const auto& result : run) {
+            auto it = index.find(result.name);
+            if (it == index.end()) {
+                index[result.name] = combined.size();
+                combined.push_back(result);
+                slowest[result.name] = result.nsPerOp;
+                continue;
+            }
+            BenchResult& best = combined[it->second];
+            best.iterations += result.iterations;
+            best.nsPerOp = min(best.nsPerOp, result.nsPerOp);
+            slowest[result.name] = max(slowest[result.name], result.nsPerOp);
+        }
+    }
+    for (auto& result : combined) {
+        result.spread = result.nsPerOp > 0 ? 100.0 * (slowest[result.name] - result.nsPerOp) / result.nsPerOp : 0;
+    }
+    return combined;
+}
+
+// What it does: Writes results as JSON ({"version": 2, "benchmarks": [{"name", "iterations", "ns_per_op", "spread_pct"}, ...]})
+// Inputs: results - benchmark results, fileName - file to write
+// Outputs: Returns true if the file was written, false otherwise
+static bool writeJson(const vector<BenchResult>& results, const string& fileName) {
+    ofstream file(fileName);
+    file << "{\n  \"version\": " << BENCH_FORMAT_VERSION << ",\n  \"benchmarks\": [\n";
+    file << setprecision(6);
+    for (size_t i = 0; i < results.size(); i++) {
+        file << "    {\"name\": \"" << results[i].name << "\", \"iterations\": " << results[i].iterations
+             << ", \"ns_per_op\": " << results[i].nsPerOp << ", \"spread_pct\": " << results[i].spread << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    file.close();
+    return !file.fail();
+}
+
+// What it does: Reads the time per operation and spread of every benchmark from a JSON file written by writeJson
+// Inputs: fileName - file to read, baseline - map to fill (benchmark name to its result)
+// Outputs: Returns true if the file could be read, false otherwise
+static bool readJson(const string& fileName, map<string, BenchResult>& baseline) {
+    ifstream file(fileName);
+    if (!file) return false;
+    stringstream contents;
+    contents << file.rdbuf();
+    string text = contents.str();
+    
+    const string nameKey = "\"name\": \"";
+    const string timeKey = "\"ns_per_op\": ";
+    const string spreadKey = "\"spread_pct\": ";
+    size_t pos = 0;
+    while ((pos = text.find(nameKey, pos)) != string::npos) {
+        size_t nameStart = pos + nameKey.size();
+        size_t nameEnd = text.find('"', nameStart);
+        size_t timePos = text.find(timeKey, nameEnd);
+        size_t entryEnd = text.find('}', nameEnd);
+        if (nameEnd == string::npos || timePos == string::npos || entryEnd == string::npos) return false;
+        size_t spreadPos = text.find(spreadKey, nameEnd);
+        
+        BenchResult& result = baseline[text.substr(nameStart, nameEnd - nameStart)];
+        result.nsPerOp = strtod(text.c_str() + timePos + timeKey.size(), nullptr);
+        result.spread = spreadPos < entryEnd ? strtod(text.c_str() + spreadPos + spreadKey.size(), nullptr) : 0;
+        pos = entryEnd;
+    }
+    return true;
+}
+
+// What it does: Prints command line usage of the benchmark suite
+// Inputs: program - name the program was started with
+// Outputs: None
+static void printUsage(const char* program) {
+    cout << "Usage: " << program << " [--filter NAME] [--min-time SECONDS] [--repetitions N] [--json FILE] [--compare BASELINE.json] [--threshold PERCENT]" << endl;
+}
+
+// What it does: Entry point of the microbenchmark suite. Times the hot paths of the game over several repetitions
+// of the whole suite, optionally writes the results as JSON and compares them with a stored baseline. A benchmark
+// regresses when its fastest repetition is slower than the baseline's by more than the threshold plus the larger
+// spread the two runs measured between their repetitions, so a rerun of unchanged code stays within its own noise.
+// Inputs: argc - argument count, argv - command line arguments
+// Outputs: Returns exit code (0 on success, 1 on bad arguments or I/O errors, 2 if a benchmark regressed,
+//          3 if battles allocated heap memory while playing turns)
+int main(int argc, char* argv[]) {
+    string filter;
+    double minSeconds = 0.2;
+    int repetitions = 5;
+    string jsonFile;
+    string baselineFile;
+    double threshold = 15.0;
+    
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && hasValue) {
+            minSeconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--repetitions") == 0 && hasValue) {
+            repetitions = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && hasValue) {
+            jsonFile = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && hasValue) {
+            baselineFile = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && hasValue) {
+            threshold = atof(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (repetitions < 1) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    map<string, BenchResult> baseline;
+    if (!baselineFile.empty() && !readJson(baselineFile, baseline)) {
+        cout << "Cannot read baseline " << baselineFile << endl;
+        return 1;
+    }
+    
+    char scratch[] = "/tmp/ftm-bench-XXXXXX";
+    if (!mkdtemp(scratch)) {
+        cout << "Failed to create scratch directory for save files!" << endl;
+        return 1;
+    }
+    // Whole-suite repetitions rather than more batches in a row, so a slow spell of the machine
+    // (another process, the autosave writer's fsyncs) lands in one repetition instead of a whole benchmark
+    uint64_t battleAllocations = 0;
+    SessionPool sessionPool;
+    vector<vector<BenchResult>> runs;
+    for (int i = 0; i < repetitions; i++) {
+        uint64_t allocations = 0;
+        runs.push_back(runBenchmarks(filter, minSeconds, scratch, sessionPool, allocations));
+        battleAllocations += allocations;
+    }
+    closeSessionPool(sessionPool, scratch);
+    vector<BenchResult> results = combineRepetitions(runs);
+    rmdir(scratch);
+    
+    int regressions = 0;
+    cout << fixed;
+    cout << left << setw(26) << "Benchmark" << right << setw(14) << "ns/op" << setw(16) << "ops/s" << setw(9) << "spread";
+    if (!baselineFile.empty()) {
+        cout << setw(14) << "baseline" << setw(10) << "change" << setw(9) << "limit";
+    }
+    cout << endl;
+    for (const auto& result : results) {
+        cout << left << setw(26) << result.name << right << setprecision(2) << setw(14) << result.nsPerOp
+             << setprecision(0) << setw(16) << 1e9 / result.nsPerOp << setprecision(1) << setw(8) << result.spread << "%";
+        if (!baselineFile.empty()) {
+            auto it = baseline.find(result.name);
+            if (it == baseline.end() || it->second.nsPerOp <= 0) {
+                cout << setw(14) << "-" << setw(10) << "new";
+            } else {
+                double change = 100.0 * (result.nsPerOp - it->second.nsPerOp) / it->second.nsPerOp;
+                double limit = threshold + max(result.spread, it->second.spread);
+                cout << setprecision(2) << setw(14) << it->second.nsPerOp << setprecision(1) << setw(9) << showpos << change
+                     << noshowpos << "%" << setw(8) << limit << "%";
+                if (result.name.compare(0, strlen(DISK_BENCH_PREFIX), DISK_BENCH_PREFIX) == 0) {
+                    cout << "  (disk, not gated)";
+                } else if (change > limit) {
+                    cout << "  REGRESSION";
+                    regressions++;
+                }
+            }
+        }
+        cout << endl;
+    }
+    
+    if (!jsonFile.empty() && !writeJson(results, jsonFile)) {
+        cout << "Failed to write " << jsonFile << endl;
+        return 1;
+    }
+    if (!baselineFile.empty()) {
+        cout << regressions << " regression(s) slower than the baseline by more than " << setprecision(1)
+             << threshold << "% plus the spread of the runs (fastest of " << repetitions << " repetition(s))" << endl;
+    }
+    if (battleAllocations > 0) {
+        cout << "battle_execute made " << battleAllocations << " heap allocation(s) while playing turns (expected 0)" << endl;
+        return 3;
+    }
+    return regressions == 0 ? 0 : 2;
+}
@@ -0,0 +1,187 @@
+#include "console.h"
+#include <iostream>
+using namespace std;
+
+namespace {
+    // What it does: Prints what drinking a potion did, built from its entry in POTION_TRAITS
+    // Inputs: out - stream to print to, potionName - name of the potion that was used
+    // Outputs: None
+    void printPotionEffect(ostream& out, const string& potionName) {
+        PotionType type = parsePotionType(potionName);
+        if (type == PotionType::None) {
+            return;
+        }
+        const PotionTraits& effect = getPotionTraits(type);
+        out << "You used " << effect.name << "!";
+        const char* separator = " ";
+        if (effect.maxHealth > 0) {
+            out << separator << "Max HP +" << effect.maxHealth << ", Current HP +" << effect.heal;
+            separator = ", ";
+        } else if (effect.heal > 0) {
+            out << separator << "HP +" << effect.heal;
+            separator = ", ";
+        }
+        if (effect.attack > 0) {
+            out << separator << "Attack +" << effect.attack;
+        }
+        out << '\n';
+    }
+}
+
+ConsoleBattlePolicy::ConsoleBattlePolicy(Renderer* renderer) : renderer(renderer) {
+}
+
+BattleAction ConsoleBattlePolicy::chooseAction(const Battle& battle) {
+    (void)battle;
+    while (true) {
+        renderer->out() << "Choose action:\n";
+        renderer->out() << "1. Attack\n";
+        renderer->out() << "2. Use Potion\n";
+        renderer->out() << "3. Skip\n";
+        
+        int choice;
+        if (!renderer->read(choice)) {
+            renderer->skipLine();
+            renderer->out() << "Invalid input. Please enter a number.\n";
+            continue;
+        }
+        
+        switch (choice) {
+            case 1:
+                return BattleAction::Attack;
+            case 2:
+                return BattleAction::UsePotion;
+            case 3:
+                return BattleAction::Skip;
+            default:
+                renderer->out() << "Invalid choice. Try again.\n";
+                break;
+        }
+    }
+}
+
+int ConsoleBattlePolicy::chooseTarget(const Battle& battle) {
+    const EnemyPool& enemies = battle.getEnemies();
+    vector<int> aliveIndices;
+    for (int i = 0; i < enemies.size(); i++) {
+        if (enemies.isAlive(i)) {
+            aliveIndices.push_back(i);
+        }
+    }
+    
+    renderer->out() << "Select target:\n";
+    for (size_t i = 0; i < aliveIndices.size(); i++) {
+        int idx = aliveIndices[i];
+        renderer->out() << (i + 1) << ". " << enemies.getName(idx) 
+                        << " (HP: " << enemies.getHealth(idx) << ")\n";
+    }
+    
+    int choice;
+    if (!renderer->read(choice) || choice < 1 || choice > (int)aliveIndices.size()) {
+        renderer->skipLine();
+        return -1;
+    }
+    return aliveIndices[choice - 1];
+}
+
+string ConsoleBattlePolicy::choosePotion(const Battle& battle, const PotionManager& potions) {
+    (void)battle;
+    renderer->out() << "Available potions:\n";
+    const char* potionList[POTION_TYPE_COUNT];
+    int index = 1;
+    for (PotionStack stack : potions.getAllPotions()) {
+        renderer->out() << index << ". " << stack.name << " x" << stack.quantity << '\n';
+        potionList[index - 1] = stack.name;
+        index++;
+    }
+    
+    int choice;
+    if (!renderer->read(choice) || choice < 1 || choice >= index) {
+        renderer->skipLine();
+        return "";
+    }
+    return potionList[choice - 1];
+}
+
+ConsoleBattleSink::ConsoleBattleSink(Renderer* renderer) : renderer(renderer) {
+}
+
+void ConsoleBattleSink::displayStatus(const Battle& battle) const {
+    const Player& player = battle.getPlayer();
+    const EnemyPool& enemies = battle.getEnemies();
+    renderer->out() << "\n=== Battle Status ===\n";
+    renderer->out() << "Player HP: " << player.getCurrentHealth() << "/" << player.getMaxHealth() << '\n';
+    renderer->out() << "Turn: " << battle.getTurnCount() << '\n';
+    renderer->out() << "\nEnemies:\n";
+    for (int i = 0; i < enemies.size(); i++) {
+        if (enemies.isAlive(i)) {
+            renderer->out() << "  " << (i + 1) << ". " << enemies.getName(i) 
+                            << " HP: " << enemies.getHealth(i) << "/" 
+                            << enemies.getMaxHealth(i) << '\n';
+        }
+    }
+    renderer->out() << "====================\n\n";
+}
+
+void ConsoleBattleSink::onEvent(const Battle& battle, const BattleEvent& event) {
+    if (renderer->isQuiet()) return;
+    
+    switch (event.type) {
+        case BattleEventType::Start:
+            renderer->out() << "\n=== BATTLE BEGINS ===\n";
+            break;
+        case BattleEventType::Status:
+            displayStatus(battle);
+            break;
+        case BattleEventType::PlayerTurn:
+            renderer->out() << "\n--- Player Turn ---\n";
+            break;
+        case BattleEventType::PlayerAttack:
+            renderer->out() << "You attack " << event.name << " for " << event.amount << " damage!\n";
+            break;
+        case BattleEventType::EnemyDefeated:
+            renderer->out() << event.name << " is defeated!\n";
+            break;
+        case BattleEventType::AttackCancelled:
+            renderer->out() << "Invalid choice. Attack cancelled.\n";
+            break;
+        case BattleEventType::NoPotions:
+            renderer->out() << "You have no potions!\n";
+            break;
+        case BattleEventType::PotionCancelled:
+            renderer->out() << "Invalid choice. Potion use cancelled.\n";
+            break;
+        case BattleEventType::PotionFailed:
+            renderer->out() << "Cannot use potion!\n";
+            break;
+        case BattleEventType::PotionUsed:
+            printPotionEffect(renderer->out(), event.name);
+            break;
+        case BattleEventType::Skip:
+            renderer->out() << "You skip your turn.\n";
+            break;
+        case BattleEventType::ActionsRemaining:
+            renderer->out() << "You have " << event.amount << " more action(s).\n";
+            break;
+        case BattleEventType::EnemyTurn:
+            renderer->out() << "\n--- Enemy Turn ---\n";
+            break;
+        case BattleEventType::EnemyAttack:
+            renderer->out() << event.name << " attacks you for " << event.amount << " damage!\n";
+            break;
+        case BattleEventType::Summon:
+            if (event.name == "Goust") {
+                renderer->out() << battle.getEnemies().getName(event.enemyIndex) << " summons a Goust!\n";
+            } else {
+                renderer->out() << battle.getEnemies().getName(event.enemyIndex) << " summons " 
+                                << event.amount << " " << event.name << "(s)!\n";
+            }
+            break;
+        case BattleEventType::Victory:
+            renderer->out() << "\n=== VICTORY! ===\n";
+            break;
+        case BattleEventType::Defeat:
+            renderer->out() << "\n=== DEFEAT ===\n";
+            break;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "battle.h"
+#include "renderer.h"
+
+// Battle policy that asks the player for every decision through the terminal
+class ConsoleBattlePolicy : public BattlePolicy {
+private:
+    Renderer* renderer;
+    
+public:
+    // What it does: Creates a policy reading from the game's terminal
+    // Inputs: renderer - renderer of the game (menus are shown and input is read through it)
+    // Outputs: None
+    explicit ConsoleBattlePolicy(Renderer* renderer);
+    
+    // What it does: Shows the action menu and reads the player's choice until it is valid
+    // Inputs: battle - battle being played
+    // Outputs: Chosen action
+    BattleAction chooseAction(const Battle& battle) override;
+    
+    // What it does: Lists alive enemies and reads which one to attack
+    // Inputs: battle - battle being played
+    // Outputs: Index of the chosen enemy, or -1 if the input was invalid
+    int chooseTarget(const Battle& battle) override;
+    
+    // What it does: Lists owned potions and reads which one to use
+    // Inputs: battle - battle being played, potions - player's potion inventory
+    // Outputs: Name of the chosen potion, or empty string if the input was invalid
+    std::string choosePotion(const Battle& battle, const PotionManager& potions) override;
+};
+
+// Battle event sink that prints every battle result to the terminal
+class ConsoleBattleSink : public BattleEventSink {
+private:
+    Renderer* renderer;
+    
+    // What it does: Displays current battle status including player HP and all enemy HP
+    // Inputs: battle - battle being played
+    // Outputs: None
+    void displayStatus(const Battle& battle) const;
+    
+public:
+    // What it does: Creates a sink printing to the game's terminal
+    // Inputs: renderer - renderer of the game
+    // Outputs: None
+    explicit ConsoleBattleSink(Renderer* renderer);
+    
+    // What it does: Prints the message for one battle result (does nothing in quiet mode)
+    // Inputs: battle - battle being played, event - result that happened
+    // Outputs: None
+    void onEvent(const Battle& battle, const BattleEvent& event) override;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "coroutine.h"
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+using namespace std;
+
+namespace {
+    // Coroutine whose stack is being entered for the first time (the entry point takes no arguments)
+    thread_local Coroutine* startingCoroutine = nullptr;
+    
+    // What it does: Returns the size of the inaccessible guard page below every stack
+    // Inputs: None
+    // Outputs: Page size in bytes
+    size_t guardSize() {
+        static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+        return size;
+    }
+}
+
+#if defined(__x86_64__)
+// What it does: Saves the callee-saved registers on the current stack and continues on another stack
+// Inputs: saveStack - where to store the current stack pointer, loadStack - stack pointer saved by an earlier switch
+// Outputs: None (returns when something switches back to the saved stack)
+extern "C" void coroutineSwitch(void** saveStack, void* loadStack);
+
+asm(".text\n"
+    ".globl coroutineSwitch\n"
+    ".type coroutineSwitch, @function\n"
+    "coroutineSwitch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size coroutineSwitch, .-coroutineSwitch\n");
+#endif
+
+Coroutine::Coroutine(void (*body)(void*), void* argument, size_t stackSize)
+    : body(body), argument(argument), stackSize(stackSize), stack(nullptr), started(false), finished(false) {
+}
+
+Coroutine::~Coroutine() {
+    if (stack) {
+        munmap(stack, stackSize + guardSize());
+    }
+}
+
+void Coroutine::entry() {
+    Coroutine* coroutine = startingCoroutine;
+    coroutine->body(coroutine->argument);
+    coroutine->finished = true;
+#if defined(__x86_64__)
+    // A finished coroutine is never resumed, so this switch does not return
+    coroutineSwitch(&coroutine->context, coroutine->callerContext);
+#endif
+}
+
+bool Coroutine::start() {
+    // The lowest page of the mapping is a guard page, so a stack overflow faults instead of
+    // silently overwriting whatever is mapped below the stack
+    size_t guard = guardSize();
+    void* memory = mmap(nullptr, stackSize + guard, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    if (mprotect(memory, guard, PROT_NONE) != 0) {
+        munmap(memory, stackSize + guard);
+        return false;
+    }
+    stack = (char*)memory;
+
+#if defined(__x86_64__)
+    // Initial frame as coroutineSwitch leaves it: six saved registers, then the return address (entry),
+    // then a null return address for entry itself, so entry starts with the stack aligned like after a call
+    void** top = (void**)((uintptr_t)(stack + guard + stackSize) & ~(uintptr_t)15);
+    top[-1] = nullptr;
+    top[-2] = (void*)&Coroutine::entry;
+    context = top - 8;
+#else
+    getcontext(&context);
+    context.uc_stack.ss_sp = stack + guard;
+    context.uc_stack.ss_size = stackSize;
+    context.uc_link = &callerContext;
+    makecontext(&context, &Coroutine::entry, 0);
+#endif
+    
+    started = true;
+    startingCoroutine = this;
+    resume();
+    return true;
+}
+
+void Coroutine::resume() {
+    if (!started || finished) {
+        return;
+    }
+#if defined(__x86_64__)
+    coroutineSwitch(&callerContext, context);
+#else
+    swapcontext(&callerContext, &context);
+#endif
+    if (finished && stack) {
+        munmap(stack, stackSize + guardSize());
+        stack = nullptr;
+    }
+}
+
+void Coroutine::suspend() {
+#if defined(__x86_64__)
+    coroutineSwitch(&context, callerContext);
+#else
+    swapcontext(&context, &callerContext);
+#endif
+}
+
+bool Coroutine::isStarted() const {
+    return started;
+}
+
+bool Coroutine::isFinished() const {
+    return finished;
+}
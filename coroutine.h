@@ -0,0 +1,80 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <cstddef>
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+// Stackful coroutine: a function that runs on its own small stack and can suspend itself at any
+// depth of calls (e.g. inside Battle::execute while it waits for the player's action) and be resumed
+// later by its owner. Many coroutines can be driven by one thread; the stack is only backed by memory
+// for the pages a coroutine actually touches, and it is freed as soon as the function returns. An
+// inaccessible guard page below every stack turns a stack overflow into a crash instead of memory corruption.
+// On x86-64 a switch only saves the callee-saved registers and swaps stack pointers (swapcontext
+// also saves the signal mask, which costs two system calls per switch); other targets use ucontext.
+class Coroutine {
+private:
+    void (*body)(void*);
+    void* argument;
+    size_t stackSize;
+    char* stack;
+    bool started;
+    bool finished;
+#if defined(__x86_64__)
+    void* callerContext;
+    void* context;
+#else
+    ucontext_t callerContext;
+    ucontext_t context;
+#endif
+    
+    // What it does: Runs the body of the coroutine being started (entry point handed to makecontext)
+    // Inputs: None
+    // Outputs: None
+    static void entry();
+    
+public:
+    // Size of the stack reserved for every coroutine by default
+    static const size_t DEFAULT_STACK_SIZE = 256 * 1024;
+    
+    // What it does: Creates a coroutine that has not started yet
+    // Inputs: body - function the coroutine runs, argument - value passed to the function, stackSize - size of its stack in bytes
+    // Outputs: None
+    Coroutine(void (*body)(void*), void* argument, size_t stackSize = DEFAULT_STACK_SIZE);
+    
+    // What it does: Frees the stack (a coroutine that has not finished is abandoned, its function never returns)
+    // Inputs: None
+    // Outputs: None
+    ~Coroutine();
+    
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+    
+    // What it does: Allocates the stack (plus its guard page) and runs the function until it first suspends or returns
+    // Inputs: None
+    // Outputs: Returns false if the stack could not be allocated
+    bool start();
+    
+    // What it does: Continues a suspended coroutine until it suspends again or returns (called by the owner)
+    // Inputs: None
+    // Outputs: None
+    void resume();
+    
+    // What it does: Suspends the coroutine and returns to whoever started or resumed it (called from inside the coroutine)
+    // Inputs: None
+    // Outputs: None
+    void suspend();
+    
+    // What it does: Checks if the coroutine has been started
+    // Inputs: None
+    // Outputs: Returns true once start succeeded
+    bool isStarted() const;
+    
+    // What it does: Checks if the function of the coroutine has returned
+    // Inputs: None
+    // Outputs: Returns true if the coroutine has finished
+    bool isFinished() const;
+};
+
+#endif
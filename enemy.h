@@ -2,116 +2,99 @@
 #define ENEMY_H
 
 #include <string>
+#include <type_traits>
 
-class Enemy {
-protected:
-    std::string name;
-    int maxHealth;
-    int currentHealth;
-    int attack;
-    
-public:
-    // What it does: Initializes enemy with given name, health, and attack values
-    // Inputs: name - enemy name, health - enemy health, attack - enemy attack damage
-    // Outputs: None
-    Enemy(const std::string& name, int health, int attack);
-    
-    // What it does: Cleans up enemy resources
-    // Inputs: None
-    // Outputs: None
-    virtual ~Enemy();
-    
-    // What it does: Returns enemy name
-    // Inputs: None
-    // Outputs: Enemy name (string)
-    std::string getName() const;
-    
-    // What it does: Returns current health value
-    // Inputs: None
-    // Outputs: Current health value (int)
-    int getCurrentHealth() const;
-    
-    // What it does: Returns maximum health value
-    // Inputs: None
-    // Outputs: Maximum health value (int)
-    int getMaxHealth() const;
-    
-    // What it does: Returns attack damage value
-    // Inputs: None
-    // Outputs: Attack damage value (int)
-    int getAttack() const;
-    
-    // What it does: Reduces enemy health by damage amount
-    // Inputs: damage - amount of damage to take
-    // Outputs: None
-    void takeDamage(int damage);
-    
-    // What it does: Checks if enemy is alive
-    // Inputs: None
-    // Outputs: Returns true if health > 0, false otherwise
-    bool isAlive() const;
-    
-    // What it does: Doubles the enemy's maximum and current health
-    // Inputs: None
-    // Outputs: None
-    void doubleHealth();
-    
-    // What it does: Returns enemy type identifier (pure virtual function)
-    // Inputs: None
-    // Outputs: Enemy type string
-    virtual std::string getType() const = 0;
+// Compact enemy type identifiers (used by the battle enemy pool instead of type strings)
+enum class EnemyType : unsigned char {
+    Slim,
+    Batho,
+    Goust,
+    Boss
 };
 
-class Slim : public Enemy {
-public:
-    // What it does: Creates a Slim enemy with 30 HP and 10 attack
-    // Inputs: None
-    // Outputs: None
-    Slim();
-    
-    // What it does: Returns enemy type as "Slim"
-    // Inputs: None
-    // Outputs: Enemy type string "Slim"
-    virtual std::string getType() const override;
-};
+// Behavior flags of an enemy type
+// ENEMY_SUMMONER - acts with Battle::bossAction (attack or summon helpers) instead of a plain attack
+const unsigned ENEMY_SUMMONER = 1u << 0;
 
-class Batho : public Enemy {
-public:
-    // What it does: Creates a Batho enemy with 60 HP and 30 attack
-    // Inputs: None
-    // Outputs: None
-    Batho();
-    
-    // What it does: Returns enemy type as "Batho"
-    // Inputs: None
-    // Outputs: Enemy type string "Batho"
-    virtual std::string getType() const override;
+// Compile-time description of one enemy type
+struct EnemyTraits {
+    const char* name;
+    int health;
+    int attack;
+    unsigned flags;
 };
 
-class Goust : public Enemy {
-public:
-    // What it does: Creates a Goust enemy with 10 HP and 80 attack
-    // Inputs: None
-    // Outputs: None
-    Goust();
-    
-    // What it does: Returns enemy type as "Goust"
-    // Inputs: None
-    // Outputs: Enemy type string "Goust"
-    virtual std::string getType() const override;
+// Traits of every enemy type, indexed by EnemyType. Adding an enemy type only takes its EnemyType
+// value and one entry here: pools, battles, levels and the solvers all read this table.
+constexpr EnemyTraits ENEMY_TRAITS[] = {
+    {"Slim", 30, 10, 0},
+    {"Batho", 60, 30, 0},
+    {"Goust", 10, 80, 0},
+    {"Boss", 300, 50, ENEMY_SUMMONER}
 };
 
-class Boss : public Enemy {
-public:
-    // What it does: Creates a Boss enemy with 300 HP and 50 attack
-    // Inputs: None
-    // Outputs: None
-    Boss();
-    
-    // What it does: Returns enemy type as "Boss"
-    // Inputs: None
-    // Outputs: Enemy type string "Boss"
-    virtual std::string getType() const override;
+const int ENEMY_TYPE_COUNT = sizeof(ENEMY_TRAITS) / sizeof(ENEMY_TRAITS[0]);
+
+static_assert((int)EnemyType::Boss + 1 == ENEMY_TYPE_COUNT, "every EnemyType needs an ENEMY_TRAITS entry");
+
+// What it does: Returns the traits of an enemy type
+// Inputs: type - enemy type
+// Outputs: Reference to the table entry
+constexpr const EnemyTraits& getEnemyTraits(EnemyType type) {
+    return ENEMY_TRAITS[(int)type];
+}
+
+// What it does: Returns the display name of an enemy type
+// Inputs: type - enemy type
+// Outputs: Enemy name (C string, never freed)
+constexpr const char* getEnemyTypeName(EnemyType type) {
+    return getEnemyTraits(type).name;
+}
+
+// What it does: Returns the starting health of an enemy type
+// Inputs: type - enemy type
+// Outputs: Maximum health (int)
+constexpr int getEnemyTypeHealth(EnemyType type) {
+    return getEnemyTraits(type).health;
+}
+
+// What it does: Returns the attack damage of an enemy type
+// Inputs: type - enemy type
+// Outputs: Attack damage (int)
+constexpr int getEnemyTypeAttack(EnemyType type) {
+    return getEnemyTraits(type).attack;
+}
+
+// What it does: Checks if an enemy type uses the summoner behavior
+// Inputs: type - enemy type
+// Outputs: Returns true if the type has ENEMY_SUMMONER set
+constexpr bool isEnemySummoner(EnemyType type) {
+    return (getEnemyTraits(type).flags & ENEMY_SUMMONER) != 0;
+}
+
+// What it does: Builds a bitmask with bit t set for every summoner type t (for branch-free checks in hot loops)
+// Inputs: None
+// Outputs: Bitmask (unsigned)
+constexpr unsigned getSummonerMask() {
+    unsigned mask = 0;
+    for (int i = 0; i < ENEMY_TYPE_COUNT; i++) {
+        if (ENEMY_TRAITS[i].flags & ENEMY_SUMMONER) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+// Behavior of one enemy type as a compile-time tag (std::true_type or std::false_type), so the
+// per-type enemy actions of Battle can be picked by template
+template <EnemyType Type>
+struct EnemyKind {
+    typedef std::integral_constant<bool, isEnemySummoner(Type)> Summoner;
 };
 
+// What it does: Converts an enemy name to its type
+// Inputs: name - enemy name ("Slim", "Batho", "Goust" or "Boss"), type - reference to store the type
+// Outputs: Returns true if the name is a known enemy, false otherwise
+bool parseEnemyType(const std::string& name, EnemyType& type);
+
 #endif
@@ -0,0 +1,177 @@
+#include "enemypool.h"
+#include <algorithm>
+using namespace std;
+
+EnemyPool::EnemyPool(int capacity, Arena& arena)
+    : count(0), capacity(capacity), bossCount(0), maskWords((capacity + 63) / 64), aliveCount(0),
+      aliveByType(), defeatedCount(0), types(arena.allocateArray<EnemyType>(capacity)), health(arena.allocateArray<int>(capacity)),
+      maxHealth(arena.allocateArray<int>(capacity)), attack(arena.allocateArray<int>(capacity)),
+      aliveMask(arena.allocateArray<uint64_t>(maskWords)) {
+}
+
+EnemyPool::EnemyPool(const EnemyPool& source, Arena& arena)
+    : EnemyPool(source.capacity, arena) {
+    count = source.count;
+    bossCount = source.bossCount;
+    aliveCount = source.aliveCount;
+    copy(source.aliveByType, source.aliveByType + ENEMY_TYPE_COUNT, aliveByType);
+    defeatedCount = source.defeatedCount;
+    copy(source.types, source.types + count, types);
+    copy(source.health, source.health + count, health);
+    copy(source.maxHealth, source.maxHealth + count, maxHealth);
+    copy(source.attack, source.attack + count, attack);
+    copy(source.aliveMask, source.aliveMask + maskWords, aliveMask);
+}
+
+bool EnemyPool::add(EnemyType type) {
+    if (count >= capacity) {
+        return false;
+    }
+    types[count] = type;
+    health[count] = getEnemyTypeHealth(type);
+    maxHealth[count] = health[count];
+    attack[count] = getEnemyTypeAttack(type);
+    if (health[count] > 0) {
+        setAlive(count, true);
+        aliveCount++;
+        aliveByType[(int)type]++;
+    }
+    if (isEnemySummoner(type)) {
+        bossCount++;
+    }
+    count++;
+    return true;
+}
+
+void EnemyPool::takeDamage(int index, int damage) {
+    health[index] -= damage;
+    if (health[index] <= 0) {
+        if (isAlive(index)) {
+            setAlive(index, false);
+            aliveCount--;
+            aliveByType[(int)types[index]]--;
+            defeatedCount++;
+        }
+        health[index] = 0;
+    }
+}
+
+void EnemyPool::doubleHealth() {
+    for (int i = 0; i < count; i++) {
+        maxHealth[i] *= 2;
+        health[i] *= 2;
+    }
+}
+
+int EnemyPool::removeDead() {
+    if (aliveCount == count) {
+        return 0;
+    }
+    
+    // Enemies before the first dead one stay where they are
+    int kept = 0;
+    for (int word = 0; word < maskWords; word++) {
+        uint64_t dead = ~aliveMask[word];
+        if (dead != 0) {
+            kept = word * 64 + __builtin_ctzll(dead);
+            break;
+        }
+    }
+    for (int i = kept; i < count; i++) {
+        if (health[i] > 0) {
+            types[kept] = types[i];
+            health[kept] = health[i];
+            maxHealth[kept] = maxHealth[i];
+            attack[kept] = attack[i];
+            kept++;
+        } else if (isEnemySummoner(types[i])) {
+            bossCount--;
+        }
+    }
+    
+    int removed = count - kept;
+    if (removed > 0) {
+        count = kept;
+        for (int word = 0; word < maskWords; word++) {
+            int bits = count - word * 64;
+            if (bits >= 64) {
+                aliveMask[word] = ~(uint64_t)0;
+            } else if (bits > 0) {
+                aliveMask[word] = ((uint64_t)1 << bits) - 1;
+            } else {
+                aliveMask[word] = 0;
+            }
+        }
+    }
+    return removed;
+}
+
+int EnemyPool::findAlive(int from) const {
+    if (from < 0) {
+        from = 0;
+    }
+    if (from >= count) {
+        return -1;
+    }
+    int word = from >> 6;
+    uint64_t bits = aliveMask[word] & (~(uint64_t)0 << (from & 63));
+    while (bits == 0) {
+        if (++word >= maskWords) {
+            return -1;
+        }
+        bits = aliveMask[word];
+    }
+    int index = word * 64 + __builtin_ctzll(bits);
+    return index < count ? index : -1;
+}
+
+int EnemyPool::sumAttackDamage(int begin, int end, double damageMultiplier) const {
+    const EnemyType* typeData = types;
+    const int* healthData = health;
+    const int* attackData = attack;
+    const unsigned summoners = getSummonerMask();
+    int total = 0;
+    for (int i = begin; i < end; i++) {
+        int damage = (int)(attackData[i] * damageMultiplier);
+        int attacks = (healthData[i] > 0) & !((summoners >> (int)typeData[i]) & 1);
+        total += damage * attacks;
+    }
+    return total;
+}
+
+int EnemyPool::saveSnapshot(EnemySnapshot* enemies, int maxCount) const {
+    if (count > maxCount) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        enemies[i].type = types[i];
+        enemies[i].alive = isAlive(i);
+        enemies[i].health = health[i];
+        enemies[i].maxHealth = maxHealth[i];
+        enemies[i].attack = attack[i];
+    }
+    return count;
+}
+
+void EnemyPool::restoreSnapshot(const EnemySnapshot* enemies, int enemyCount) {
+    count = min(enemyCount, capacity);
+    bossCount = 0;
+    aliveCount = 0;
+    fill(aliveByType, aliveByType + ENEMY_TYPE_COUNT, 0);
+    defeatedCount = 0;
+    fill(aliveMask, aliveMask + maskWords, 0);
+    for (int i = 0; i < count; i++) {
+        types[i] = enemies[i].type;
+        health[i] = enemies[i].health;
+        maxHealth[i] = enemies[i].maxHealth;
+        attack[i] = enemies[i].attack;
+        if (enemies[i].alive != 0) {
+            setAlive(i, true);
+            aliveCount++;
+            aliveByType[(int)types[i]]++;
+        }
+        if (isEnemySummoner(types[i])) {
+            bossCount++;
+        }
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef ENEMYPOOL_H
+#define ENEMYPOOL_H
+
+#include "enemy.h"
+#include "arena.h"
+#include <cstdint>
+
+// One enemy of a battle snapshot as plain values
+struct EnemySnapshot {
+    EnemyType type;
+    uint8_t alive;
+    int32_t health;
+    int32_t maxHealth;
+    int32_t attack;
+};
+
+// Structure-of-arrays store for the enemies of one battle
+// All arrays are allocated once, at the pool capacity, from the arena of the owning battle, so
+// creating, summoning and removing enemies never touches the heap. Enemy i is alive exactly when
+// bit i of the alive mask is set. Alive enemies are also counted in total and per type as they
+// are added, defeated and restored, so alive counts are O(1) however large the pool (horde battles).
+class EnemyPool {
+private:
+    int count;
+    int capacity;
+    int bossCount;
+    int maskWords;
+    int aliveCount;
+    int aliveByType[ENEMY_TYPE_COUNT];
+    long long defeatedCount;
+    EnemyType* types;
+    int* health;
+    int* maxHealth;
+    int* attack;
+    uint64_t* aliveMask;
+    
+    // What it does: Sets or clears the alive bit of an enemy (the alive counters are updated by the caller)
+    // Inputs: index - enemy index, alive - new alive state
+    // Outputs: None
+    void setAlive(int index, bool alive) {
+        uint64_t bit = (uint64_t)1 << (index & 63);
+        if (alive) {
+            aliveMask[index >> 6] |= bit;
+        } else {
+            aliveMask[index >> 6] &= ~bit;
+        }
+    }
+    
+public:
+    // What it does: Creates an empty pool able to hold a fixed number of enemies
+    // Inputs: capacity - maximum number of enemies held at once, arena - arena that owns the pool's arrays (must outlive the pool)
+    // Outputs: None
+    EnemyPool(int capacity, Arena& arena);
+    
+    // What it does: Copies a pool into arrays allocated from another arena
+    // Inputs: source - pool to copy, arena - arena that owns the copy's arrays (must outlive the copy)
+    // Outputs: None
+    EnemyPool(const EnemyPool& source, Arena& arena);
+    
+    EnemyPool(const EnemyPool&) = delete;
+    EnemyPool& operator=(const EnemyPool&) = delete;
+    
+    // What it does: Adds a new enemy at full health at the end of the pool
+    // Inputs: type - enemy type to add
+    // Outputs: Returns true if the enemy was added, false if the pool is full
+    bool add(EnemyType type);
+    
+    // What it does: Deals damage to one enemy (health never drops below 0)
+    // Inputs: index - enemy index, damage - amount of damage
+    // Outputs: None
+    void takeDamage(int index, int damage);
+    
+    // What it does: Doubles maximum and current health of every enemy in the pool
+    // Inputs: None
+    // Outputs: None
+    void doubleHealth();
+    
+    // What it does: Removes dead enemies, keeping the order of the alive ones (returns at once if none died,
+    // otherwise only the enemies after the first dead one are moved)
+    // Inputs: None
+    // Outputs: Number of enemies removed (int)
+    int removeDead();
+    
+    // What it does: Returns number of alive enemies
+    // Inputs: None
+    // Outputs: Alive enemy count (int)
+    int countAlive() const { return aliveCount; }
+    
+    // What it does: Returns number of alive enemies of one type
+    // Inputs: type - enemy type
+    // Outputs: Alive enemy count of that type (int)
+    int countAlive(EnemyType type) const { return aliveByType[(int)type]; }
+    
+    // What it does: Checks if any enemy is alive
+    // Inputs: None
+    // Outputs: Returns true if at least one enemy is alive
+    bool anyAlive() const { return aliveCount > 0; }
+    
+    // What it does: Finds the first alive enemy at or after an index using the alive bitmask (skips 64 dead enemies per step)
+    // Inputs: from - first enemy index to look at
+    // Outputs: Index of the alive enemy, or -1 if there is none
+    int findAlive(int from) const;
+    
+    // What it does: Returns number of enemies defeated since the pool was created or restored from a snapshot
+    // Inputs: None
+    // Outputs: Defeated enemy count (long long)
+    long long getDefeatedCount() const { return defeatedCount; }
+    
+    // What it does: Sums the shield-reduced damage of all alive non-summoner enemies in a range (vectorizable)
+    // Inputs: begin - first enemy index, end - one past the last enemy index, damageMultiplier - player's damage multiplier
+    // Outputs: Total damage dealt to the player (int)
+    int sumAttackDamage(int begin, int end, double damageMultiplier) const;
+    
+    // What it does: Copies the enemies of the pool into snapshot entries
+    // Inputs: enemies - array to fill, maxCount - number of entries the array has room for
+    // Outputs: Number of entries written (size()), or -1 if the pool holds more than maxCount enemies (nothing is written)
+    int saveSnapshot(EnemySnapshot* enemies, int maxCount) const;
+    
+    // What it does: Replaces the enemies of the pool with snapshot entries (no heap allocation)
+    // Inputs: enemies - entries written by saveSnapshot, enemyCount - number of entries (at most the capacity)
+    // Outputs: None
+    void restoreSnapshot(const EnemySnapshot* enemies, int enemyCount);
+    
+    // What it does: Returns number of enemies in the pool (alive or not yet removed)
+    // Inputs: None
+    // Outputs: Enemy count (int)
+    int size() const { return count; }
+    
+    // What it does: Returns maximum number of enemies the pool can hold
+    // Inputs: None
+    // Outputs: Capacity (int)
+    int getCapacity() const { return capacity; }
+    
+    // What it does: Returns number of bosses (enemies with the ENEMY_SUMMONER flag) in the pool
+    // Inputs: None
+    // Outputs: Boss count (int)
+    int getBossCount() const { return bossCount; }
+    
+    // What it does: Returns type of an enemy
+    // Inputs: index - enemy index
+    // Outputs: Enemy type
+    EnemyType getType(int index) const { return types[index]; }
+    
+    // What it does: Returns display name of an enemy
+    // Inputs: index - enemy index
+    // Outputs: Enemy name (C string)
+    const char* getName(int index) const { return getEnemyTypeName(types[index]); }
+    
+    // What it does: Returns current health of an enemy
+    // Inputs: index - enemy index
+    // Outputs: Current health (int)
+    int getHealth(int index) const { return health[index]; }
+    
+    // What it does: Returns maximum health of an enemy
+    // Inputs: index - enemy index
+    // Outputs: Maximum health (int)
+    int getMaxHealth(int index) const { return maxHealth[index]; }
+    
+    // What it does: Returns attack damage of an enemy
+    // Inputs: index - enemy index
+    // Outputs: Attack damage (int)
+    int getAttack(int index) const { return attack[index]; }
+    
+    // What it does: Checks if an enemy is alive
+    // Inputs: index - enemy index
+    // Outputs: Returns true if the enemy is alive
+    bool isAlive(int index) const { return (aliveMask[index >> 6] >> (index & 63)) & 1; }
+};
+
+#endif
@@ -1,16 +1,129 @@
 #include "event.h"
-#include <iostream>
-#include <cstdlib>
-#include <ctime>
+#include "alias.h"
+#include "metrics.h"
+#include <fstream>
+#include <sstream>
 #include <vector>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
 using namespace std;
 
-EventManager::EventManager(bool hardMode) : isHardMode(hardMode) {
-    static bool initialized = false;
-    if (!initialized) {
-        std::srand(static_cast<unsigned int>(std::time(nullptr)));
-        initialized = true;
+namespace {
+    const char* const EVENT_OUTCOME_NAMES[EVENT_OUTCOME_COUNT] = {
+        "equipment", "boss-power", "nothing", "treasure", "trap", "robbery", "curse", "equipment-curse"
+    };
+    
+    const char* const DIFFICULTY_NAMES[2] = {"easy", "hard"};
+    
+    // Largest weight an event weight file may use (keeps the combined weights within 64 bits)
+    const int MAX_EVENT_WEIGHT = 1000000;
+    
+    // Event weights of one difficulty
+    struct EventWeights {
+        int positive;
+        int negative;
+        int outcomes[EVENT_OUTCOME_COUNT];
+    };
+    
+    // Built-in weights: easy games only have positive events, hard games are negative half the time,
+    // and all outcomes of a kind are equally likely (events.cfg holds the same weights as text)
+    const EventWeights BUILT_IN_WEIGHTS[2] = {
+        {1, 0, {1, 1, 1, 1, 1, 1, 1, 1}},
+        {1, 1, {1, 1, 1, 1, 1, 1, 1, 1}}
+    };
+    
+    // Sampling tables of one difficulty
+    struct EventTables {
+        EventWeights weights;
+        AliasTable kinds;
+        AliasTable positive;
+        AliasTable negative;
+        AliasTable combined;
+    };
+    
+    // What it does: Builds the sampling tables for a set of weights
+    // Inputs: weights - event weights of one difficulty, tables - reference to store the tables, error - reference to store the reason if the weights are unusable
+    // Outputs: Returns true if the tables were built, false otherwise
+    bool buildTables(const EventWeights& weights, EventTables& tables, string& error) {
+        // Entry 0 of the kind table is negative, so a {1, 1} table draws like the original rng.nextInt(4) < 2
+        vector<int> kinds = {weights.negative, weights.positive};
+        vector<int> positive(weights.outcomes, weights.outcomes + POSITIVE_EVENT_COUNT);
+        vector<int> negative(weights.outcomes + POSITIVE_EVENT_COUNT, weights.outcomes + EVENT_OUTCOME_COUNT);
+        if (!AliasTable::isValid(kinds, error)) {
+            error = "positive and negative: " + error;
+            return false;
+        }
+        if (weights.positive > 0 && !AliasTable::isValid(positive, error)) {
+            error = "positive outcomes: " + error;
+            return false;
+        }
+        if (weights.negative > 0 && !AliasTable::isValid(negative, error)) {
+            error = "negative outcomes: " + error;
+            return false;
+        }
+        
+        // Combined weight of an outcome = kind weight * outcome weight * total weight of the other kind,
+        // so each outcome keeps probability (kind weight / kinds total) * (outcome weight / its kind's total)
+        long long positiveTotal = 0, negativeTotal = 0;
+        for (int weight : positive) positiveTotal += weight;
+        for (int weight : negative) negativeTotal += weight;
+        long long combined[EVENT_OUTCOME_COUNT];
+        long long divisor = 0;
+        for (int i = 0; i < EVENT_OUTCOME_COUNT; i++) {
+            if (i < POSITIVE_EVENT_COUNT) {
+                combined[i] = (long long)weights.positive * weights.outcomes[i] * (weights.negative > 0 ? negativeTotal : 1);
+            } else {
+                combined[i] = (long long)weights.negative * weights.outcomes[i] * (weights.positive > 0 ? positiveTotal : 1);
+            }
+            long long a = divisor, b = combined[i];
+            while (b != 0) {
+                long long rest = a % b;
+                a = b;
+                b = rest;
+            }
+            divisor = a;
+        }
+        vector<int> combinedWeights(EVENT_OUTCOME_COUNT);
+        for (int i = 0; i < EVENT_OUTCOME_COUNT; i++) {
+            combined[i] /= divisor;
+            if (combined[i] > INT_MAX) {
+                error = "weights too large";
+                return false;
+            }
+            combinedWeights[i] = (int)combined[i];
+        }
+        if (!AliasTable::isValid(combinedWeights, error)) {
+            return false;
+        }
+        
+        tables.weights = weights;
+        tables.kinds = AliasTable(kinds);
+        tables.positive = weights.positive > 0 ? AliasTable(positive) : AliasTable();
+        tables.negative = weights.negative > 0 ? AliasTable(negative) : AliasTable();
+        tables.combined = AliasTable(combinedWeights);
+        return true;
     }
+    
+    // What it does: Builds the tables of the built-in weights
+    // Inputs: difficulty - 0 for easy, 1 for hard
+    // Outputs: Sampling tables
+    EventTables builtInTables(int difficulty) {
+        EventTables tables;
+        string error;
+        buildTables(BUILT_IN_WEIGHTS[difficulty], tables, error);
+        return tables;
+    }
+    
+    // Sampling tables used by every EventManager, indexed by difficulty (0 easy, 1 hard)
+    EventTables eventTables[2] = {builtInTables(0), builtInTables(1)};
+}
+
+const char* getEventOutcomeName(EventOutcome outcome) {
+    return EVENT_OUTCOME_NAMES[(int)outcome];
+}
+
+EventManager::EventManager(Random* rng, bool hardMode) : isHardMode(hardMode), rng(rng) {
 }
 
 EventManager::~EventManager() {
@@ -18,62 +131,68 @@ EventManager::~EventManager() {
 
 string EventManager::executeRandomEvent(Player* player, PotionManager* potionManager,
                                        bool& enemyDoubleHP, string& disabledEquipment) {
-    if (isHardMode) {
-        int roll = rand() % 4;
-        if (roll < 2) {
-            return executeNegativeEvent(player, enemyDoubleHP, disabledEquipment);
+    METRIC_TIME(MetricPhase::Event);
+    return applyEvent(rollEvent(), player, potionManager, enemyDoubleHP, disabledEquipment);
+}
+
+EventOutcome EventManager::rollEvent() {
+    const EventTables& tables = eventTables[isHardMode ? 1 : 0];
+    bool negative = tables.weights.negative > 0 && (tables.weights.positive == 0 || tables.kinds.sample(*rng) == 0);
+    if (negative) {
+        return (EventOutcome)(POSITIVE_EVENT_COUNT + tables.negative.sample(*rng));
+    }
+    return (EventOutcome)tables.positive.sample(*rng);
+}
+
+void EventManager::rollEvents(EventOutcome* outcomes, int count) {
+    const AliasTable& combined = eventTables[isHardMode ? 1 : 0].combined;
+    const int CHUNK = 64;
+    int indices[CHUNK];
+    for (int done = 0; done < count; done += CHUNK) {
+        int chunk = min(CHUNK, count - done);
+        combined.sampleMany(*rng, indices, chunk);
+        for (int i = 0; i < chunk; i++) {
+            outcomes[done + i] = (EventOutcome)indices[i];
         }
     }
-    
-    int eventNum = (rand() % 4) + 1;
-    return executePositiveEvent(player, potionManager, eventNum);
 }
 
-string EventManager::executePositiveEvent(Player* player, PotionManager* potionManager, int eventNum) {
-    switch (eventNum) {
-        case 1: {
-            vector<string> equipmentTypes = {"Shield", "Sword", "Armor", "Shoes"};
-            int index = rand() % equipmentTypes.size();
-            string equip = equipmentTypes[index];
+string EventManager::applyEvent(EventOutcome outcome, Player* player, PotionManager* potionManager,
+                                bool& enemyDoubleHP, string& disabledEquipment) {
+    switch (outcome) {
+        case EventOutcome::Equipment: {
+            EquipmentType type = Player::getRandomEquipmentType(*rng);
+            string equip = getEquipmentName(type);
             
-            if (player->addEquipment(equip)) {
+            if (player->addEquipment(type)) {
                 return "Event: You found a " + equip + "! Equipment added to inventory.";
             } else {
                 return "Event: You found a " + equip + ", but your equipment inventory is full!";
             }
         }
-        case 2: {
+        case EventOutcome::BossPower: {
             player->addBossAttackBonus(30);
             return "Event: You feel a surge of power! +30 attack bonus for boss battle!";
         }
-        case 3: {
+        case EventOutcome::Nothing: {
             return "Event: Nothing happens. You continue your journey.";
         }
-        case 4: {
-            potionManager->addPotion("Strength Potion", 1);
-            potionManager->addPotion("Attacker Potion", 1);
-            potionManager->addPotion("Life Potion", 1);
+        case EventOutcome::Treasure: {
+            potionManager->addPotion(PotionType::Strength, 1);
+            potionManager->addPotion(PotionType::Attacker, 1);
+            potionManager->addPotion(PotionType::Life, 1);
             return "Event: You found a treasure chest! Received: Strength Potion, Attacker Potion, Life Potion x1 each.";
         }
-        default:
-            return "Event: Nothing happens.";
-    }
-}
-
-string EventManager::executeNegativeEvent(Player* player, bool& enemyDoubleHP, string& disabledEquipment) {
-    int eventType = rand() % 4;
-    
-    switch (eventType) {
-        case 0: {
-            int damage = 20 + (rand() % 30);
+        case EventOutcome::Trap: {
+            int damage = 20 + rng->nextInt(30);
             player->takeDamage(damage);
             return "Event: You stepped on a trap! Lost " + to_string(damage) + " HP.";
         }
-        case 1: {
+        case EventOutcome::Robbery: {
             if (player->getGold() > 0) {
                 int goldLost = 1;
                 if (player->getGold() > 1) {
-                    goldLost = 1 + (rand() % player->getGold());
+                    goldLost = 1 + rng->nextInt(player->getGold());
                 }
                 for (int i = 0; i < goldLost; i++) {
                     player->spendGold(1);
@@ -83,15 +202,15 @@ string EventManager::executeNegativeEvent(Player* player, bool& enemyDoubleHP, s
                 return "Event: A thief tried to rob you, but you have no gold!";
             }
         }
-        case 2: {
+        case EventOutcome::Curse: {
             enemyDoubleHP = true;
             return "Event: A dark curse weakens you! Enemies in the next battle will have double HP.";
         }
-        case 3: {
-            vector<string> equipment = player->getEquipment();
-            if (!equipment.empty()) {
-                int index = rand() % equipment.size();
-                disabledEquipment = equipment[index];
+        case EventOutcome::EquipmentCurse: {
+            int equipmentCount = player->getEquippedCount();
+            if (equipmentCount > 0) {
+                int index = rng->nextInt(equipmentCount);
+                disabledEquipment = getEquipmentName(player->getEquippedItem(index));
                 return "Event: A curse has been placed on your " + disabledEquipment + "! It will be disabled in the next battle.";
             } else {
                 player->takeDamage(25);
@@ -106,3 +225,75 @@ string EventManager::executeNegativeEvent(Player* player, bool& enemyDoubleHP, s
 void EventManager::setHardMode(bool hardMode) {
     isHardMode = hardMode;
 }
+
+bool EventManager::loadTable(const std::string& fileName, std::string& error) {
+    ifstream file(fileName);
+    if (!file) {
+        error = "cannot open " + fileName;
+        return false;
+    }
+    
+    EventWeights weights[2] = {eventTables[0].weights, eventTables[1].weights};
+    int difficulty = -1;
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) {
+            line.erase(comment);
+        }
+        istringstream words(line);
+        string name;
+        if (!(words >> name)) continue;
+        string where = fileName + ":" + to_string(lineNumber) + ": ";
+        
+        if (name == "[easy]" || name == "[hard]") {
+            difficulty = name == "[hard]" ? 1 : 0;
+            continue;
+        }
+        if (difficulty < 0) {
+            error = where + "weights before [easy] or [hard]";
+            return false;
+        }
+        
+        string value, extra;
+        char* end = nullptr;
+        long weight = -1;
+        if (words >> value) {
+            weight = strtol(value.c_str(), &end, 10);
+        }
+        if (weight < 0 || weight > MAX_EVENT_WEIGHT || *end != '\0' || (words >> extra)) {
+            error = where + "expected \"" + name + " <weight>\" with a weight from 0 to " + to_string(MAX_EVENT_WEIGHT);
+            return false;
+        }
+        
+        EventWeights& target = weights[difficulty];
+        if (name == "positive") {
+            target.positive = (int)weight;
+        } else if (name == "negative") {
+            target.negative = (int)weight;
+        } else {
+            int outcome = 0;
+            while (outcome < EVENT_OUTCOME_COUNT && name != EVENT_OUTCOME_NAMES[outcome]) {
+                outcome++;
+            }
+            if (outcome == EVENT_OUTCOME_COUNT) {
+                error = where + "unknown event \"" + name + "\"";
+                return false;
+            }
+            target.outcomes[outcome] = (int)weight;
+        }
+    }
+    
+    EventTables tables[2];
+    for (int i = 0; i < 2; i++) {
+        if (!buildTables(weights[i], tables[i], error)) {
+            error = fileName + ": " + DIFFICULTY_NAMES[i] + " " + error;
+            return false;
+        }
+    }
+    eventTables[0] = tables[0];
+    eventTables[1] = tables[1];
+    return true;
+}
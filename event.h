@@ -3,17 +3,42 @@
 
 #include "player.h"
 #include "potion.h"
+#include "rng.h"
 #include <string>
 
+// Outcomes of random events. The first POSITIVE_EVENT_COUNT are positive, the rest negative.
+enum class EventOutcome : unsigned char {
+    Equipment,
+    BossPower,
+    Nothing,
+    Treasure,
+    Trap,
+    Robbery,
+    Curse,
+    EquipmentCurse
+};
+
+const int EVENT_OUTCOME_COUNT = 8;
+const int POSITIVE_EVENT_COUNT = 4;
+
+// What it does: Returns the name of an event outcome used in event weight files
+// Inputs: outcome - event outcome
+// Outputs: Outcome name (C string, e.g. "boss-power")
+const char* getEventOutcomeName(EventOutcome outcome);
+
+// Random events of event levels. Outcomes are drawn from weighted tables (one set per difficulty:
+// how often events are negative, and how likely each positive and negative outcome is) with O(1)
+// alias sampling. The built-in weights can be replaced with loadTable.
 class EventManager {
 private:
     bool isHardMode;
+    Random* rng;
     
 public:
     // What it does: Initializes event manager with difficulty mode
-    // Inputs: hardMode - true if hard difficulty, false if easy
+    // Inputs: rng - random number generator of this session, hardMode - true if hard difficulty, false if easy
     // Outputs: None
-    EventManager(bool hardMode = false);
+    EventManager(Random* rng, bool hardMode = false);
     
     // What it does: Cleans up event manager resources
     // Inputs: None
@@ -26,20 +51,38 @@ public:
     std::string executeRandomEvent(Player* player, PotionManager* potionManager,
                                    bool& enemyDoubleHP, std::string& disabledEquipment);
     
-    // What it does: Executes a positive event (gives rewards to player)
-    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, eventNum - event number (1-4)
-    // Outputs: Description of the event (string)
-    std::string executePositiveEvent(Player* player, PotionManager* potionManager, int eventNum);
+    // What it does: Draws the outcome of one event for the current difficulty (first whether it is negative,
+    // unless only one kind has weight, then the outcome within that kind)
+    // Inputs: None
+    // Outputs: Drawn outcome
+    EventOutcome rollEvent();
+    
+    // What it does: Draws the outcomes of several events at once from the combined table of the current
+    // difficulty (same distribution as rollEvent, but one random number per event)
+    // Inputs: outcomes - array to store the outcomes, count - number of events to draw
+    // Outputs: None
+    void rollEvents(EventOutcome* outcomes, int count);
     
-    // What it does: Executes a negative event (hard mode only, applies penalties)
-    // Inputs: player - pointer to player object, enemyDoubleHP - reference to set enemy double HP flag, disabledEquipment - reference to set disabled equipment name
+    // What it does: Applies an event outcome to the player
+    // Inputs: outcome - outcome to apply, player - pointer to player object, potionManager - pointer to potion manager,
+    //         enemyDoubleHP - reference to set enemy double HP flag, disabledEquipment - reference to set disabled equipment name
     // Outputs: Description of the event (string)
-    std::string executeNegativeEvent(Player* player, bool& enemyDoubleHP, std::string& disabledEquipment);
+    std::string applyEvent(EventOutcome outcome, Player* player, PotionManager* potionManager,
+                           bool& enemyDoubleHP, std::string& disabledEquipment);
     
     // What it does: Sets difficulty mode
     // Inputs: hardMode - true for hard mode, false for easy mode
     // Outputs: None
     void setHardMode(bool hardMode);
+    
+    // What it does: Replaces the event weights with the ones of a config file. "[easy]" or "[hard]" starts the weights
+    // of a difficulty, followed by "<name> <weight>" lines: "positive" and "negative" weigh the two kinds of events,
+    // outcome names (see getEventOutcomeName) weigh the outcomes within their kind. Weights that are not listed keep
+    // their built-in value; "#" starts a comment
+    // Inputs: fileName - config file to read, error - reference to store a message with the line number if the file is invalid
+    // Outputs: Returns true if the weights were loaded, false if the file is missing or invalid (the weights are unchanged)
+    // (call it before starting threads that run events)
+    static bool loadTable(const std::string& fileName, std::string& error);
 };
 
 #endif
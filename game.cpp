@@ -1,19 +1,23 @@
 #include "game.h"
 #include <iostream>
-#include <limits>
-#include <cstdlib>
-#include <ctime>
 using namespace std;
 
-Game::Game() : currentLevel(1), difficulty(0), gameOver(false), gameWon(false),
-               enemyDoubleHP(false), disabledEquipment("") {
+Game::Game(uint64_t seed, bool quiet) : Game(cin, cout, seed, quiet) {
+}
+
+Game::Game(istream& input, ostream& output, uint64_t seed, bool quiet, const string& savePrefix)
+    : savePrefix(savePrefix), currentLevel(1), difficulty(0), saveSlot(1), durableSaves(true), gameOver(false), gameWon(false),
+      enemyDoubleHP(false), disabledEquipment("") {
+    renderer = new Renderer(input, output, quiet);
+    rng = new Random(seed);
     player = new Player();
     potionManager = new PotionManager();
-    eventManager = new EventManager(false);
+    eventManager = new EventManager(rng, false);
     shop = new Shop();
-    saveManager = new SaveManager();
-    
-    srand(static_cast<unsigned int>(time(nullptr)));
+    saveManager = new SaveManager(savePrefix + SaveManager::getSlotFileName(saveSlot));
+    autosave = new Autosave(saveManager);
+    battlePolicy = new ConsoleBattlePolicy(renderer);
+    battleSink = new ConsoleBattleSink(renderer);
 }
 
 Game::~Game() {
@@ -21,20 +25,98 @@ Game::~Game() {
     delete potionManager;
     delete eventManager;
     delete shop;
+    delete autosave;
     delete saveManager;
+    delete rng;
+    delete battlePolicy;
+    delete battleSink;
+    delete renderer;
 }
 
 void Game::run() {
+    try {
+        menuLoop();
+    } catch (const InputClosed&) {
+        gameOver = true;
+    }
+    renderer->out().flush();
+}
+
+void Game::setRecorder(ReplayRecorder* recorder) {
+    renderer->setRecorder(recorder);
+}
+
+void Game::setScript(CommandScript* script) {
+    renderer->setScript(script);
+}
+
+void Game::setDurableSaves(bool durable) {
+    durableSaves = durable;
+    autosave->flush();
+    saveManager->setDurable(durable);
+}
+
+uint32_t Game::getStateChecksum() const {
+    vector<int64_t> state = {currentLevel, difficulty, gameOver, gameWon, enemyDoubleHP,
+                             player->getBaseMaxHealth(), player->getCurrentHealth(), player->getBaseAttack(),
+                             player->getGold(), player->getBossAttackBonus(), player->getEquippedCount()};
+    for (int slot = 0; slot < player->getEquippedCount(); slot++) {
+        state.push_back((int)player->getEquippedItem(slot));
+    }
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        state.push_back(potionManager->getQuantity((PotionType)i));
+    }
+    for (int i = 0; i < 4; i++) {
+        state.push_back((int64_t)rng->getState(i));
+    }
+    for (char ch : disabledEquipment) {
+        state.push_back(ch);
+    }
+    return SaveManager::crc32(state.data(), state.size() * sizeof(int64_t));
+}
+
+void Game::saveSnapshot(GameSnapshot& snapshot) const {
+    snapshot.currentLevel = currentLevel;
+    snapshot.difficulty = difficulty;
+    snapshot.gameOver = gameOver;
+    snapshot.gameWon = gameWon;
+    snapshot.enemyDoubleHP = enemyDoubleHP;
+    snapshot.disabledEquipment = parseEquipmentType(disabledEquipment);
+    player->saveSnapshot(snapshot.player);
+    potionManager->saveSnapshot(snapshot.potions);
+    for (int i = 0; i < 4; i++) {
+        snapshot.random[i] = rng->getState(i);
+    }
+}
+
+void Game::restoreSnapshot(const GameSnapshot& snapshot) {
+    currentLevel = snapshot.currentLevel;
+    difficulty = snapshot.difficulty;
+    gameOver = snapshot.gameOver != 0;
+    gameWon = snapshot.gameWon != 0;
+    enemyDoubleHP = snapshot.enemyDoubleHP != 0;
+    disabledEquipment = getEquipmentName(snapshot.disabledEquipment);
+    player->restoreSnapshot(snapshot.player);
+    potionManager->restoreSnapshot(snapshot.potions);
+    for (int i = 0; i < 4; i++) {
+        rng->setState(i, snapshot.random[i]);
+    }
+    eventManager->setHardMode(difficulty == 1);
+}
+
+bool Game::saveAndWait(int resumeLevel) {
+    bool ok = autosave->submit(player, potionManager, resumeLevel, difficulty, false);
+    return autosave->flush() && ok;
+}
+
+void Game::menuLoop() {
     while (!gameOver) {
         displayMainMenu();
         
         int choice;
-        cin >> choice;
-        
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Invalid input. Please enter a number." << endl;
+        if (!renderer->read(choice)) {
+            renderer->skipLine();
+            renderer->out() << "Invalid input. Please enter a number.\n";
             continue;
         }
         
@@ -43,61 +125,92 @@ void Game::run() {
                 startNewGame();
                 break;
             case 2:
+                selectSaveSlot();
                 if (saveManager->saveExists()) {
                     loadGame();
                 } else {
-                    cout << "No save file found!" << endl;
+                    renderer->out() << "No save file found!\n";
                 }
                 break;
             case 3:
-                if (currentLevel > 1 || (player->getGold() > 0 || !player->getEquipment().empty() || !potionManager->getAllPotions().empty())) {
-                    if (saveManager->saveGame(player, potionManager, currentLevel, difficulty)) {
-                        cout << "Game saved automatically. Thank you for playing Fight to Monsters! Goodbye!" << endl;
+                if (currentLevel > 1 || (player->getGold() > 0 || !player->getEquipment().empty() || !potionManager->isEmpty())) {
+                    if (saveAndWait(currentLevel)) {
+                        renderer->out() << "Game saved automatically. Thank you for playing Fight to Monsters! Goodbye!\n";
                     } else {
-                        cout << "Failed to save game. Thank you for playing Fight to Monsters! Goodbye!" << endl;
+                        renderer->out() << "Failed to save game. Thank you for playing Fight to Monsters! Goodbye!\n";
                     }
                 } else {
-                    cout << "Thank you for playing Fight to Monsters! Goodbye!" << endl;
+                    renderer->out() << "Thank you for playing Fight to Monsters! Goodbye!\n";
                 }
                 gameOver = true;
                 break;
             default:
-                cout << "Invalid choice. Please select 1-3." << endl;
+                renderer->out() << "Invalid choice. Please select 1-3.\n";
                 break;
         }
     }
 }
 
 void Game::displayMainMenu() const {
-    cout << "\n========================================" << endl;
-    cout << "      Fight to Monsters" << endl;
-    cout << "========================================" << endl;
-    cout << "1. New Game" << endl;
-    cout << "2. Load Game" << endl;
-    cout << "3. Exit" << endl;
-    cout << "========================================" << endl;
-    cout << "Select option (1-3): ";
+    renderer->out() << "\n========================================\n";
+    renderer->out() << "      Fight to Monsters\n";
+    renderer->out() << "========================================\n";
+    renderer->out() << "1. New Game\n";
+    renderer->out() << "2. Load Game\n";
+    renderer->out() << "3. Exit\n";
+    renderer->out() << "========================================\n";
+    renderer->out() << "Select option (1-3): ";
 }
 
 int Game::selectDifficulty() {
-    cout << "\n=== Select Difficulty ===" << endl;
-    cout << "1. Easy (Player acts first)" << endl;
-    cout << "2. Hard (Enemy acts first, negative events possible)" << endl;
-    cout << "Select difficulty (1-2): ";
+    renderer->out() << "\n=== Select Difficulty ===\n";
+    renderer->out() << "1. Easy (Player acts first)\n";
+    renderer->out() << "2. Hard (Enemy acts first, negative events possible)\n";
+    renderer->out() << "Select difficulty (1-2): ";
     
     int choice;
-    cin >> choice;
-    
-    if (cin.fail() || (choice != 1 && choice != 2)) {
-        cin.clear();
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        cout << "Invalid choice. Defaulting to Easy." << endl;
+    if (!renderer->read(choice) || (choice != 1 && choice != 2)) {
+        renderer->skipLine();
+        renderer->out() << "Invalid choice. Defaulting to Easy.\n";
         return 0;
     }
     
     return choice - 1;
 }
 
+void Game::selectSaveSlot() {
+    autosave->flush();
+    renderer->out() << "\n=== Select Save Slot ===\n";
+    for (int slot = 1; slot <= SAVE_SLOT_COUNT; slot++) {
+        SaveManager slotSave(savePrefix + SaveManager::getSlotFileName(slot));
+        Player slotPlayer;
+        PotionManager slotPotions;
+        int slotLevel = 1;
+        int slotDifficulty = 0;
+        
+        renderer->out() << slot << ". ";
+        if (slotSave.saveExists() && slotSave.loadGame(&slotPlayer, &slotPotions, slotLevel, slotDifficulty)) {
+            renderer->out() << "Level " << slotLevel << " (" << (slotDifficulty == 0 ? "Easy" : "Hard") << ")\n";
+        } else {
+            renderer->out() << "Empty\n";
+        }
+    }
+    renderer->out() << "Select slot (1-" << SAVE_SLOT_COUNT << "): ";
+    
+    int choice;
+    while (!renderer->read(choice) || choice < 1 || choice > SAVE_SLOT_COUNT) {
+        renderer->skipLine();
+        renderer->out() << "Invalid choice. Select slot (1-" << SAVE_SLOT_COUNT << "): ";
+    }
+    
+    saveSlot = choice;
+    delete autosave;
+    delete saveManager;
+    saveManager = new SaveManager(savePrefix + SaveManager::getSlotFileName(saveSlot));
+    saveManager->setDurable(durableSaves);
+    autosave = new Autosave(saveManager);
+}
+
 void Game::startNewGame() {
     delete player;
     delete potionManager;
@@ -107,58 +220,79 @@ void Game::startNewGame() {
     currentLevel = 1;
     difficulty = selectDifficulty();
     eventManager->setHardMode(difficulty == 1);
+    selectSaveSlot();
+    autosave->startOver();
     gameWon = false;
     enemyDoubleHP = false;
     disabledEquipment = "";
     
-    cout << "\n=== New Game Started ===" << endl;
-    cout << "Difficulty: " << (difficulty == 0 ? "Easy" : "Hard") << endl;
-    cout << "Your journey begins..." << endl;
+    renderer->out() << "\n=== New Game Started ===\n";
+    renderer->out() << "Difficulty: " << (difficulty == 0 ? "Easy" : "Hard") << '\n';
+    renderer->out() << "Save slot: " << saveSlot << '\n';
+    renderer->out() << "Your journey begins...\n";
     
     gameLoop();
 }
 
 void Game::loadGame() {
-    cout << "\nLoading game..." << endl;
+    renderer->out() << "\nLoading game...\n";
     
     delete player;
     delete potionManager;
     player = new Player();
     potionManager = new PotionManager();
     
-    if (saveManager->loadGame(player, potionManager, currentLevel, difficulty)) {
+    int resumeLevel = 0;
+    vector<int> checkpoints = saveManager->getCheckpointLevels();
+    if (!checkpoints.empty()) {
+        renderer->out() << "Checkpoints at levels:";
+        for (int level : checkpoints) {
+            renderer->out() << " " << level;
+        }
+        renderer->out() << '\n';
+        renderer->out() << "Resume from level (0 for last save): ";
+        if (!renderer->read(resumeLevel)) {
+            renderer->skipLine();
+            resumeLevel = 0;
+        }
+    }
+    
+    bool loaded = resumeLevel > 0
+        ? saveManager->loadCheckpoint(resumeLevel, player, potionManager, currentLevel, difficulty)
+        : saveManager->loadGame(player, potionManager, currentLevel, difficulty);
+    if (loaded) {
         eventManager->setHardMode(difficulty == 1);
         player->restoreToFull();
-        cout << "Game loaded successfully!" << endl;
-        cout << "Current Level: " << currentLevel << endl;
-        cout << "Difficulty: " << (difficulty == 0 ? "Easy" : "Hard") << endl;
+        renderer->out() << "Game loaded successfully!\n";
+        renderer->out() << "Current Level: " << currentLevel << '\n';
+        renderer->out() << "Difficulty: " << (difficulty == 0 ? "Easy" : "Hard") << '\n';
         gameLoop();
     } else {
-        cout << "Failed to load game!" << endl;
+        renderer->out() << "Failed to load game!\n";
     }
 }
 
 void Game::gameLoop() {
     while (currentLevel <= Level::getTotalLevels() && !gameOver) {
-        cout << "\n========================================" << endl;
-        cout << "           LEVEL " << currentLevel << "/" << Level::getTotalLevels() << endl;
-        cout << "========================================" << endl;
+        renderer->out() << "\n========================================\n";
+        renderer->out() << "           LEVEL " << currentLevel << "/" << Level::getTotalLevels() << '\n';
+        renderer->out() << "========================================\n";
         
         player->restoreToFull();
         displayPlayerStatus();
         
         Level level = Level::createLevel(currentLevel);
         
-        if (level.getType() == "battle") {
+        if (level.isBattle()) {
             bool won = processBattleLevel(level);
             if (!won) {
-                cout << "\nGame Over! You have been defeated." << endl;
-                cout << "You reached Level " << currentLevel << "." << endl;
+                renderer->out() << "\nGame Over! You have been defeated.\n";
+                renderer->out() << "You reached Level " << currentLevel << ".\n";
                 gameOver = true;
                 break;
             }
             handleLevelRewards();
-        } else if (level.getType() == "event") {
+        } else {
             processEventLevel(level);
         }
         
@@ -167,18 +301,21 @@ void Game::gameLoop() {
             break;
         }
         
-        cout << "\n=== What would you like to do? ===" << endl;
-        cout << "1. Continue to next level" << endl;
-        cout << "2. Visit shop" << endl;
-        cout << "3. Exit game (auto-save)" << endl;
-        cout << "Select option (1-3): ";
+        // Autosave: the save file and a checkpoint are written in the background while the game goes on
+        if (currentLevel < Level::getTotalLevels() &&
+            !autosave->submit(player, potionManager, currentLevel + 1, difficulty, true)) {
+            renderer->out() << "Warning: An earlier autosave failed to write.\n";
+        }
         
-        int choice;
-        cin >> choice;
+        renderer->out() << "\n=== What would you like to do? ===\n";
+        renderer->out() << "1. Continue to next level\n";
+        renderer->out() << "2. Visit shop\n";
+        renderer->out() << "3. Exit game (auto-save)\n";
+        renderer->out() << "Select option (1-3): ";
         
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        int choice;
+        if (!renderer->read(choice)) {
+            renderer->skipLine();
             choice = 1;
         }
         
@@ -188,13 +325,13 @@ void Game::gameLoop() {
                 player->restoreToFull();
                 break;
             case 2:
-                shop->open(player);
+                shop->open(player, renderer);
                 break;
             case 3:
-                if (saveManager->saveGame(player, potionManager, currentLevel + 1, difficulty)) {
-                    cout << "Game saved automatically. Thank you for playing Fight to Monsters! Goodbye!" << endl;
+                if (saveAndWait(currentLevel + 1)) {
+                    renderer->out() << "Game saved automatically. Thank you for playing Fight to Monsters! Goodbye!\n";
                 } else {
-                    cout << "Failed to save game. Thank you for playing Fight to Monsters! Goodbye!" << endl;
+                    renderer->out() << "Failed to save game. Thank you for playing Fight to Monsters! Goodbye!\n";
                 }
                 gameOver = true;
                 break;
@@ -207,25 +344,25 @@ void Game::gameLoop() {
 }
 
 bool Game::processBattleLevel(const Level& level) {
-    cout << "\n=== BATTLE LEVEL ===" << endl;
-    cout << "Enemies: ";
+    renderer->out() << "\n=== BATTLE LEVEL ===\n";
+    renderer->out() << "Enemies: ";
     auto enemies = level.getEnemies();
     for (size_t i = 0; i < enemies.size(); i++) {
-        cout << enemies[i];
-        if (i < enemies.size() - 1) cout << ", ";
+        renderer->out() << enemies[i];
+        if (i < enemies.size() - 1) renderer->out() << ", ";
     }
-    cout << endl;
+    renderer->out() << '\n';
     
     if (enemyDoubleHP) {
-        cout << "Warning: Enemies have double HP in this battle!" << endl;
+        renderer->out() << "Warning: Enemies have double HP in this battle!\n";
     }
     if (!disabledEquipment.empty()) {
-        cout << "Warning: Your " << disabledEquipment << " equipment is disabled in this battle!" << endl;
+        renderer->out() << "Warning: Your " << disabledEquipment << " equipment is disabled in this battle!\n";
     }
     
     bool playerFirst = (difficulty == 0);
-    Battle battle(player, potionManager, enemies, playerFirst, enemyDoubleHP, disabledEquipment);
-    bool won = battle.execute();
+    Battle battle(player, potionManager, rng, level, playerFirst, enemyDoubleHP, disabledEquipment);
+    bool won = battle.execute(*battlePolicy, battleSink);
     
     enemyDoubleHP = false;
     disabledEquipment = "";
@@ -234,80 +371,76 @@ bool Game::processBattleLevel(const Level& level) {
 }
 
 void Game::processEventLevel(const Level& level) {
-    cout << "\n=== EVENT LEVEL ===" << endl;
+    renderer->out() << "\n=== EVENT LEVEL ===\n";
     string eventDescription = eventManager->executeRandomEvent(player, potionManager, 
                                                                  enemyDoubleHP, disabledEquipment);
-    cout << eventDescription << endl;
+    renderer->out() << eventDescription << '\n';
     
     displayPlayerStatus();
 }
 
 void Game::displayPlayerStatus() const {
-    cout << "\n=== Player Status ===" << endl;
-    cout << "HP: " << player->getCurrentHealth() << "/" << player->getMaxHealth() << endl;
-    cout << "Attack: " << player->getAttack() << endl;
-    cout << "Gold: " << player->getGold() << endl;
+    if (renderer->isQuiet()) return;
+    
+    renderer->out() << "\n=== Player Status ===\n";
+    renderer->out() << "HP: " << player->getCurrentHealth() << "/" << player->getMaxHealth() << '\n';
+    renderer->out() << "Attack: " << player->getAttack() << '\n';
+    renderer->out() << "Gold: " << player->getGold() << '\n';
     
     auto equipment = player->getEquipment();
     if (!equipment.empty()) {
-        cout << "Equipment: ";
+        renderer->out() << "Equipment: ";
         for (size_t i = 0; i < equipment.size(); i++) {
-            cout << equipment[i];
-            if (i < equipment.size() - 1) cout << ", ";
+            renderer->out() << equipment[i];
+            if (i < equipment.size() - 1) renderer->out() << ", ";
         }
-        cout << endl;
+        renderer->out() << '\n';
     }
     
-    auto potions = potionManager->getAllPotions();
+    PotionView potions = potionManager->getAllPotions();
     if (!potions.empty()) {
-        cout << "Potions: ";
+        renderer->out() << "Potions: ";
         bool first = true;
-        for (const auto& pair : potions) {
-            if (!first) cout << ", ";
-            cout << pair.first << " x" << pair.second;
+        for (PotionStack stack : potions) {
+            if (!first) renderer->out() << ", ";
+            renderer->out() << stack.name << " x" << stack.quantity;
             first = false;
         }
-        cout << endl;
+        renderer->out() << '\n';
     }
-    cout << "====================\n" << endl;
+    renderer->out() << "====================\n\n";
 }
 
 void Game::handleLevelRewards() {
-    string randomPotion = PotionManager::getRandomPotion();
+    string randomPotion = PotionManager::getRandomPotion(*rng);
     potionManager->addPotion(randomPotion, 1);
-    cout << "\n=== Level Complete! ===" << endl;
-    cout << "Reward: " << randomPotion << " x1" << endl;
+    renderer->out() << "\n=== Level Complete! ===\n";
+    renderer->out() << "Reward: " << randomPotion << " x1\n";
     
-    if (currentLevel == 4 || currentLevel == 8) {
-        string randomEquipment = getRandomEquipment();
+    if (Level::awardsEquipment(currentLevel)) {
+        string randomEquipment = Player::getRandomEquipment(*rng);
         if (player->addEquipment(randomEquipment)) {
-            cout << "Bonus Reward: " << randomEquipment << " equipment!" << endl;
+            renderer->out() << "Bonus Reward: " << randomEquipment << " equipment!\n";
         } else {
-            cout << "Bonus Reward: " << randomEquipment << " equipment found, but your equipment inventory is full!" << endl;
+            renderer->out() << "Bonus Reward: " << randomEquipment << " equipment found, but your equipment inventory is full!\n";
         }
     }
 }
 
-string Game::getRandomEquipment() const {
-    vector<string> equipmentTypes = {"Shield", "Sword", "Armor", "Shoes"};
-    int index = rand() % equipmentTypes.size();
-    return equipmentTypes[index];
-}
-
 void Game::handleGameCompletion() {
-    cout << "\n========================================" << endl;
-    cout << "        CONGRATULATIONS!" << endl;
-    cout << "========================================" << endl;
-    cout << "You have completed all 12 levels!" << endl;
-    cout << "You earned 1 gold coin!" << endl;
+    renderer->out() << "\n========================================\n";
+    renderer->out() << "        CONGRATULATIONS!\n";
+    renderer->out() << "========================================\n";
+    renderer->out() << "You have completed all 12 levels!\n";
+    renderer->out() << "You earned 1 gold coin!\n";
     player->addGold(1);
     gameWon = true;
     
-    cout << "\nWould you like to visit the shop? (y/n): ";
+    renderer->out() << "\nWould you like to visit the shop? (y/n): ";
     char choice;
-    cin >> choice;
+    renderer->read(choice);
     if (choice == 'y' || choice == 'Y') {
-        shop->open(player);
+        shop->open(player, renderer);
     }
     
     gameOver = true;
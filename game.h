@@ -8,43 +8,82 @@
 #include "event.h"
 #include "shop.h"
 #include "save.h"
+#include "autosave.h"
+#include "console.h"
+#include "renderer.h"
+#include "replay.h"
+
+// Campaign state between battles as plain values (trivially copyable): level, difficulty, pending event
+// effects, player, potions and random generator. Together with a BattleSnapshot it covers a whole game.
+struct GameSnapshot {
+    int32_t currentLevel;
+    int32_t difficulty;
+    uint8_t gameOver;
+    uint8_t gameWon;
+    uint8_t enemyDoubleHP;
+    EquipmentType disabledEquipment;
+    PlayerSnapshot player;
+    PotionSnapshot potions;
+    uint64_t random[4];
+};
+
+static_assert(std::is_trivially_copyable<GameSnapshot>::value, "GameSnapshot must stay trivially copyable");
 
 class Game {
 private:
+    Renderer* renderer;
+    Random* rng;
     Player* player;
     PotionManager* potionManager;
     EventManager* eventManager;
     Shop* shop;
     SaveManager* saveManager;
+    Autosave* autosave;
+    ConsoleBattlePolicy* battlePolicy;
+    ConsoleBattleSink* battleSink;
+    std::string savePrefix;
     
     int currentLevel;
     int difficulty;
+    int saveSlot;
+    bool durableSaves;
     bool gameOver;
     bool gameWon;
     bool enemyDoubleHP;
     std::string disabledEquipment;
     
-    // What it does: Displays main menu with options (New Game, Load Game, Exit)
+    // What it does: Saves the game through the autosave writer and waits until the save is on disk (used when the player exits)
+    // Inputs: resumeLevel - level the save resumes at
+    // Outputs: Returns true if the save and every autosave before it were written, false otherwise
+    bool saveAndWait(int resumeLevel);
+    
+    // What it does: Shows the main menu until the player exits
     // Inputs: None
     // Outputs: None
-    void displayMainMenu() const;
+    void menuLoop();
     
-    // What it does: Returns a random equipment type name
+    // What it does: Displays main menu with options (New Game, Load Game, Exit)
     // Inputs: None
-    // Outputs: Name of random equipment (string)
-    std::string getRandomEquipment() const;
+    // Outputs: None
+    void displayMainMenu() const;
     
     // What it does: Prompts player to select difficulty level
     // Inputs: None
     // Outputs: Selected difficulty (0=easy, 1=hard) (int)
     int selectDifficulty();
     
-    // What it does: Starts a new game, resets player and initializes game state
+    // What it does: Lists the save slots and switches the save manager to the one the player picks (asks again on invalid input)
+    // Inputs: None
+    // Outputs: None
+    void selectSaveSlot();
+    
+    // What it does: Starts a new game, resets player and initializes game state (the chosen slot's old save and
+    // checkpoints are kept until the new run's first save replaces them)
     // Inputs: None
     // Outputs: None
     void startNewGame();
     
-    // What it does: Loads existing game from save file
+    // What it does: Loads existing game from the selected slot, from its last save or from a level checkpoint
     // Inputs: None
     // Outputs: None
     void loadGame();
@@ -64,7 +103,7 @@ private:
     // Outputs: None
     void processEventLevel(const Level& level);
     
-    // What it does: Displays player status including HP, attack, gold, equipment, and potions
+    // What it does: Displays player status including HP, attack, gold, equipment, and potions (skipped in quiet mode)
     // Inputs: None
     // Outputs: None
     void displayPlayerStatus() const;
@@ -81,19 +120,56 @@ private:
     
 public:
     // What it does: Initializes game systems and sets up random number generation
-    // Inputs: None
+    // Inputs: seed - seed of the session's random number generator (equal seeds and inputs replay the same game), quiet - true to skip all output
     // Outputs: None
-    Game();
+    Game(uint64_t seed = Random::randomSeed(), bool quiet = false);
+    
+    // What it does: Initializes a game session that talks through the given streams instead of the terminal
+    // Inputs: input - stream player input is read from, output - stream game text is written to, seed - seed of the session's random number generator, quiet - true to skip all output, savePrefix - prefix of this session's save file names (e.g. a directory)
+    // Outputs: None
+    Game(std::istream& input, std::ostream& output, uint64_t seed, bool quiet = false, const std::string& savePrefix = "");
     
     // What it does: Cleans up game resources and deallocates memory
     // Inputs: None
     // Outputs: None
     ~Game();
     
-    // What it does: Starts the game and runs main menu loop
+    // What it does: Starts the game and runs main menu loop until the player exits or the input ends
+    // (the last frame is written out before it returns)
     // Inputs: None
     // Outputs: None
     void run();
+    
+    // What it does: Records every choice the player makes into a replay
+    // Inputs: recorder - replay recorder (nullptr to stop recording)
+    // Outputs: None
+    void setRecorder(ReplayRecorder* recorder);
+    
+    // What it does: Reads the player's choices from a command script instead of the input stream (batch mode)
+    // Inputs: script - command script (nullptr to read the input stream again)
+    // Outputs: None
+    void setScript(CommandScript* script);
+    
+    // What it does: Turns the fsyncs of this game's saves on or off (replays switch them off to run at full speed)
+    // Inputs: durable - true to flush every save to disk (default), false to only write it
+    // Outputs: None
+    void setDurableSaves(bool durable);
+    
+    // What it does: Computes a CRC-32 over the whole game state (level, difficulty, player stats, equipment,
+    // potions and random generator state), used to check that a replay ends exactly like the recorded game
+    // Inputs: None
+    // Outputs: Checksum (uint32_t)
+    uint32_t getStateChecksum() const;
+    
+    // What it does: Copies the campaign state into a snapshot
+    // Inputs: snapshot - snapshot to fill
+    // Outputs: None
+    void saveSnapshot(GameSnapshot& snapshot) const;
+    
+    // What it does: Puts the campaign back into the state of a snapshot (the save slot in use is kept)
+    // Inputs: snapshot - snapshot taken with saveSnapshot
+    // Outputs: None
+    void restoreSnapshot(const GameSnapshot& snapshot);
 };
 
 #endif
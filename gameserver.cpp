@@ -0,0 +1,163 @@
+#include "gameserver.h"
+#include "rng.h"
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+using namespace std;
+
+namespace {
+    const int MAX_EVENTS = 256;
+    const int LISTEN_BACKLOG = 4096;
+}
+
+GameServer::GameServer(uint64_t seed, const string& savePrefix)
+    : listenFd(-1), epollFd(-1), seed(seed), savePrefix(savePrefix), nextSessionId(1), finishedSessions(0) {
+}
+
+GameServer::~GameServer() {
+    for (auto& pair : sessions) {
+        delete pair.second;
+    }
+    sessions.clear();
+    if (epollFd >= 0) close(epollFd);
+    if (listenFd >= 0) close(listenFd);
+    if (!unixPath.empty()) unlink(unixPath.c_str());
+}
+
+bool GameServer::setupEpoll() {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        cerr << "Error: epoll_create1 failed: " << strerror(errno) << endl;
+        return false;
+    }
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) == 0;
+}
+
+bool GameServer::listenUnix(const string& path) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        cerr << "Error: Socket path is too long." << endl;
+        return false;
+    }
+    strcpy(address.sun_path, path.c_str());
+    unlink(path.c_str());
+    
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(listenFd, LISTEN_BACKLOG) != 0) {
+        cerr << "Error: Cannot listen on " << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    unixPath = path;
+    return setupEpoll();
+}
+
+bool GameServer::listenTcp(const string& host, int port) {
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        cerr << "Error: Invalid address " << host << endl;
+        return false;
+    }
+    
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    if (listenFd >= 0) setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(listenFd, LISTEN_BACKLOG) != 0) {
+        cerr << "Error: Cannot listen on " << host << ":" << port << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return setupEpoll();
+}
+
+void GameServer::acceptSessions() {
+    while (true) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                cerr << "Error: accept failed: " << strerror(errno) << endl;
+            }
+            return;
+        }
+        
+        int id = nextSessionId++;
+        GameSession* session = new GameSession(fd, id, Random::deriveSeed(seed, id), savePrefix);
+        epoll_event event;
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0 || !session->start()) {
+            delete session;
+            continue;
+        }
+        sessions[fd] = session;
+        settle(session);
+    }
+}
+
+void GameServer::settle(GameSession* session) {
+    bool outputLeft = session->hasPendingOutput() && !session->flush();
+    if (session->isFinished() && (!outputLeft || session->isConnectionLost())) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, session->getFd(), nullptr);
+        sessions.erase(session->getFd());
+        delete session;
+        finishedSessions++;
+        return;
+    }
+    
+    epoll_event event;
+    event.events = (session->isFinished() ? 0u : (uint32_t)(EPOLLIN | EPOLLRDHUP)) | (outputLeft ? (uint32_t)EPOLLOUT : 0u);
+    event.data.fd = session->getFd();
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, session->getFd(), &event);
+}
+
+void GameServer::run(long long maxSessions) {
+    epoll_event events[MAX_EVENTS];
+    while (maxSessions == 0 || finishedSessions < maxSessions) {
+        int count = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            cerr << "Error: epoll_wait failed: " << strerror(errno) << endl;
+            return;
+        }
+        
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptSessions();
+                continue;
+            }
+            
+            auto it = sessions.find(fd);
+            if (it == sessions.end()) continue;
+            GameSession* session = it->second;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                session->receive();
+            }
+            settle(session);
+        }
+    }
+}
+
+int GameServer::getActiveSessions() const {
+    return sessions.size();
+}
+
+long long GameServer::getFinishedSessions() const {
+    return finishedSessions;
+}
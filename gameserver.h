@@ -0,0 +1,74 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include "session.h"
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+// Single-process game server: accepts players on a Unix-domain or TCP socket and multiplexes
+// every session on one epoll loop (each session keeps its own Game, Player, PotionManager and EventManager)
+class GameServer {
+private:
+    int listenFd;
+    int epollFd;
+    uint64_t seed;
+    std::string savePrefix;
+    std::string unixPath;
+    int nextSessionId;
+    long long finishedSessions;
+    std::unordered_map<int, GameSession*> sessions;
+    
+    // What it does: Accepts every pending connection and starts a session for it
+    // Inputs: None
+    // Outputs: None
+    void acceptSessions();
+    
+    // What it does: Closes a finished session or updates which socket events it waits for
+    // Inputs: session - session that just did some work
+    // Outputs: None
+    void settle(GameSession* session);
+    
+    // What it does: Registers the listening socket with a new epoll instance
+    // Inputs: None
+    // Outputs: Returns true on success, false otherwise
+    bool setupEpoll();
+    
+public:
+    // What it does: Creates a server that is not listening yet
+    // Inputs: seed - base seed (session i plays with a seed derived from it), savePrefix - prefix of every player's save files (e.g. a directory)
+    // Outputs: None
+    GameServer(uint64_t seed, const std::string& savePrefix);
+    
+    // What it does: Closes every session and the listening socket
+    // Inputs: None
+    // Outputs: None
+    ~GameServer();
+    
+    // What it does: Starts listening on a Unix-domain socket (an old socket file at that path is replaced)
+    // Inputs: path - socket file path
+    // Outputs: Returns true on success, false otherwise
+    bool listenUnix(const std::string& path);
+    
+    // What it does: Starts listening on a TCP port
+    // Inputs: host - IPv4 address to bind (e.g. "127.0.0.1"), port - TCP port
+    // Outputs: Returns true on success, false otherwise
+    bool listenTcp(const std::string& host, int port);
+    
+    // What it does: Serves sessions until enough of them have finished
+    // Inputs: maxSessions - number of finished sessions after which the server stops (0 to run forever)
+    // Outputs: None
+    void run(long long maxSessions = 0);
+    
+    // What it does: Returns number of sessions currently connected
+    // Inputs: None
+    // Outputs: Active session count (int)
+    int getActiveSessions() const;
+    
+    // What it does: Returns number of sessions that have ended
+    // Inputs: None
+    // Outputs: Finished session count
+    long long getFinishedSessions() const;
+};
+
+#endif
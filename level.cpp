@@ -1,8 +1,60 @@
 #include "level.h"
+#include "rng.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
 using namespace std;
 
+namespace {
+    // One level of the level table, with its enemies already turned into type ids
+    struct LevelEntry {
+        LevelType type;
+        bool awardsEquipment;
+        int enemyCount;
+        EnemyType enemies[MAX_LEVEL_ENEMIES];
+    };
+    
+    // Levels of the original 12-level campaign (levels.cfg holds the same table as text)
+    const LevelEntry BUILT_IN_LEVELS[] = {
+        {LevelType::Battle, false, 1, {EnemyType::Slim}},
+        {LevelType::Battle, false, 2, {EnemyType::Slim, EnemyType::Slim}},
+        {LevelType::Event, false, 0, {}},
+        {LevelType::Battle, true, 1, {EnemyType::Batho}},
+        {LevelType::Battle, false, 2, {EnemyType::Batho, EnemyType::Slim}},
+        {LevelType::Battle, false, 3, {EnemyType::Batho, EnemyType::Slim, EnemyType::Slim}},
+        {LevelType::Event, false, 0, {}},
+        {LevelType::Battle, true, 2, {EnemyType::Batho, EnemyType::Batho}},
+        {LevelType::Battle, false, 3, {EnemyType::Batho, EnemyType::Batho, EnemyType::Slim}},
+        {LevelType::Battle, false, 3, {EnemyType::Batho, EnemyType::Batho, EnemyType::Batho}},
+        {LevelType::Event, false, 0, {}},
+        {LevelType::Battle, false, 1, {EnemyType::Boss}}
+    };
+    
+    // Level table used by Level::createLevel (flat, indexed by level number - 1)
+    vector<LevelEntry> levelTable(begin(BUILT_IN_LEVELS), end(BUILT_IN_LEVELS));
+    
+    // Seed of the endless level generator
+    const uint64_t ENDLESS_SEED = 0x454E444C455353ULL;
+    
+    // Length of one endless cycle (events at 3, 7 and 11, boss at 12, like the built-in table)
+    const int ENDLESS_CYCLE = 12;
+}
+
 Level::Level(int number, const std::string& type, const std::vector<std::string>& enemyTypes)
-    : levelNumber(number), levelType(type), enemies(enemyTypes) {
+    : levelNumber(number), levelType(type == "event" ? LevelType::Event : LevelType::Battle),
+      equipmentReward(false), enemyCount(0) {
+    for (const auto& name : enemyTypes) {
+        EnemyType enemy;
+        if (enemyCount < MAX_LEVEL_ENEMIES && parseEnemyType(name, enemy)) {
+            enemies[enemyCount++] = enemy;
+        }
+    }
+}
+
+Level::Level(int number, LevelType type, bool awardsEquipment, const EnemyType* types, int count)
+    : levelNumber(number), levelType(type), equipmentReward(awardsEquipment), enemyCount(min(count, MAX_LEVEL_ENEMIES)) {
+    copy(types, types + enemyCount, enemies);
 }
 
 Level::~Level() {
@@ -13,72 +65,130 @@ int Level::getNumber() const {
 }
 
 std::string Level::getType() const {
-    return levelType;
+    return levelType == LevelType::Event ? "event" : "battle";
+}
+
+bool Level::isBattle() const {
+    return levelType == LevelType::Battle;
 }
 
 std::vector<std::string> Level::getEnemies() const {
-    return enemies;
+    vector<string> names;
+    for (int i = 0; i < enemyCount; i++) {
+        names.push_back(getEnemyTypeName(enemies[i]));
+    }
+    return names;
+}
+
+int Level::getEnemyCount() const {
+    return enemyCount;
+}
+
+EnemyType Level::getEnemyType(int index) const {
+    return enemies[index];
+}
+
+bool Level::awardsEquipment() const {
+    return equipmentReward;
 }
 
 Level Level::createLevel(int levelNum) {
-    vector<string> enemies;
-    string type;
+    if (levelNum >= 1 && levelNum <= (int)levelTable.size()) {
+        const LevelEntry& entry = levelTable[levelNum - 1];
+        return Level(levelNum, entry.type, entry.awardsEquipment, entry.enemies, entry.enemyCount);
+    }
+    return generateLevel(levelNum);
+}
+
+Level Level::generateLevel(int levelNum) {
+    int position = (levelNum - 1) % ENDLESS_CYCLE + 1;
+    bool equipment = position == 4 || position == 8;
+    EnemyType enemies[MAX_LEVEL_ENEMIES];
     
-    switch (levelNum) {
-        case 1:
-            type = "battle";
-            enemies = {"Slim"};
-            break;
-        case 2:
-            type = "battle";
-            enemies = {"Slim", "Slim"};
-            break;
-        case 3:
-            type = "event";
-            break;
-        case 4:
-            type = "battle";
-            enemies = {"Batho"};
-            break;
-        case 5:
-            type = "battle";
-            enemies = {"Batho", "Slim"};
-            break;
-        case 6:
-            type = "battle";
-            enemies = {"Batho", "Slim", "Slim"};
-            break;
-        case 7:
-            type = "event";
-            break;
-        case 8:
-            type = "battle";
-            enemies = {"Batho", "Batho"};
-            break;
-        case 9:
-            type = "battle";
-            enemies = {"Batho", "Batho", "Slim"};
-            break;
-        case 10:
-            type = "battle";
-            enemies = {"Batho", "Batho", "Batho"};
-            break;
-        case 11:
-            type = "event";
-            break;
-        case 12:
-            type = "battle";
-            enemies = {"Boss"};
-            break;
-        default:
-            type = "battle";
-            enemies = {};
-            break;
+    if (position == ENDLESS_CYCLE) {
+        enemies[0] = EnemyType::Boss;
+        return Level(levelNum, LevelType::Battle, equipment, enemies, 1);
+    }
+    if (position % 4 == 3) {
+        return Level(levelNum, LevelType::Event, equipment, nullptr, 0);
     }
     
-    return Level(levelNum, type, enemies);
+    // Each cycle makes Batho and Goust more likely
+    Random rng(Random::deriveSeed(ENDLESS_SEED, (uint64_t)levelNum));
+    int depth = (levelNum - 1) / ENDLESS_CYCLE;
+    int goustChance = min(30, 5 * depth);
+    int bathoChance = min(100 - goustChance, 30 + 10 * depth);
+    int count = 1 + rng.nextInt(MAX_LEVEL_ENEMIES);
+    for (int i = 0; i < count; i++) {
+        int roll = rng.nextInt(100);
+        if (roll < goustChance) {
+            enemies[i] = EnemyType::Goust;
+        } else if (roll < goustChance + bathoChance) {
+            enemies[i] = EnemyType::Batho;
+        } else {
+            enemies[i] = EnemyType::Slim;
+        }
+    }
+    return Level(levelNum, LevelType::Battle, equipment, enemies, count);
+}
+
+bool Level::awardsEquipment(int levelNum) {
+    return createLevel(levelNum).awardsEquipment();
 }
 
 int Level::getTotalLevels() {
-    return 12;
+    return (int)levelTable.size();
+}
+
+bool Level::loadTable(const std::string& fileName, std::string& error) {
+    ifstream file(fileName);
+    if (!file) {
+        error = "cannot open " + fileName;
+        return false;
+    }
+    
+    vector<LevelEntry> table;
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) {
+            line.erase(comment);
+        }
+        istringstream words(line);
+        string word;
+        if (!(words >> word)) continue;
+        
+        LevelEntry entry = {LevelType::Battle, false, 0, {}};
+        if (word == "event") {
+            entry.type = LevelType::Event;
+        } else if (word != "battle") {
+            error = fileName + ":" + to_string(lineNumber) + ": unknown level type \"" + word + "\"";
+            return false;
+        }
+        while (words >> word) {
+            EnemyType enemy;
+            if (word == "+equipment") {
+                entry.awardsEquipment = true;
+            } else if (entry.type == LevelType::Battle && parseEnemyType(word, enemy) && entry.enemyCount < MAX_LEVEL_ENEMIES) {
+                entry.enemies[entry.enemyCount++] = enemy;
+            } else {
+                error = fileName + ":" + to_string(lineNumber) + ": unexpected \"" + word + "\"";
+                return false;
+            }
+        }
+        if (entry.type == LevelType::Battle && entry.enemyCount == 0) {
+            error = fileName + ":" + to_string(lineNumber) + ": battle level without enemies";
+            return false;
+        }
+        table.push_back(entry);
+    }
+    
+    if (table.empty()) {
+        error = fileName + ": no levels";
+        return false;
+    }
+    levelTable.swap(table);
+    return true;
 }
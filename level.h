@@ -1,21 +1,41 @@
 #ifndef LEVEL_H
 #define LEVEL_H
 
+#include "enemy.h"
 #include <string>
 #include <vector>
 
+// Most enemies a level can start with (same as Battle::MAX_ENEMIES)
+const int MAX_LEVEL_ENEMIES = 3;
+
+// Kinds of levels
+enum class LevelType : unsigned char {
+    Battle,
+    Event
+};
+
+// One level of the campaign. Levels 1 to getTotalLevels() come from the level table (built in, or
+// loaded from a config file with loadTable); later levels are generated on demand for endless runs.
 class Level {
 private:
     int levelNumber;
-    std::string levelType;
-    std::vector<std::string> enemies;
+    LevelType levelType;
+    bool equipmentReward;
+    int enemyCount;
+    EnemyType enemies[MAX_LEVEL_ENEMIES];
     
 public:
     // What it does: Creates a level with given number, type, and enemy types
-    // Inputs: number - level number (1-12), type - level type ("battle" or "event"), enemyTypes - vector of enemy types for battle levels
+    // Inputs: number - level number, type - level type ("battle" or "event"), enemyTypes - vector of enemy types for battle levels
     // Outputs: None
     Level(int number, const std::string& type, const std::vector<std::string>& enemyTypes);
     
+    // What it does: Creates a level from enemy type ids
+    // Inputs: number - level number, type - level type, awardsEquipment - true if completing it awards equipment,
+    //         types - enemy type ids, count - number of enemies (at most MAX_LEVEL_ENEMIES are kept)
+    // Outputs: None
+    Level(int number, LevelType type, bool awardsEquipment, const EnemyType* types, int count);
+    
     // What it does: Cleans up level resources
     // Inputs: None
     // Outputs: None
@@ -23,7 +43,7 @@ public:
     
     // What it does: Returns level number
     // Inputs: None
-    // Outputs: Level number (1-12) (int)
+    // Outputs: Level number (int)
     int getNumber() const;
     
     // What it does: Returns level type
@@ -31,20 +51,59 @@ public:
     // Outputs: Level type string ("battle" or "event")
     std::string getType() const;
     
+    // What it does: Checks if the level is a battle
+    // Inputs: None
+    // Outputs: Returns true for battle levels, false for event levels
+    bool isBattle() const;
+    
     // What it does: Returns enemy types for battle level
     // Inputs: None
     // Outputs: Vector of enemy type strings
     std::vector<std::string> getEnemies() const;
     
+    // What it does: Returns number of enemies the level starts with
+    // Inputs: None
+    // Outputs: Enemy count (int, 0 for event levels)
+    int getEnemyCount() const;
+    
+    // What it does: Returns type id of one enemy
+    // Inputs: index - enemy index (0 to getEnemyCount() - 1)
+    // Outputs: Enemy type
+    EnemyType getEnemyType(int index) const;
+    
+    // What it does: Checks if completing this level awards a bonus piece of equipment
+    // Inputs: None
+    // Outputs: Returns true if it does, false otherwise
+    bool awardsEquipment() const;
+    
     // What it does: Creates level definition based on level number
-    // Inputs: levelNum - level number (1-12)
+    // Inputs: levelNum - level number (from the level table up to getTotalLevels(), generated after that)
     // Outputs: Level object for the specified level
     static Level createLevel(int levelNum);
     
+    // What it does: Generates an endless level without stored state (the same number always gives the same level).
+    // Like the built-in table, every 12th level is a boss and levels 3, 7 and 11 of every 12 are events; other
+    // battles get 1-3 enemies, with Batho and Goust more likely the deeper the level
+    // Inputs: levelNum - level number
+    // Outputs: Generated level
+    static Level generateLevel(int levelNum);
+    
+    // What it does: Checks if completing a level awards a bonus piece of equipment
+    // Inputs: levelNum - level number
+    // Outputs: Returns true if the level awards equipment (levels 4 and 8 in the built-in table), false otherwise
+    static bool awardsEquipment(int levelNum);
+    
     // What it does: Returns total number of levels in the game
     // Inputs: None
-    // Outputs: Total number of levels (12) (int)
+    // Outputs: Number of levels in the level table (12 for the built-in table) (int)
     static int getTotalLevels();
+    
+    // What it does: Replaces the level table with the levels of a config file. Each line is one level:
+    // "battle" followed by 1-3 enemy names, or "event"; a trailing "+equipment" awards equipment, "#" starts a comment
+    // Inputs: fileName - config file to read, error - reference to store a message with the line number if the file is invalid
+    // Outputs: Returns true if the table was loaded, false if the file is missing or invalid (the table is unchanged)
+    // (call it before starting threads that create levels)
+    static bool loadTable(const std::string& fileName, std::string& error);
 };
 
 #endif
@@ -0,0 +1,203 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+using namespace std;
+
+// One simulated player: sends the whole input script, then reads game output until the server hangs up
+struct Client {
+    int fd;
+    size_t sent;
+    long long received;
+    chrono::steady_clock::time_point start;
+};
+
+// What it does: Prints command line usage of the load generator
+// Inputs: program - name the program was started with
+// Outputs: None
+static void printUsage(const char* program) {
+    cout << "Usage: " << program << " (--unix PATH | --tcp PORT [--host ADDR]) [--sessions N] [--concurrency C]"
+         << " [--difficulty easy|hard]" << endl;
+}
+
+// What it does: Builds the input a simulated player types: an empty name (guest, whose saves the server deletes
+// when the session ends), new game, difficulty, save slot 1, then "1" to every prompt
+// Inputs: hard - true to pick hard mode
+// Outputs: Input script (string)
+static string buildScript(bool hard) {
+    string script = hard ? "\n1\n2\n1\n" : "\n1\n1\n1\n";
+    for (int i = 0; i < 2000; i++) {
+        script += "1\n";
+    }
+    return script;
+}
+
+// What it does: Opens a non-blocking connection to the server
+// Inputs: unixPath - Unix socket path (empty for TCP), host - server address, port - server TCP port
+// Outputs: Socket file descriptor, or -1 on failure
+static int connectToServer(const string& unixPath, const string& host, int port) {
+    int fd;
+    int result;
+    if (!unixPath.empty()) {
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, unixPath.c_str(), sizeof(address.sun_path) - 1);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        result = connect(fd, (sockaddr*)&address, sizeof(address));
+    } else {
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, host.c_str(), &address.sin_addr);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        result = connect(fd, (sockaddr*)&address, sizeof(address));
+    }
+    if (result != 0) {
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// What it does: Entry point of the loopback load generator. Keeps C sessions open against the game server until N have finished.
+// Inputs: argc - argument count, argv - command line arguments
+// Outputs: Returns exit code (0 on success, 1 on bad arguments or connection errors)
+int main(int argc, char* argv[]) {
+    string unixPath;
+    string host = "127.0.0.1";
+    int port = 0;
+    long long sessions = 1000;
+    int concurrency = 100;
+    bool hard = false;
+    
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--unix") == 0 && hasValue) {
+            unixPath = argv[++i];
+        } else if (strcmp(argv[i], "--tcp") == 0 && hasValue) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--host") == 0 && hasValue) {
+            host = argv[++i];
+        } else if (strcmp(argv[i], "--sessions") == 0 && hasValue) {
+            sessions = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--concurrency") == 0 && hasValue) {
+            concurrency = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--difficulty") == 0 && hasValue) {
+            hard = string(argv[++i]) == "hard";
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (unixPath.empty() == (port == 0) || sessions <= 0 || concurrency <= 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    signal(SIGPIPE, SIG_IGN);
+    string script = buildScript(hard);
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    vector<Client> clients(concurrency);
+    vector<double> latencies;
+    latencies.reserve(sessions);
+    long long started = 0;
+    long long failed = 0;
+    long long totalBytes = 0;
+    int open = 0;
+    char buffer[65536];
+    
+    auto begin = chrono::steady_clock::now();
+    while ((long long)latencies.size() + failed < sessions) {
+        while (open < concurrency && started < sessions) {
+            int slot = 0;
+            while (clients[slot].fd > 0) slot++;
+            int fd = connectToServer(unixPath, host, port);
+            started++;
+            if (fd < 0) {
+                failed++;
+                continue;
+            }
+            clients[slot] = {fd, 0, 0, chrono::steady_clock::now()};
+            epoll_event event;
+            event.events = EPOLLIN | EPOLLOUT;
+            event.data.u32 = slot;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            open++;
+        }
+        if (open == 0) continue;
+        
+        epoll_event events[256];
+        int count = epoll_wait(epollFd, events, 256, 1000);
+        for (int i = 0; i < count; i++) {
+            Client& client = clients[events[i].data.u32];
+            bool done = false;
+            
+            if ((events[i].events & EPOLLOUT) && client.sent < script.size()) {
+                ssize_t written = send(client.fd, script.data() + client.sent, script.size() - client.sent, MSG_NOSIGNAL);
+                if (written > 0) client.sent += written;
+                if (client.sent == script.size() || (written < 0 && errno != EAGAIN)) {
+                    shutdown(client.fd, SHUT_WR);
+                    client.sent = script.size();
+                    epoll_event event;
+                    event.events = EPOLLIN;
+                    event.data.u32 = events[i].data.u32;
+                    epoll_ctl(epollFd, EPOLL_CTL_MOD, client.fd, &event);
+                }
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                while (true) {
+                    ssize_t got = read(client.fd, buffer, sizeof(buffer));
+                    if (got > 0) {
+                        client.received += got;
+                    } else {
+                        done = got == 0 || (errno != EAGAIN && errno != EINTR);
+                        break;
+                    }
+                }
+            }
+            
+            if (done) {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, client.fd, nullptr);
+                close(client.fd);
+                client.fd = 0;
+                open--;
+                totalBytes += client.received;
+                if (client.received > 0) {
+                    latencies.push_back(chrono::duration<double>(chrono::steady_clock::now() - client.start).count());
+                } else {
+                    failed++;
+                }
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    close(epollFd);
+    
+    sort(latencies.begin(), latencies.end());
+    double p50 = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+    double p99 = latencies.empty() ? 0 : latencies[min(latencies.size() - 1, latencies.size() * 99 / 100)];
+    cout << fixed << setprecision(1);
+    cout << "Sessions: " << latencies.size() << " completed, " << failed << " failed, " << concurrency << " concurrent" << endl;
+    cout << "Throughput: " << latencies.size() / seconds << " sessions/s, "
+         << totalBytes / seconds / (1024 * 1024) << " MiB/s of game output" << endl;
+    cout << setprecision(2) << "Session time: p50 " << p50 * 1000 << " ms, p99 " << p99 * 1000 << " ms" << endl;
+    return failed == 0 ? 0 : 1;
+}
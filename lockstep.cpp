@@ -0,0 +1,112 @@
+#include "lockstep.h"
+#include "lockstep_kernel.h"
+#include "rng.h"
+#include <algorithm>
+using namespace std;
+using namespace lockstep;
+
+void lockstep::runScalar(const KernelParams& p, const SeedBatch& batch, LockstepOutcome* outcomes) {
+    runBlocks<1>(p, batch, outcomes);
+}
+
+LockstepBattleKernel::LockstepBattleKernel(const Player& player, const vector<string>& enemyTypes,
+                                           bool playerFirst, bool enemyDoubleHP,
+                                           EquipmentType disabledEquip, KernelIsa isa)
+    : playerFirst(playerFirst), enemyDoubleHP(enemyDoubleHP), isa(isa) {
+    Player copy = player;
+    copy.setDisabledEquipment(disabledEquip);
+    const DerivedStats& stats = copy.getDerivedStats();
+    playerHealth = stats.maxHealth;
+    playerAttack = stats.attack;
+    damageMultiplier = stats.damageMultiplier;
+    extraActions = stats.extraActions;
+    
+    for (const auto& name : enemyTypes) {
+        EnemyType type;
+        if (parseEnemyType(name, type) && (int)this->enemyTypes.size() < ENEMY_SLOTS) {
+            this->enemyTypes.push_back(type);
+        }
+    }
+}
+
+void LockstepBattleKernel::run(const uint64_t* seeds, int count, LockstepOutcome* outcomes) const {
+    KernelParams p;
+    p.playerHealth = playerHealth;
+    p.playerAttack = playerAttack;
+    p.extraActions = extraActions;
+    p.playerFirst = playerFirst;
+    p.hasBoss = false;
+    p.enemyCount = enemyTypes.size();
+    for (int j = 0; j < SLOTS; j++) {
+        EnemyType type = j < p.enemyCount ? enemyTypes[j] : EnemyType::Slim;
+        p.enemyType[j] = (int)type;
+        p.enemyHealth[j] = getEnemyTypeHealth(type) * (enemyDoubleHP ? 2 : 1);
+        p.hasBoss = p.hasBoss || (j < p.enemyCount && type == EnemyType::Boss);
+    }
+    for (int i = 0; i < ENEMY_TYPE_COUNT; i++) {
+        p.typeHealth[i] = getEnemyTypeHealth((EnemyType)i);
+        p.typeAttack[i] = getEnemyTypeAttack((EnemyType)i);
+        p.typeDamage[i] = (int)(p.typeAttack[i] * damageMultiplier);
+    }
+    
+    SeedBatch batch;
+    for (int base = 0; base < count; base += SeedBatch::SIZE) {
+        batch.count = min(SeedBatch::SIZE, count - base);
+        for (int k = 0; k < SeedBatch::SIZE; k++) {
+            Random rng(k < batch.count ? seeds[base + k] : 0);
+            for (int i = 0; i < 4; i++) {
+                batch.state[i][k] = k < batch.count ? rng.getState(i) : 0;
+            }
+        }
+        
+        switch (isa) {
+            case KernelIsa::Avx512:
+                runAvx512(p, batch, outcomes + base);
+                break;
+            case KernelIsa::Avx2:
+                runAvx2(p, batch, outcomes + base);
+                break;
+            case KernelIsa::Scalar:
+                runScalar(p, batch, outcomes + base);
+                break;
+        }
+    }
+}
+
+KernelIsa LockstepBattleKernel::getIsa() const {
+    return isa;
+}
+
+KernelIsa LockstepBattleKernel::detectIsa() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq")) {
+        return KernelIsa::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return KernelIsa::Avx2;
+    }
+    return KernelIsa::Scalar;
+}
+
+const char* LockstepBattleKernel::getIsaName(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Avx512:
+            return "avx512";
+        case KernelIsa::Avx2:
+            return "avx2";
+        default:
+            return "scalar";
+    }
+}
+
+int LockstepBattleKernel::getLaneCount(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::Avx512:
+            return 16;
+        case KernelIsa::Avx2:
+            return 8;
+        default:
+            return 1;
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include "player.h"
+#include "enemy.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Instruction sets the lockstep kernel can run with
+enum class KernelIsa {
+    Scalar,
+    Avx2,
+    Avx512
+};
+
+// Result of one battle simulated by the lockstep kernel
+struct LockstepOutcome {
+    bool won;
+    int turns;
+    int playerHealth;
+};
+
+// Runs many independent battles of the same level side by side, one battle per SIMD lane
+// (8 lanes with AVX2, 16 with AVX-512, 1 for the scalar fallback).
+// Lanes follow Battle::execute rules exactly (shield/sword/armor stats, boss summons, the 50-turn
+// limit) for a player without potions who plays like AutoBattlePolicy, so a lane seeded with S
+// ends exactly like Battle::execute with a Random seeded with S. Finished battles are masked off
+// until every lane of the block is done.
+class LockstepBattleKernel {
+private:
+    int playerHealth;
+    int playerAttack;
+    double damageMultiplier;
+    int extraActions;
+    bool playerFirst;
+    bool enemyDoubleHP;
+    std::vector<EnemyType> enemyTypes;
+    KernelIsa isa;
+    
+public:
+    // Number of enemy slots per lane (same cap as Battle::MAX_ENEMIES)
+    static const int ENEMY_SLOTS = 3;
+    
+    // What it does: Prepares the kernel for one battle setup
+    // Inputs: player - player entering the battle (stats and equipment are copied), enemyTypes - enemy type names of the level, playerFirst - true if player acts first, enemyDoubleHP - true if enemies have double HP, disabledEquip - equipment disabled for this battle, isa - instruction set to use
+    // Outputs: None
+    LockstepBattleKernel(const Player& player, const std::vector<std::string>& enemyTypes, bool playerFirst,
+                         bool enemyDoubleHP = false, EquipmentType disabledEquip = EquipmentType::None,
+                         KernelIsa isa = detectIsa());
+    
+    // What it does: Simulates one battle per seed
+    // Inputs: seeds - random seed of every battle, count - number of battles, outcomes - array of count results to fill
+    // Outputs: None
+    void run(const uint64_t* seeds, int count, LockstepOutcome* outcomes) const;
+    
+    // What it does: Returns instruction set this kernel runs with
+    // Inputs: None
+    // Outputs: Instruction set
+    KernelIsa getIsa() const;
+    
+    // What it does: Detects the widest instruction set supported by this CPU
+    // Inputs: None
+    // Outputs: Best available instruction set
+    static KernelIsa detectIsa();
+    
+    // What it does: Returns printable name of an instruction set
+    // Inputs: isa - instruction set
+    // Outputs: Name ("scalar", "avx2" or "avx512")
+    static const char* getIsaName(KernelIsa isa);
+    
+    // What it does: Returns number of battles simulated side by side with an instruction set
+    // Inputs: isa - instruction set
+    // Outputs: Lane count (int)
+    static int getLaneCount(KernelIsa isa);
+};
+
+#endif
@@ -0,0 +1,7 @@
+// Compiled with AVX2 enabled (see Makefile); only called after LockstepBattleKernel::detectIsa
+#include "lockstep_kernel.h"
+using namespace lockstep;
+
+void lockstep::runAvx2(const KernelParams& p, const SeedBatch& batch, LockstepOutcome* outcomes) {
+    runBlocks<8>(p, batch, outcomes);
+}
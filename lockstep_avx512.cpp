@@ -0,0 +1,7 @@
+// Compiled with AVX-512 enabled (see Makefile); only called after LockstepBattleKernel::detectIsa
+#include "lockstep_kernel.h"
+using namespace lockstep;
+
+void lockstep::runAvx512(const KernelParams& p, const SeedBatch& batch, LockstepOutcome* outcomes) {
+    runBlocks<16>(p, batch, outcomes);
+}
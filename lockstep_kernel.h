@@ -0,0 +1,326 @@
+#ifndef LOCKSTEP_KERNEL_H
+#define LOCKSTEP_KERNEL_H
+
+#include "lockstep.h"
+#include <cstring>
+#include <cstdint>
+
+// Internal part of LockstepBattleKernel shared by lockstep.cpp and the per-instruction-set files.
+// lockstep_avx2.cpp and lockstep_avx512.cpp are compiled with -mavx2 / -mavx512* so every helper
+// below is vectorized for that instruction set; they must not include code that is shared with the
+// rest of the program (such as Random), which is why seeds are expanded in lockstep.cpp.
+namespace lockstep {
+    const int SLOTS = LockstepBattleKernel::ENEMY_SLOTS;
+    const int TURN_LIMIT = 50;
+    const int BOSS = (int)EnemyType::Boss;
+    
+    // Settings shared by every lane of a run
+    struct KernelParams {
+        int playerHealth;
+        int playerAttack;
+        int extraActions;
+        bool playerFirst;
+        bool hasBoss;
+        int enemyCount;
+        int enemyType[SLOTS];
+        int enemyHealth[SLOTS];
+        int typeHealth[ENEMY_TYPE_COUNT];
+        int typeAttack[ENEMY_TYPE_COUNT];
+        int typeDamage[ENEMY_TYPE_COUNT];
+    };
+    
+    // Battles handed to a kernel at once: xoshiro256** state of every battle, word by word
+    // (SIZE is a multiple of every lane count, unused entries are zero)
+    struct SeedBatch {
+        static const int SIZE = 256;
+        uint64_t state[4][SIZE];
+        int count;
+    };
+    
+    // What it does: Runs a batch one battle at a time (portable fallback)
+    // Inputs: p - shared settings, batch - seeded battles, outcomes - batch.count results to fill
+    // Outputs: None
+    void runScalar(const KernelParams& p, const SeedBatch& batch, LockstepOutcome* outcomes);
+    
+    // What it does: Runs a batch 8 battles at a time with AVX2 (only call if the CPU supports it)
+    // Inputs: p - shared settings, batch - seeded battles, outcomes - batch.count results to fill
+    // Outputs: None
+    void runAvx2(const KernelParams& p, const SeedBatch& batch, LockstepOutcome* outcomes);
+    
+    // What it does: Runs a batch 16 battles at a time with AVX-512 (only call if the CPU supports it)
+    // Inputs: p - shared settings, batch - seeded battles, outcomes - batch.count results to fill
+    // Outputs: None
+    void runAvx512(const KernelParams& p, const SeedBatch& batch, LockstepOutcome* outcomes);
+    
+    // Vector types holding one value per lane (GCC vector extensions, so the compiler emits
+    // AVX2/AVX-512 instructions in the file each entry point is compiled in)
+    // Int - 32-bit lane values, masks are -1 (true) or 0 (false)
+    // 64-bit RNG state is kept in chunks of at most 8 lanes (one AVX-512 register):
+    // Wide - RNG state of one chunk, WideMask - 64-bit mask of one chunk, ChunkInt - 32-bit values of one chunk
+    template <int W>
+    struct LaneVec {
+        static const int CHUNK = W < 8 ? W : 8;
+        static const int CHUNKS = W / CHUNK;
+        typedef int32_t Int __attribute__((vector_size(W * 4)));
+        typedef int32_t ChunkInt __attribute__((vector_size(CHUNK * 4)));
+        typedef uint64_t Wide __attribute__((vector_size(CHUNK * 8)));
+        typedef int64_t WideMask __attribute__((vector_size(CHUNK * 8)));
+    };
+    
+    // State of W battles, one battle per vector lane
+    template <int W>
+    struct Lanes {
+        typedef typename LaneVec<W>::Int Int;
+        typedef typename LaneVec<W>::Wide Wide;
+        
+        Wide s[4][LaneVec<W>::CHUNKS];
+        Int hp;
+        Int turn;
+        Int active;
+        Int extra;
+        Int count;
+        Int type[SLOTS];
+        Int ehp[SLOTS];
+        Int attack[SLOTS];
+        Int damage[SLOTS];
+    };
+    
+    // What it does: Counts alive enemies of every lane
+    // Inputs: lanes - lane block, alive - alive enemy count per lane to fill
+    // Outputs: None
+    template <int W>
+    __attribute__((always_inline)) inline void countAlive(const Lanes<W>& lanes, typename LaneVec<W>::Int& alive) {
+        alive = (lanes.count > 0) & (lanes.ehp[0] > 0);
+        for (int j = 1; j < SLOTS; j++) {
+            alive += (lanes.count > j) & (lanes.ehp[j] > 0);
+        }
+        alive = -alive;
+    }
+    
+    // What it does: Checks if any lane mask is set
+    // Inputs: mask - lane mask
+    // Outputs: Returns true if at least one lane is set
+    template <int W>
+    __attribute__((always_inline)) inline bool anyLane(const typename LaneVec<W>::Int& mask) {
+        int any = 0;
+        for (int l = 0; l < W; l++) {
+            any |= mask[l];
+        }
+        return any != 0;
+    }
+    
+    // What it does: Removes dead enemies of every lane, keeping the order of the alive ones
+    // Inputs: lanes - lane block
+    // Outputs: None
+    template <int W>
+    __attribute__((always_inline)) inline void removeDead(Lanes<W>& lanes) {
+        typedef typename LaneVec<W>::Int Int;
+        Int newType[SLOTS] = {};
+        Int newHp[SLOTS] = {};
+        Int newAttack[SLOTS] = {};
+        Int newDamage[SLOTS] = {};
+        Int kept = {};
+        for (int j = 0; j < SLOTS; j++) {
+            Int alive = ((lanes.count > j) & (lanes.ehp[j] > 0));
+            for (int t = 0; t < SLOTS; t++) {
+                Int move = alive & (kept == t);
+                newType[t] = move ? lanes.type[j] : newType[t];
+                newHp[t] = move ? lanes.ehp[j] : newHp[t];
+                newAttack[t] = move ? lanes.attack[j] : newAttack[t];
+                newDamage[t] = move ? lanes.damage[j] : newDamage[t];
+            }
+            kept -= alive;
+        }
+        for (int t = 0; t < SLOTS; t++) {
+            lanes.type[t] = newType[t];
+            lanes.ehp[t] = newHp[t];
+            lanes.attack[t] = newAttack[t];
+            lanes.damage[t] = newDamage[t];
+        }
+        lanes.count = kept;
+    }
+    
+    // What it does: Plays the player's turn in every active lane (AutoBattlePolicy without potions)
+    // Inputs: p - shared settings, lanes - lane block
+    // Outputs: None
+    template <int W>
+    __attribute__((always_inline)) inline void playerPhase(const KernelParams& p, Lanes<W>& lanes) {
+        typedef typename LaneVec<W>::Int Int;
+        for (int action = 0; action <= p.extraActions; action++) {
+            Int alive;
+            countAlive(lanes, alive);
+            Int can = lanes.active & (lanes.extra >= action) & (lanes.hp > 0) &
+                      (lanes.turn <= TURN_LIMIT) & (alive > 0);
+            if (!anyLane<W>(can)) break;
+            
+            Int best = Int{} - 1;
+            Int bestAttack = {};
+            Int bestHp = {};
+            for (int j = 0; j < SLOTS; j++) {
+                Int better = ((lanes.count > j) & (lanes.ehp[j] > 0)) & ((best < 0) | (lanes.attack[j] > bestAttack) |
+                                                    ((lanes.attack[j] == bestAttack) & (lanes.ehp[j] < bestHp)));
+                best = better ? Int{} + j : best;
+                bestAttack = better ? lanes.attack[j] : bestAttack;
+                bestHp = better ? lanes.ehp[j] : bestHp;
+            }
+            for (int j = 0; j < SLOTS; j++) {
+                Int hit = can & (best == j);
+                Int left = lanes.ehp[j] - p.playerAttack;
+                left = left < 0 ? Int{} : left;
+                lanes.ehp[j] = hit ? left : lanes.ehp[j];
+            }
+        }
+        lanes.extra = lanes.active ? Int{} : lanes.extra;
+    }
+    
+    // What it does: Adds an enemy at the end of the enemy list of the masked lanes
+    // Inputs: p - shared settings, lanes - lane block, type - enemy type, mask - lanes to add the enemy to
+    // Outputs: None
+    template <int W>
+    __attribute__((always_inline)) inline void addEnemy(const KernelParams& p, Lanes<W>& lanes,
+                                                        EnemyType type, const typename LaneVec<W>::Int& mask) {
+        typedef typename LaneVec<W>::Int Int;
+        Int add = mask & (lanes.count < SLOTS);
+        for (int t = 0; t < SLOTS; t++) {
+            Int put = add & (lanes.count == t);
+            lanes.type[t] = put ? Int{} + (int)type : lanes.type[t];
+            lanes.ehp[t] = put ? Int{} + p.typeHealth[(int)type] : lanes.ehp[t];
+            lanes.attack[t] = put ? Int{} + p.typeAttack[(int)type] : lanes.attack[t];
+            lanes.damage[t] = put ? Int{} + p.typeDamage[(int)type] : lanes.damage[t];
+        }
+        lanes.count -= add;
+    }
+    
+    // What it does: Takes one xoshiro256** step in the masked lanes and maps it like Random::nextInt
+    // Inputs: lanes - lane block, draw - lanes that draw a number, bound - upper bound per lane,
+    //         roll - random number in [0, bound) per lane to fill (meaningless in lanes that did not draw)
+    // Outputs: None
+    template <int W>
+    __attribute__((always_inline)) inline void nextInt(Lanes<W>& lanes, const typename LaneVec<W>::Int& draw,
+                                                       const typename LaneVec<W>::Int& bound, typename LaneVec<W>::Int& roll) {
+        typedef typename LaneVec<W>::Wide Wide;
+        typedef typename LaneVec<W>::WideMask WideMask;
+        typedef typename LaneVec<W>::ChunkInt ChunkInt;
+        for (int k = 0; k < LaneVec<W>::CHUNKS; k++) {
+            ChunkInt chunkDraw, chunkBound;
+            memcpy(&chunkDraw, (const char*)&draw + k * sizeof(ChunkInt), sizeof(ChunkInt));
+            memcpy(&chunkBound, (const char*)&bound + k * sizeof(ChunkInt), sizeof(ChunkInt));
+            WideMask take = __builtin_convertvector(chunkDraw, WideMask);
+            
+            Wide s0 = lanes.s[0][k], s1 = lanes.s[1][k], s2 = lanes.s[2][k], s3 = lanes.s[3][k];
+            Wide x = s1 * 5;
+            Wide result = ((x << 7) | (x >> 57)) * 9;
+            Wide t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = (s3 << 45) | (s3 >> 19);
+            lanes.s[0][k] = take ? s0 : lanes.s[0][k];
+            lanes.s[1][k] = take ? s1 : lanes.s[1][k];
+            lanes.s[2][k] = take ? s2 : lanes.s[2][k];
+            lanes.s[3][k] = take ? s3 : lanes.s[3][k];
+            
+            Wide wide = ((result >> 32) * __builtin_convertvector(chunkBound, Wide)) >> 32;
+            ChunkInt chunkRoll = __builtin_convertvector(wide, ChunkInt);
+            memcpy((char*)&roll + k * sizeof(ChunkInt), &chunkRoll, sizeof(ChunkInt));
+        }
+    }
+    
+    // What it does: Plays the enemies' turn in every active lane, including Battle::bossAction
+    // Inputs: p - shared settings, lanes - lane block
+    // Outputs: None
+    template <int W>
+    __attribute__((always_inline)) inline void enemyPhase(const KernelParams& p, Lanes<W>& lanes) {
+        typedef typename LaneVec<W>::Int Int;
+        Int snapshot = lanes.count;
+        for (int j = 0; j < SLOTS; j++) {
+            Int act = lanes.active & (snapshot > j) & (lanes.ehp[j] > 0) & (lanes.hp > 0);
+            Int hp = lanes.hp - lanes.damage[j];
+            hp = hp < 0 ? Int{} : hp;
+            lanes.hp = (act & (lanes.type[j] != BOSS)) ? hp : lanes.hp;
+            if (!p.hasBoss) continue;
+            
+            Int boss = act & (lanes.type[j] == BOSS);
+            if (!anyLane<W>(boss)) continue;
+            
+            Int alive;
+            countAlive(lanes, alive);
+            Int draw = boss & (alive < 3);
+            Int bound = (alive == 2) ? Int{} + 2 : Int{} + 100;
+            Int roll;
+            nextInt(lanes, draw, bound, roll);
+            Int attack = boss & ((alive >= 3) | ((alive == 2) & (roll == 0)) | ((alive < 2) & (roll < 34)));
+            Int summonBatho = boss & (alive < 2) & (roll >= 34) & (roll < 67);
+            Int summonGoust = boss & ~attack & ~summonBatho;
+            attack |= summonGoust & (lanes.count >= SLOTS);
+            
+            hp = lanes.hp - p.typeDamage[BOSS];
+            hp = hp < 0 ? Int{} : hp;
+            lanes.hp = attack ? hp : lanes.hp;
+            addEnemy(p, lanes, EnemyType::Goust, summonGoust);
+            addEnemy(p, lanes, EnemyType::Batho, summonBatho);
+            addEnemy(p, lanes, EnemyType::Batho, summonBatho);
+        }
+    }
+    
+    // What it does: Runs the battles of a batch in blocks of W lanes until every battle of the block has finished
+    // Inputs: p - shared settings, batch - seeded battles, outcomes - batch.count results to fill
+    // Outputs: None
+    template <int W>
+    inline void runBlocks(const KernelParams& p, const SeedBatch& batch, LockstepOutcome* outcomes) {
+        int count = batch.count;
+        typedef typename LaneVec<W>::Int Int;
+        Lanes<W> lanes;
+        for (int base = 0; base < count; base += W) {
+            int32_t used[W];
+            for (int i = 0; i < 4; i++) {
+                memcpy(lanes.s[i], &batch.state[i][base], sizeof(lanes.s[i]));
+            }
+            for (int l = 0; l < W; l++) {
+                used[l] = base + l < count ? -1 : 0;
+            }
+            memcpy(&lanes.active, used, sizeof(used));
+            lanes.hp = Int{} + p.playerHealth;
+            lanes.turn = Int{};
+            lanes.extra = Int{} + p.extraActions;
+            lanes.count = Int{} + p.enemyCount;
+            for (int j = 0; j < SLOTS; j++) {
+                lanes.type[j] = Int{} + p.enemyType[j];
+                lanes.ehp[j] = Int{} + p.enemyHealth[j];
+                lanes.attack[j] = Int{} + p.typeAttack[p.enemyType[j]];
+                lanes.damage[j] = Int{} + p.typeDamage[p.enemyType[j]];
+            }
+            Int alive;
+            countAlive(lanes, alive);
+            lanes.active &= (alive > 0) & (lanes.hp > 0);
+            
+            while (anyLane<W>(lanes.active)) {
+                lanes.turn -= lanes.active;
+                
+                if (p.playerFirst) {
+                    playerPhase(p, lanes);
+                    removeDead(lanes);
+                    enemyPhase(p, lanes);
+                    removeDead(lanes);
+                } else {
+                    enemyPhase(p, lanes);
+                    removeDead(lanes);
+                    playerPhase(p, lanes);
+                    removeDead(lanes);
+                }
+                
+                lanes.active &= (lanes.count > 0) & (lanes.hp > 0) & (lanes.turn <= TURN_LIMIT);
+            }
+            
+            for (int l = 0; l < W && base + l < count; l++) {
+                outcomes[base + l].won = lanes.count[l] == 0;
+                outcomes[base + l].turns = lanes.turn[l];
+                outcomes[base + l].playerHealth = lanes.hp[l];
+            }
+        }
+    }
+}
+
+#endif
@@ -1,12 +1,258 @@
 #include "game.h"
+#include "replay.h"
+#include "level.h"
+#include "event.h"
+#include "metrics.h"
+#include "autosave.h"
+#include "script.h"
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
 using namespace std;
 
+// What it does: Converts between the binary save file of a slot and the text save format
+// Inputs: toText - true to export the binary save to textFile, false to import textFile into the binary save, textFile - text file name,
+//         slot - save slot to convert (1 to SAVE_SLOT_COUNT)
+// Outputs: Returns exit code (0 on success, 1 on failure)
+static int convertSave(bool toText, const string& textFile, int slot) {
+    if (slot < 1 || slot > SAVE_SLOT_COUNT) {
+        cout << "Invalid save slot " << slot << " (1-" << SAVE_SLOT_COUNT << ")." << endl;
+        return 1;
+    }
+    SaveManager saveManager(SaveManager::getSlotFileName(slot));
+    Player player;
+    PotionManager potionManager;
+    int currentLevel = 1;
+    int difficulty = 0;
+    
+    bool ok;
+    if (toText) {
+        ok = saveManager.loadGame(&player, &potionManager, currentLevel, difficulty) &&
+             saveManager.exportText(&player, &potionManager, currentLevel, difficulty, textFile);
+    } else {
+        ok = saveManager.importText(&player, &potionManager, currentLevel, difficulty, textFile) &&
+             saveManager.saveGame(&player, &potionManager, currentLevel, difficulty);
+    }
+    cout << (ok ? "Save converted." : "Failed to convert save!") << endl;
+    return ok ? 0 : 1;
+}
+
+// What it does: Plays replay files back without output at full speed and checks that every game ends in its recorded state.
+// Saves are restored into and written to a scratch directory, so the player's own saves are never touched.
+// Inputs: files - replay files to play
+// Outputs: Returns exit code (0 if every replay matched, 1 otherwise)
+static int playReplays(const vector<string>& files) {
+    char scratch[] = "/tmp/ftm-replay-XXXXXX";
+    if (!mkdtemp(scratch)) {
+        cout << "Failed to create scratch directory for replay saves!" << endl;
+        return 1;
+    }
+    string savePrefix = string(scratch) + "/";
+    
+    long long decisions = 0;
+    int played = 0;
+    int failures = 0;
+    auto start = chrono::steady_clock::now();
+    for (const auto& file : files) {
+        Replay replay;
+        if (!replay.load(file) || !replay.restoreSaves(savePrefix)) {
+            cout << file << ": not a valid replay file" << endl;
+            failures++;
+            continue;
+        }
+        
+        string input = replay.buildInput();
+        CommandScript script(input.data(), input.size());
+        Game game(cin, cout, replay.getSeed(), true, savePrefix);
+        game.setScript(&script);
+        game.setDurableSaves(false);
+        game.run();
+        if (game.getStateChecksum() != replay.getFinalChecksum()) {
+            cout << file << ": final state differs from the recording" << endl;
+            failures++;
+        }
+        decisions += replay.getDecisionCount();
+        played++;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    Replay empty;
+    empty.restoreSaves(savePrefix);
+    rmdir(scratch);
+    
+    cout << "Replayed " << played << " game(s), " << decisions << " decisions in " << seconds << " s ("
+         << (seconds > 0 ? played / seconds : 0) << " games/s, " << (seconds > 0 ? decisions / seconds : 0)
+         << " decisions/s)" << endl;
+    cout << (failures == 0 ? "Every replay ended in its recorded state." : to_string(failures) + " replay(s) failed.") << endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// What it does: Plays a command script twice from empty save slots, once through the memory-mapped script and once
+// as the same bytes on an input stream, and checks that both games end in the same state
+// Inputs: scriptFile - command script to check, seed - random seed of both games
+// Outputs: Returns exit code (0 if both games ended in the same state, 1 otherwise)
+static int verifyScript(const string& scriptFile, uint64_t seed) {
+    CommandScript script;
+    string error;
+    if (!script.open(scriptFile, error)) {
+        cerr << "Invalid script: " << error << endl;
+        return 1;
+    }
+    ifstream file(scriptFile, ios::binary);
+    stringstream text;
+    text << file.rdbuf();
+    
+    char scratch[] = "/tmp/ftm-script-XXXXXX";
+    if (!mkdtemp(scratch)) {
+        cout << "Failed to create scratch directory for script saves!" << endl;
+        return 1;
+    }
+    string savePrefix = string(scratch) + "/";
+    
+    uint32_t checksums[2];
+    for (int pass = 0; pass < 2; pass++) {
+        istringstream input(text.str());
+        {
+            Game game(input, cout, seed, true, savePrefix);
+            if (pass == 0) {
+                game.setScript(&script);
+            }
+            game.setDurableSaves(false);
+            game.run();
+            checksums[pass] = game.getStateChecksum();
+        }
+        for (int slot = 1; slot <= SAVE_SLOT_COUNT; slot++) {
+            SaveManager(savePrefix + SaveManager::getSlotFileName(slot)).deleteSave();
+        }
+    }
+    rmdir(scratch);
+    
+    bool same = checksums[0] == checksums[1];
+    cout << (same ? "The script and the same input on a stream ended in the same state." :
+                    "The script and the same input on a stream ended in different states!") << endl;
+    return same ? 0 : 1;
+}
+
 // What it does: Main entry point for Fight to Monsters game. Initializes and runs the game.
-// Inputs: None
+// Inputs: argc - argument count, argv - command line arguments ("--seed N" replays a fixed random sequence,
+//         "--quiet" plays without any output, "--record FILE" writes a replay of the game, "--replay FILE..." plays replays back and checks them,
+//         "--levels FILE" plays the level table of a config file, "--events FILE" uses the event weights of a config file,
+//         "--script FILE" plays the choices of a command script instead of reading stdin (batch mode),
+//         "--verify" (with --script) checks that the script plays like the same text on stdin instead of playing it,
+//         "--metrics FILE" writes the recorded metrics when the game ends (builds made with METRICS=1),
+//         "--export-save FILE" / "--import-save FILE" convert the save file of slot 1 (or "--slot N") to / from text and exit)
 // Outputs: Returns exit code (0 for successful execution)
-int main() {
-    Game game;
+int main(int argc, char* argv[]) {
+    uint64_t seed = Random::randomSeed();
+    bool quiet = false;
+    string recordFile;
+    string metricsFile;
+    string scriptFile;
+    bool verify = false;
+    string exportFile;
+    string importFile;
+    int saveSlot = 1;
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--export-save") == 0 && hasValue) {
+            exportFile = argv[++i];
+        } else if (strcmp(argv[i], "--import-save") == 0 && hasValue) {
+            importFile = argv[++i];
+        } else if (strcmp(argv[i], "--slot") == 0 && hasValue) {
+            saveSlot = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (strcmp(argv[i], "--levels") == 0 && hasValue) {
+            string error;
+            if (!Level::loadTable(argv[++i], error)) {
+                cerr << "Invalid level table: " << error << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--events") == 0 && hasValue) {
+            string error;
+            if (!EventManager::loadTable(argv[++i], error)) {
+                cerr << "Invalid event weights: " << error << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--metrics") == 0 && hasValue) {
+            metricsFile = argv[++i];
+        } else if (strcmp(argv[i], "--script") == 0 && hasValue) {
+            scriptFile = argv[++i];
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else if (strcmp(argv[i], "--record") == 0 && hasValue) {
+            recordFile = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            return playReplays(vector<string>(argv + i + 1, argv + argc));
+        }
+    }
+    
+    if (!exportFile.empty()) {
+        return convertSave(true, exportFile, saveSlot);
+    }
+    if (!importFile.empty()) {
+        return convertSave(false, importFile, saveSlot);
+    }
+    if (verify && !scriptFile.empty()) {
+        return verifyScript(scriptFile, seed);
+    }
+    
+    CommandScript script;
+    if (!scriptFile.empty()) {
+        string error;
+        if (!script.open(scriptFile, error)) {
+            cerr << "Invalid script: " << error << endl;
+            return 1;
+        }
+    }
+    
+    // Saves of older versions were text files; carry one over into slot 1 before the first load
+    SaveManager firstSlot;
+    if (firstSlot.importLegacySave(LEGACY_SAVE_FILE_NAME)) {
+        cout << "Imported the old save " << LEGACY_SAVE_FILE_NAME << " into slot 1 (" << firstSlot.getFileName() << ")." << endl;
+    }
+    
+    Game game(seed, quiet);
+    if (!scriptFile.empty()) {
+        game.setScript(&script);
+    }
+    ReplayRecorder* recorder = recordFile.empty() ? nullptr : new ReplayRecorder(recordFile, seed);
+    game.setRecorder(recorder);
     game.run();
-    return 0;
+    
+    AutosaveStallStats stalls = Autosave::getStallStats();
+    if (!quiet && stalls.count > 0) {
+        cout << "Autosave stalls of the game thread: " << stalls.count << " hand-offs, " << stalls.waits << " waited, p99 "
+             << stalls.p99Nanoseconds / 1000 << " us, max " << stalls.maxNanoseconds / 1000 << " us" << endl;
+    }
+    int exitCode = 0;
+    if (script.hasError()) {
+        cerr << "Script error at " << script.describeError() << endl;
+        exitCode = 1;
+    }
+    if (recorder) {
+        if (!recorder->finish(game.getStateChecksum())) {
+            cerr << "Failed to write replay " << recordFile << endl;
+            exitCode = 1;
+        }
+        delete recorder;
+    }
+    if (!metricsFile.empty()) {
+        if (!metricsEnabled()) {
+            cerr << "This build records no metrics; rebuild with 'make clean && make METRICS=1'." << endl;
+        }
+        if (!writeMetricsFile(metricsFile)) {
+            cerr << "Failed to write metrics " << metricsFile << endl;
+            exitCode = 1;
+        }
+    }
+    return exitCode;
 }
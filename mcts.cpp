@@ -0,0 +1,313 @@
+#include "mcts.h"
+#include "policy.h"
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+namespace {
+    // UCT exploration constant (rewards are between 0 and 1)
+    const double EXPLORATION = 1.0;
+    
+    // Reward of a won simulation before potion adjustments
+    const double WIN_REWARD = 0.9;
+    
+    // Reward change per potion drunk in a won simulation: Life Potions are kept for later levels when
+    // drinking them does not change the outcome, the other potions raise stats for the rest of the campaign
+    const double LIFE_POTION_COST = 0.02;
+    const double STAT_POTION_GAIN = 0.02;
+    
+    // Simulations between two checks of the clock
+    const int CLOCK_INTERVAL = 16;
+    
+    // First potion move and the skip move (attack moves are the enemy indices before them)
+    const int FIRST_POTION_MOVE = Battle::MAX_ENEMIES;
+    const int SKIP_MOVE = FIRST_POTION_MOVE + POTION_TYPE_COUNT;
+    
+    // One node of a search tree: statistics of the move sequence leading to it
+    struct Node {
+        int visits;
+        double total;
+        int child[MctsBattlePolicy::MOVE_COUNT];
+    };
+    
+    // Size of a cache line
+    const int CACHE_LINE_SIZE = 64;
+    
+    // Root statistics of one worker's tree. Padded at the end with a cache line (a vector does not align
+    // its elements to cache lines), so worker threads never write to the same cache line.
+    struct WorkerSlot {
+        long long simulations;
+        long long visits[MctsBattlePolicy::MOVE_COUNT];
+        double total[MctsBattlePolicy::MOVE_COUNT];
+        char padding[CACHE_LINE_SIZE];
+    };
+    
+    // What it does: Returns a node with no visits and no children
+    // Inputs: None
+    // Outputs: New node
+    Node makeNode() {
+        Node node;
+        node.visits = 0;
+        node.total = 0.0;
+        fill(node.child, node.child + MctsBattlePolicy::MOVE_COUNT, -1);
+        return node;
+    }
+    
+    // What it does: Scores the end of a simulation
+    // Inputs: won - true if the simulated battle was won, before - potions when the search started, after - potions at the end of the simulation
+    // Outputs: Reward between 0 and 1
+    double scoreSimulation(bool won, const PotionManager& before, const PotionManager& after) {
+        if (!won) return 0.0;
+        int lifeDrunk = before.getQuantity(PotionType::Life) - after.getQuantity(PotionType::Life);
+        int statDrunk = before.getTotalQuantity() - after.getTotalQuantity() - lifeDrunk;
+        double reward = WIN_REWARD - LIFE_POTION_COST * lifeDrunk + STAT_POTION_GAIN * statDrunk;
+        return min(1.0, max(0.0, reward));
+    }
+    
+    // What it does: Lists the legal moves of a battle waiting for a player action
+    // Inputs: battle - battle being played, moves - array of MOVE_COUNT entries to fill
+    // Outputs: Number of legal moves
+    int listMoves(const Battle& battle, int moves[]) {
+        int count = 0;
+        const EnemyPool& enemies = battle.getEnemies();
+        for (int i = 0; i < enemies.size(); i++) {
+            if (enemies.isAlive(i)) {
+                moves[count++] = i;
+            }
+        }
+        for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+            if (battle.getPotionManager().hasPotion((PotionType)i)) {
+                moves[count++] = FIRST_POTION_MOVE + i;
+            }
+        }
+        moves[count++] = SKIP_MOVE;
+        return count;
+    }
+    
+    // What it does: Returns the battle action of a move
+    // Inputs: move - move index
+    // Outputs: Battle action
+    BattleAction moveAction(int move) {
+        if (move < FIRST_POTION_MOVE) return BattleAction::Attack;
+        if (move < SKIP_MOVE) return BattleAction::UsePotion;
+        return BattleAction::Skip;
+    }
+    
+    // Policy of one simulation: walks down the tree with UCT, adds one new node, then plays
+    // the rest of the battle with AutoBattlePolicy
+    class TreeWalker : public BattlePolicy {
+    private:
+        vector<Node>& tree;
+        Random& rng;
+        AutoBattlePolicy rollout;
+        int node;
+        int move;
+        bool treeMove;
+        vector<int>& path;
+    
+    public:
+        // What it does: Starts a walk at the root of a tree
+        // Inputs: tree - search tree (node 0 is the root), rng - random number generator of the simulation, path - vector to fill with the visited nodes
+        // Outputs: None
+        TreeWalker(vector<Node>& tree, Random& rng, vector<int>& path)
+            : tree(tree), rng(rng), node(0), move(-1), treeMove(false), path(path) {
+            path.clear();
+            path.push_back(0);
+        }
+        
+        // What it does: Picks the next move in the tree, or leaves the decision to the rollout policy below it
+        // Inputs: battle - simulated battle
+        // Outputs: Chosen action
+        BattleAction chooseAction(const Battle& battle) override {
+            treeMove = node >= 0;
+            if (!treeMove) {
+                return rollout.chooseAction(battle);
+            }
+            
+            int moves[MctsBattlePolicy::MOVE_COUNT];
+            int untried[MctsBattlePolicy::MOVE_COUNT];
+            int count = listMoves(battle, moves);
+            int untriedCount = 0;
+            for (int i = 0; i < count; i++) {
+                if (tree[node].child[moves[i]] < 0) {
+                    untried[untriedCount++] = moves[i];
+                }
+            }
+            
+            if (untriedCount > 0) {
+                move = untried[rng.nextInt(untriedCount)];
+                int child = (int)tree.size();
+                tree.push_back(makeNode());
+                tree[node].child[move] = child;
+                path.push_back(child);
+                node = -1;
+            } else {
+                double logVisits = log((double)max(1, tree[node].visits));
+                double bestScore = -1.0;
+                for (int i = 0; i < count; i++) {
+                    const Node& child = tree[tree[node].child[moves[i]]];
+                    double score = child.total / child.visits + EXPLORATION * sqrt(logVisits / child.visits);
+                    if (score > bestScore) {
+                        bestScore = score;
+                        move = moves[i];
+                    }
+                }
+                node = tree[node].child[move];
+                path.push_back(node);
+            }
+            return moveAction(move);
+        }
+        
+        // What it does: Returns the enemy of the tree move, or asks the rollout policy below the tree
+        // Inputs: battle - simulated battle
+        // Outputs: Index of the enemy
+        int chooseTarget(const Battle& battle) override {
+            if (treeMove) {
+                return move;
+            }
+            return rollout.chooseTarget(battle);
+        }
+        
+        // What it does: Returns the potion of the tree move, or asks the rollout policy below the tree
+        // Inputs: battle - simulated battle, potions - simulated potion inventory
+        // Outputs: Name of the potion
+        string choosePotion(const Battle& battle, const PotionManager& potions) override {
+            if (treeMove) {
+                return getPotionName((PotionType)(move - FIRST_POTION_MOVE));
+            }
+            return rollout.choosePotion(battle, potions);
+        }
+    };
+}
+
+MctsBattlePolicy::MctsBattlePolicy(int threadCount, double budgetMs, long long simulationLimit, uint64_t seed)
+    : threadCount(threadCount), budgetMs(budgetMs), simulationLimit(simulationLimit), seed(seed), pendingMove(SKIP_MOVE),
+      decisionCount(0), simulationCount(0), searchSeconds(0.0) {
+    if (this->threadCount <= 0) {
+        this->threadCount = max(1u, thread::hardware_concurrency());
+    }
+    if (this->budgetMs <= 0 && this->simulationLimit <= 0) {
+        this->budgetMs = 20.0;
+    }
+}
+
+int MctsBattlePolicy::search(const Battle& battle) {
+    auto start = chrono::steady_clock::now();
+    auto deadline = start + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double, milli>(budgetMs));
+    long long perThreadLimit = simulationLimit > 0 ? (simulationLimit + threadCount - 1) / threadCount : 0;
+    BattleSnapshot root;
+    if (!battle.saveSnapshot(root)) {
+        return NO_MOVE;
+    }
+    vector<WorkerSlot> slots(threadCount);
+    
+    auto worker = [&](int index) {
+        WorkerSlot& slot = slots[index];
+        Random rng(Random::deriveSeed(seed, (uint64_t)decisionCount * threadCount + index));
+        vector<Node> tree;
+        vector<int> path;
+        tree.push_back(makeNode());
+        slot.simulations = 0;
+        
+        // Every simulation restarts the worker's own copy of the battle from the root snapshot
+        // (the worker's generator keeps running, so simulations explore different futures)
+        Player player = battle.getPlayer();
+        PotionManager potions = battle.getPotionManager();
+        Battle copy(battle, &player, &potions, &rng);
+        while (true) {
+            if (perThreadLimit > 0 && slot.simulations >= perThreadLimit) break;
+            if (budgetMs > 0 && slot.simulations % CLOCK_INTERVAL == 0 && chrono::steady_clock::now() >= deadline) break;
+            
+            copy.restoreSnapshot(root, false);
+            TreeWalker walker(tree, rng, path);
+            bool won = copy.resume(walker);
+            double reward = scoreSimulation(won, battle.getPotionManager(), potions);
+            for (int node : path) {
+                tree[node].visits++;
+                tree[node].total += reward;
+            }
+            slot.simulations++;
+        }
+        
+        for (int move = 0; move < MOVE_COUNT; move++) {
+            int child = tree[0].child[move];
+            slot.visits[move] = child < 0 ? 0 : tree[child].visits;
+            slot.total[move] = child < 0 ? 0.0 : tree[child].total;
+        }
+    };
+    
+    vector<thread> workers;
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& t : workers) {
+        t.join();
+    }
+    
+    // Most visited move over all trees (higher average reward breaks ties)
+    int best = SKIP_MOVE;
+    long long bestVisits = -1;
+    double bestTotal = 0.0;
+    for (int move = 0; move < MOVE_COUNT; move++) {
+        long long visits = 0;
+        double total = 0.0;
+        for (const auto& slot : slots) {
+            visits += slot.visits[move];
+            total += slot.total[move];
+        }
+        if (visits > bestVisits || (visits == bestVisits && visits > 0 && total > bestTotal)) {
+            best = move;
+            bestVisits = visits;
+            bestTotal = total;
+        }
+    }
+    
+    for (const auto& slot : slots) {
+        simulationCount += slot.simulations;
+    }
+    decisionCount++;
+    searchSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return best;
+}
+
+BattleAction MctsBattlePolicy::chooseAction(const Battle& battle) {
+    pendingMove = search(battle);
+    if (pendingMove == NO_MOVE) {
+        return hordePolicy.chooseAction(battle);
+    }
+    return moveAction(pendingMove);
+}
+
+int MctsBattlePolicy::chooseTarget(const Battle& battle) {
+    if (pendingMove == NO_MOVE) {
+        return hordePolicy.chooseTarget(battle);
+    }
+    return pendingMove < FIRST_POTION_MOVE ? pendingMove : -1;
+}
+
+string MctsBattlePolicy::choosePotion(const Battle& battle, const PotionManager& potions) {
+    if (pendingMove == NO_MOVE) {
+        return hordePolicy.choosePotion(battle, potions);
+    }
+    if (pendingMove < FIRST_POTION_MOVE || pendingMove >= SKIP_MOVE) return "";
+    return getPotionName((PotionType)(pendingMove - FIRST_POTION_MOVE));
+}
+
+int MctsBattlePolicy::getThreadCount() const {
+    return threadCount;
+}
+
+long long MctsBattlePolicy::getDecisionCount() const {
+    return decisionCount;
+}
+
+long long MctsBattlePolicy::getSimulationCount() const {
+    return simulationCount;
+}
+
+double MctsBattlePolicy::getSearchSeconds() const {
+    return searchSeconds;
+}
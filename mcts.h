@@ -0,0 +1,84 @@
+#ifndef MCTS_H
+#define MCTS_H
+
+#include "battle.h"
+#include "policy.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Battle policy that searches every decision with Monte Carlo Tree Search. Each worker thread grows
+// its own tree from the current battle (root parallelism) until the time budget runs out: moves are
+// picked with UCT, new leaves are played to the end with AutoBattlePolicy on a copy of the battle
+// (Battle::resume), and the root visit counts of all trees are added up to choose the move.
+// The search never reads the game's random number generator, so boss rolls are unknown to it and
+// every simulation draws its own (open-loop search over chance outcomes). Horde battles (more than
+// Battle::MAX_ENEMIES enemies) do not fit in a snapshot, so their decisions are left to AutoBattlePolicy.
+class MctsBattlePolicy : public BattlePolicy {
+public:
+    // Moves of a decision: attack enemy 0-2, drink potion type 0-3 (PotionType order), skip
+    static const int MOVE_COUNT = Battle::MAX_ENEMIES + POTION_TYPE_COUNT + 1;
+    
+    // Pending move while AutoBattlePolicy decides a horde battle
+    static const int NO_MOVE = -1;
+    
+private:
+    int threadCount;
+    double budgetMs;
+    long long simulationLimit;
+    uint64_t seed;
+    int pendingMove;
+    AutoBattlePolicy hordePolicy;
+    long long decisionCount;
+    long long simulationCount;
+    double searchSeconds;
+    
+    // What it does: Searches the decision of a battle on every worker thread and picks the most visited move
+    // Inputs: battle - battle waiting for a player action
+    // Outputs: Chosen move, or NO_MOVE if the battle is a horde battle that cannot be searched
+    int search(const Battle& battle);
+    
+public:
+    // What it does: Initializes the policy
+    // Inputs: threadCount - worker threads per decision (0 = one per hardware core), budgetMs - search time per decision in milliseconds,
+    //         simulationLimit - stop a decision early after this many simulations in total (0 = time budget only), seed - base seed of the search
+    // Outputs: None
+    MctsBattlePolicy(int threadCount = 0, double budgetMs = 20.0, long long simulationLimit = 0, uint64_t seed = 0);
+    
+    // What it does: Searches the decision and returns the action of the chosen move
+    // Inputs: battle - battle being played
+    // Outputs: Chosen action
+    BattleAction chooseAction(const Battle& battle) override;
+    
+    // What it does: Returns the enemy of the chosen attack move
+    // Inputs: battle - battle being played
+    // Outputs: Index of the enemy
+    int chooseTarget(const Battle& battle) override;
+    
+    // What it does: Returns the potion of the chosen potion move
+    // Inputs: battle - battle being played, potions - player's potion inventory
+    // Outputs: Name of the potion
+    std::string choosePotion(const Battle& battle, const PotionManager& potions) override;
+    
+    // What it does: Returns number of worker threads used per decision
+    // Inputs: None
+    // Outputs: Thread count (int)
+    int getThreadCount() const;
+    
+    // What it does: Returns number of decisions searched so far
+    // Inputs: None
+    // Outputs: Decision count (long long)
+    long long getDecisionCount() const;
+    
+    // What it does: Returns number of simulated battles played so far (all threads)
+    // Inputs: None
+    // Outputs: Simulation count (long long)
+    long long getSimulationCount() const;
+    
+    // What it does: Returns wall-clock time spent searching so far
+    // Inputs: None
+    // Outputs: Seconds (double)
+    double getSearchSeconds() const;
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "metrics.h"
+#include <atomic>
+#include <mutex>
+#include <fstream>
+#include <cstring>
+using namespace std;
+
+namespace {
+    const char* const METRIC_PHASE_NAMES[METRIC_PHASE_COUNT] = {
+        "battle_turn", "enemy_turn", "boss_action", "event", "shop_visit", "save", "load", "save_stall"
+    };
+    
+    // Metrics recorded by one thread. Only the owning thread writes the counters (plain load + store,
+    // no read-modify-write), snapshots read them with relaxed loads.
+    struct ThreadMetrics {
+        atomic<uint64_t> phaseCount[METRIC_PHASE_COUNT];
+        atomic<uint64_t> phaseNanoseconds[METRIC_PHASE_COUNT];
+        atomic<uint64_t> latencyBuckets[METRIC_PHASE_COUNT][LATENCY_BUCKETS];
+        atomic<uint64_t> battleTurns[TURN_COUNT_BUCKETS];
+        ThreadMetrics* previous;
+        ThreadMetrics* next;
+        
+        // What it does: Zeroes the counters and registers the block with the live blocks
+        // Inputs: None
+        // Outputs: None
+        ThreadMetrics();
+        
+        // What it does: Adds the counters to the totals of finished threads and unregisters the block
+        // Inputs: None
+        // Outputs: None
+        ~ThreadMetrics();
+    };
+    
+    // Guards the list of live blocks and the totals of finished threads
+    mutex registryMutex;
+    ThreadMetrics* liveThreads = nullptr;
+    MetricsSnapshot finishedThreads = {};
+    
+    // What it does: Adds one counter to another without a read-modify-write (only the owning thread writes it)
+    // Inputs: counter - counter to add to, amount - amount to add
+    // Outputs: None
+    inline void bump(atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(memory_order_relaxed) + amount, memory_order_relaxed);
+    }
+    
+    // What it does: Adds the counters of a thread block to a snapshot
+    // Inputs: totals - snapshot to add to, block - thread block to read
+    // Outputs: None
+    void addBlock(MetricsSnapshot& totals, const ThreadMetrics& block) {
+        for (int p = 0; p < METRIC_PHASE_COUNT; p++) {
+            totals.phaseCount[p] += block.phaseCount[p].load(memory_order_relaxed);
+            totals.phaseNanoseconds[p] += block.phaseNanoseconds[p].load(memory_order_relaxed);
+            for (int b = 0; b < LATENCY_BUCKETS; b++) {
+                totals.latencyBuckets[p][b] += block.latencyBuckets[p][b].load(memory_order_relaxed);
+            }
+        }
+        for (int t = 0; t < TURN_COUNT_BUCKETS; t++) {
+            totals.battleTurns[t] += block.battleTurns[t].load(memory_order_relaxed);
+        }
+    }
+    
+    ThreadMetrics::ThreadMetrics() : previous(nullptr) {
+        for (int p = 0; p < METRIC_PHASE_COUNT; p++) {
+            phaseCount[p].store(0, memory_order_relaxed);
+            phaseNanoseconds[p].store(0, memory_order_relaxed);
+            for (int b = 0; b < LATENCY_BUCKETS; b++) {
+                latencyBuckets[p][b].store(0, memory_order_relaxed);
+            }
+        }
+        for (int t = 0; t < TURN_COUNT_BUCKETS; t++) {
+            battleTurns[t].store(0, memory_order_relaxed);
+        }
+        lock_guard<mutex> lock(registryMutex);
+        next = liveThreads;
+        if (next) {
+            next->previous = this;
+        }
+        liveThreads = this;
+    }
+    
+    ThreadMetrics::~ThreadMetrics() {
+        lock_guard<mutex> lock(registryMutex);
+        addBlock(finishedThreads, *this);
+        if (previous) {
+            previous->next = next;
+        } else {
+            liveThreads = next;
+        }
+        if (next) {
+            next->previous = previous;
+        }
+    }
+    
+    // What it does: Returns the metrics block of the calling thread (created on first use, without heap allocation)
+    // Inputs: None
+    // Outputs: Reference to the block
+    ThreadMetrics& threadMetrics() {
+        static thread_local ThreadMetrics metrics;
+        return metrics;
+    }
+    
+    // What it does: Finds the latency bucket of a duration
+    // Inputs: nanoseconds - duration
+    // Outputs: Bucket index (0 to LATENCY_BUCKETS - 1)
+    int latencyBucket(uint64_t nanoseconds) {
+        int bucket = nanoseconds == 0 ? 0 : 64 - __builtin_clzll(nanoseconds);
+        return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+    }
+    
+    // What it does: Returns the upper bound of the latency bucket holding a quantile
+    // Inputs: buckets - latency histogram of a phase, count - number of samples, quantile - quantile (0 to 1)
+    // Outputs: Upper bound in nanoseconds (0 if there are no samples)
+    uint64_t quantileBound(const uint64_t* buckets, uint64_t count, double quantile) {
+        if (count == 0) return 0;
+        uint64_t rank = (uint64_t)(quantile * (count - 1)) + 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            seen += buckets[b];
+            if (seen >= rank) {
+                return (uint64_t)1 << b;
+            }
+        }
+        return (uint64_t)1 << (LATENCY_BUCKETS - 1);
+    }
+}
+
+const char* getMetricPhaseName(MetricPhase phase) {
+    return METRIC_PHASE_NAMES[(int)phase];
+}
+
+void recordPhase(MetricPhase phase, uint64_t nanoseconds) {
+    ThreadMetrics& metrics = threadMetrics();
+    int p = (int)phase;
+    bump(metrics.phaseCount[p], 1);
+    bump(metrics.phaseNanoseconds[p], nanoseconds);
+    bump(metrics.latencyBuckets[p][latencyBucket(nanoseconds)], 1);
+}
+
+void recordBattleTurns(int turns) {
+    int bucket = turns < 0 ? 0 : (turns < TURN_COUNT_BUCKETS ? turns : TURN_COUNT_BUCKETS - 1);
+    bump(threadMetrics().battleTurns[bucket], 1);
+}
+
+MetricsSnapshot getMetricsSnapshot() {
+    lock_guard<mutex> lock(registryMutex);
+    MetricsSnapshot totals = finishedThreads;
+    for (ThreadMetrics* block = liveThreads; block; block = block->next) {
+        addBlock(totals, *block);
+    }
+    return totals;
+}
+
+void writeMetricsJson(std::ostream& out, const MetricsSnapshot& snapshot) {
+    out << "{\n  \"enabled\": " << (metricsEnabled() ? "true" : "false") << ",\n  \"phases\": {\n";
+    for (int p = 0; p < METRIC_PHASE_COUNT; p++) {
+        uint64_t count = snapshot.phaseCount[p];
+        out << "    \"" << METRIC_PHASE_NAMES[p] << "\": {\"count\": " << count
+            << ", \"total_ns\": " << snapshot.phaseNanoseconds[p]
+            << ", \"mean_ns\": " << (count ? snapshot.phaseNanoseconds[p] / count : 0)
+            << ", \"p50_ns\": " << quantileBound(snapshot.latencyBuckets[p], count, 0.5)
+            << ", \"p99_ns\": " << quantileBound(snapshot.latencyBuckets[p], count, 0.99)
+            << ", \"buckets\": [";
+        // Only non-empty buckets, as [upper bound in ns, count]
+        bool first = true;
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            if (snapshot.latencyBuckets[p][b] == 0) continue;
+            out << (first ? "" : ", ") << "[" << ((uint64_t)1 << b) << ", " << snapshot.latencyBuckets[p][b] << "]";
+            first = false;
+        }
+        out << "]}" << (p + 1 < METRIC_PHASE_COUNT ? "," : "") << "\n";
+    }
+    
+    uint64_t battles = 0, turns = 0;
+    for (int t = 0; t < TURN_COUNT_BUCKETS; t++) {
+        battles += snapshot.battleTurns[t];
+        turns += snapshot.battleTurns[t] * t;
+    }
+    out << "  },\n  \"battle_turns\": {\"battles\": " << battles << ", \"mean\": "
+        << (battles ? (double)turns / battles : 0.0) << ", \"histogram\": {";
+    bool first = true;
+    for (int t = 0; t < TURN_COUNT_BUCKETS; t++) {
+        if (snapshot.battleTurns[t] == 0) continue;
+        out << (first ? "" : ", ") << "\"" << t << "\": " << snapshot.battleTurns[t];
+        first = false;
+    }
+    out << "}}\n}\n";
+}
+
+void writeMetricsPrometheus(std::ostream& out, const MetricsSnapshot& snapshot) {
+    out << "# HELP ftm_phase_duration_seconds Time spent in each phase of a session.\n";
+    out << "# TYPE ftm_phase_duration_seconds histogram\n";
+    for (int p = 0; p < METRIC_PHASE_COUNT; p++) {
+        const char* name = METRIC_PHASE_NAMES[p];
+        uint64_t cumulative = 0;
+        for (int b = 0; b < LATENCY_BUCKETS - 1; b++) {
+            cumulative += snapshot.latencyBuckets[p][b];
+            out << "ftm_phase_duration_seconds_bucket{phase=\"" << name << "\",le=\"" << ((uint64_t)1 << b) * 1e-9
+                << "\"} " << cumulative << "\n";
+        }
+        out << "ftm_phase_duration_seconds_bucket{phase=\"" << name << "\",le=\"+Inf\"} " << snapshot.phaseCount[p] << "\n";
+        out << "ftm_phase_duration_seconds_sum{phase=\"" << name << "\"} " << snapshot.phaseNanoseconds[p] * 1e-9 << "\n";
+        out << "ftm_phase_duration_seconds_count{phase=\"" << name << "\"} " << snapshot.phaseCount[p] << "\n";
+    }
+    
+    out << "# HELP ftm_battle_turns Turns taken by finished battles.\n";
+    out << "# TYPE ftm_battle_turns histogram\n";
+    uint64_t cumulative = 0, turns = 0;
+    for (int t = 0; t < TURN_COUNT_BUCKETS - 1; t++) {
+        cumulative += snapshot.battleTurns[t];
+        turns += snapshot.battleTurns[t] * t;
+        out << "ftm_battle_turns_bucket{le=\"" << t << "\"} " << cumulative << "\n";
+    }
+    cumulative += snapshot.battleTurns[TURN_COUNT_BUCKETS - 1];
+    turns += snapshot.battleTurns[TURN_COUNT_BUCKETS - 1] * (TURN_COUNT_BUCKETS - 1);
+    out << "ftm_battle_turns_bucket{le=\"+Inf\"} " << cumulative << "\n";
+    out << "ftm_battle_turns_sum " << turns << "\n";
+    out << "ftm_battle_turns_count " << cumulative << "\n";
+}
+
+bool writeMetricsFile(const std::string& fileName) {
+    ofstream file(fileName);
+    MetricsSnapshot snapshot = getMetricsSnapshot();
+    const char* suffix = ".prom";
+    size_t suffixLength = strlen(suffix);
+    if (fileName.size() >= suffixLength && fileName.compare(fileName.size() - suffixLength, suffixLength, suffix) == 0) {
+        writeMetricsPrometheus(file, snapshot);
+    } else {
+        writeMetricsJson(file, snapshot);
+    }
+    file.close();
+    return !file.fail();
+}
@@ -0,0 +1,127 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Hot-path instrumentation: a counter and a latency histogram per phase of a session, plus the
+// distribution of battle lengths. Only builds with METRICS_ENABLED defined (make METRICS=1) record
+// anything: otherwise METRIC_TIME and METRIC_BATTLE_TURNS expand to nothing and the hot paths
+// contain no instrumentation code at all.
+// Every thread records into its own block (no shared cache lines or locks on the hot path); the
+// blocks are summed when a snapshot is taken.
+
+// Timed phases of a session
+enum class MetricPhase : unsigned char {
+    BattleTurn,
+    EnemyTurn,
+    BossAction,
+    Event,
+    ShopVisit,
+    Save,
+    Load,
+    SaveStall
+};
+
+const int METRIC_PHASE_COUNT = 8;
+
+// Latency histogram buckets: bucket i counts durations below 2^i nanoseconds (the last one counts the rest)
+const int LATENCY_BUCKETS = 40;
+
+// Battle length histogram buckets: bucket t counts battles that took t turns (the last one counts longer battles)
+const int TURN_COUNT_BUCKETS = 64;
+
+// Summed metrics of every thread
+struct MetricsSnapshot {
+    uint64_t phaseCount[METRIC_PHASE_COUNT];
+    uint64_t phaseNanoseconds[METRIC_PHASE_COUNT];
+    uint64_t latencyBuckets[METRIC_PHASE_COUNT][LATENCY_BUCKETS];
+    uint64_t battleTurns[TURN_COUNT_BUCKETS];
+};
+
+// What it does: Checks if this build records metrics
+// Inputs: None
+// Outputs: Returns true if it was compiled with METRICS_ENABLED
+constexpr bool metricsEnabled() {
+#ifdef METRICS_ENABLED
+    return true;
+#else
+    return false;
+#endif
+}
+
+// What it does: Returns the name of a phase used in exported metrics
+// Inputs: phase - timed phase
+// Outputs: Phase name (C string, e.g. "enemy_turn")
+const char* getMetricPhaseName(MetricPhase phase);
+
+// What it does: Records one timed run of a phase for the calling thread
+// Inputs: phase - timed phase, nanoseconds - time it took
+// Outputs: None
+void recordPhase(MetricPhase phase, uint64_t nanoseconds);
+
+// What it does: Records the length of a finished battle for the calling thread
+// Inputs: turns - turns the battle took
+// Outputs: None
+void recordBattleTurns(int turns);
+
+// What it does: Sums the metrics recorded by every thread so far (including threads that have finished)
+// Inputs: None
+// Outputs: Snapshot of the totals
+MetricsSnapshot getMetricsSnapshot();
+
+// What it does: Writes a snapshot as JSON (count, total, mean and p50/p99 upper bounds per phase, plus the histograms)
+// Inputs: out - stream to write to, snapshot - metrics to write
+// Outputs: None
+void writeMetricsJson(std::ostream& out, const MetricsSnapshot& snapshot);
+
+// What it does: Writes a snapshot in the Prometheus text exposition format (ftm_phase_duration_seconds and ftm_battle_turns histograms)
+// Inputs: out - stream to write to, snapshot - metrics to write
+// Outputs: None
+void writeMetricsPrometheus(std::ostream& out, const MetricsSnapshot& snapshot);
+
+// What it does: Writes the current metrics to a file, as Prometheus text if the name ends in ".prom", as JSON otherwise
+// Inputs: fileName - file to write
+// Outputs: Returns true if the file was written, false otherwise
+bool writeMetricsFile(const std::string& fileName);
+
+// Measures the phase of its scope (use it through METRIC_TIME)
+class PhaseTimer {
+private:
+    MetricPhase phase;
+    std::chrono::steady_clock::time_point start;
+    
+public:
+    // What it does: Starts timing a phase
+    // Inputs: phase - phase to time
+    // Outputs: None
+    explicit PhaseTimer(MetricPhase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    
+    // What it does: Records the time since construction for the phase
+    // Inputs: None
+    // Outputs: None
+    ~PhaseTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        recordPhase(phase, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+#define METRIC_CONCAT_INNER(a, b) a##b
+#define METRIC_CONCAT(a, b) METRIC_CONCAT_INNER(a, b)
+
+#ifdef METRICS_ENABLED
+// Times the rest of the enclosing scope as one run of a MetricPhase
+#define METRIC_TIME(phase) PhaseTimer METRIC_CONCAT(phaseTimer, __LINE__)(phase)
+// Records the length of a finished battle
+#define METRIC_BATTLE_TURNS(turns) recordBattleTurns(turns)
+#else
+#define METRIC_TIME(phase) ((void)0)
+#define METRIC_BATTLE_TURNS(turns) ((void)0)
+#endif
+
+#endif
@@ -1,14 +1,60 @@
 #include "player.h"
-#include <algorithm>
+#include <cmath>
 using namespace std;
 
+namespace {
+    // Equipment names indexed by EquipmentType
+    const char* const EQUIPMENT_NAMES[EQUIPMENT_TYPE_COUNT] = {"Shield", "Sword", "Armor", "Shoes"};
+}
+
+const char* getEquipmentName(EquipmentType type) {
+    if (type == EquipmentType::None) {
+        return "";
+    }
+    return EQUIPMENT_NAMES[(int)type];
+}
+
+EquipmentType parseEquipmentType(const std::string& name) {
+    for (int i = 0; i < EQUIPMENT_TYPE_COUNT; i++) {
+        if (name == EQUIPMENT_NAMES[i]) {
+            return (EquipmentType)i;
+        }
+    }
+    return EquipmentType::None;
+}
+
 Player::Player() : maxHealth(100), currentHealth(100), baseAttack(25), 
-                   gold(0), bossAttackBonus(0), extraActions(0), disabledEquipment("") {
-    equipment.clear();
+                   gold(0), bossAttackBonus(0), equipmentCount(0), extraActions(0), 
+                   disabledEquipment(EquipmentType::None) {
+    clearEquipment();
 }
 
 Player::~Player() {
-    equipment.clear();
+}
+
+void Player::updateDerivedStats() {
+    int armorCount = countEquipment(EquipmentType::Armor);
+    int swordCount = countEquipment(EquipmentType::Sword);
+    int shieldCount = countEquipment(EquipmentType::Shield);
+    int shoesCount = countEquipment(EquipmentType::Shoes);
+    
+    derived.maxHealth = maxHealth;
+    if (disabledEquipment != EquipmentType::Armor) {
+        derived.maxHealth += armorCount * 100;
+    }
+    
+    derived.attack = baseAttack;
+    if (disabledEquipment != EquipmentType::Sword) {
+        derived.attack += (int)(baseAttack * 0.5 * swordCount);
+    }
+    derived.attack += bossAttackBonus;
+    
+    derived.damageMultiplier = 1.0;
+    if (disabledEquipment != EquipmentType::Shield) {
+        derived.damageMultiplier = ldexp(1.0, -shieldCount);
+    }
+    
+    derived.extraActions = (disabledEquipment != EquipmentType::Shoes) ? shoesCount : 0;
 }
 
 int Player::getCurrentHealth() const {
@@ -16,22 +62,11 @@ int Player::getCurrentHealth() const {
 }
 
 int Player::getMaxHealth() const {
-    int totalMaxHealth = maxHealth;
-    int armorCount = countEquipment("Armor");
-    if (disabledEquipment != "Armor") {
-        totalMaxHealth += armorCount * 100;
-    }
-    return totalMaxHealth;
+    return derived.maxHealth;
 }
 
 int Player::getAttack() const {
-    int totalAttack = baseAttack;
-    int swordCount = countEquipment("Sword");
-    if (disabledEquipment != "Sword") {
-        totalAttack += (int)(baseAttack * 0.5 * swordCount);
-    }
-    totalAttack += bossAttackBonus;
-    return totalAttack;
+    return derived.attack;
 }
 
 int Player::getGold() const {
@@ -43,15 +78,15 @@ int Player::getBossAttackBonus() const {
 }
 
 void Player::takeDamage(int damage) {
-    int shieldCount = countEquipment("Shield");
-    double reductionFactor = 1.0;
-    if (disabledEquipment != "Shield") {
-        for (int i = 0; i < shieldCount; i++) {
-            reductionFactor *= 0.5;
-        }
-    }
-    int actualDamage = (int)(damage * reductionFactor);
-    currentHealth -= actualDamage;
+    loseHealth((int)(damage * derived.damageMultiplier));
+}
+
+double Player::getDamageMultiplier() const {
+    return derived.damageMultiplier;
+}
+
+void Player::loseHealth(int amount) {
+    currentHealth -= amount;
     if (currentHealth < 0) {
         currentHealth = 0;
     }
@@ -59,44 +94,63 @@ void Player::takeDamage(int damage) {
 
 void Player::heal(int amount) {
     currentHealth += amount;
-    if (currentHealth > getMaxHealth()) {
-        currentHealth = getMaxHealth();
+    if (currentHealth > derived.maxHealth) {
+        currentHealth = derived.maxHealth;
     }
 }
 
 void Player::restoreToFull() {
-    currentHealth = getMaxHealth();
+    currentHealth = derived.maxHealth;
 }
 
 bool Player::addEquipment(const std::string& equipName) {
-    if (equipment.size() >= 3) {
+    return addEquipment(parseEquipmentType(equipName));
+}
+
+bool Player::addEquipment(EquipmentType type) {
+    if (equipmentCount >= MAX_EQUIPMENT || type == EquipmentType::None) {
         return false;
     }
-    equipment.push_back(equipName);
+    equipment[equipmentCount++] = type;
+    equipmentTypeCounts[(int)type]++;
     
-    if (equipName == "Shoes") {
+    if (type == EquipmentType::Shoes) {
         extraActions++;
     }
     
+    updateDerivedStats();
     return true;
 }
 
 std::vector<std::string> Player::getEquipment() const {
-    return equipment;
+    std::vector<std::string> names;
+    for (int i = 0; i < equipmentCount; i++) {
+        names.push_back(getEquipmentName(equipment[i]));
+    }
+    return names;
+}
+
+int Player::getEquippedCount() const {
+    return equipmentCount;
+}
+
+EquipmentType Player::getEquippedItem(int slot) const {
+    return equipment[slot];
 }
 
 bool Player::hasEquipment(const std::string& equipName) const {
-    return std::find(equipment.begin(), equipment.end(), equipName) != equipment.end();
+    return countEquipment(equipName) > 0;
 }
 
 int Player::countEquipment(const std::string& equipName) const {
-    int count = 0;
-    for (const auto& equip : equipment) {
-        if (equip == equipName) {
-            count++;
-        }
+    return countEquipment(parseEquipmentType(equipName));
+}
+
+int Player::countEquipment(EquipmentType type) const {
+    if (type == EquipmentType::None) {
+        return 0;
     }
-    return count;
+    return equipmentTypeCounts[(int)type];
 }
 
 int Player::getExtraActions() const {
@@ -116,10 +170,12 @@ void Player::useExtraAction() {
 void Player::increaseMaxHealth(int amount) {
     maxHealth += amount;
     currentHealth += amount;
+    updateDerivedStats();
 }
 
 void Player::increaseAttack(int amount) {
     baseAttack += amount;
+    updateDerivedStats();
 }
 
 void Player::addGold(int amount) {
@@ -136,20 +192,23 @@ bool Player::spendGold(int amount) {
 
 void Player::addBossAttackBonus(int amount) {
     bossAttackBonus += amount;
+    updateDerivedStats();
 }
 
 void Player::setBaseMaxHealth(int health) {
     maxHealth = health;
+    updateDerivedStats();
 }
 
 void Player::setBaseAttack(int attack) {
     baseAttack = attack;
+    updateDerivedStats();
 }
 
 void Player::setCurrentHealth(int health) {
     currentHealth = health;
-    if (currentHealth > getMaxHealth()) {
-        currentHealth = getMaxHealth();
+    if (currentHealth > derived.maxHealth) {
+        currentHealth = derived.maxHealth;
     }
 }
 
@@ -159,11 +218,19 @@ void Player::setGold(int amount) {
 
 void Player::setBossAttackBonus(int bonus) {
     bossAttackBonus = bonus;
+    updateDerivedStats();
 }
 
 void Player::clearEquipment() {
-    equipment.clear();
+    equipmentCount = 0;
+    for (int i = 0; i < MAX_EQUIPMENT; i++) {
+        equipment[i] = EquipmentType::None;
+    }
+    for (int i = 0; i < EQUIPMENT_TYPE_COUNT; i++) {
+        equipmentTypeCounts[i] = 0;
+    }
     extraActions = 0;
+    updateDerivedStats();
 }
 
 int Player::getBaseMaxHealth() const {
@@ -175,13 +242,69 @@ int Player::getBaseAttack() const {
 }
 
 void Player::setDisabledEquipment(const std::string& equipName) {
-    disabledEquipment = equipName;
+    setDisabledEquipment(parseEquipmentType(equipName));
+}
+
+void Player::setDisabledEquipment(EquipmentType type) {
+    disabledEquipment = type;
+    updateDerivedStats();
 }
 
 std::string Player::getDisabledEquipment() const {
+    return getEquipmentName(disabledEquipment);
+}
+
+EquipmentType Player::getDisabledEquipmentType() const {
     return disabledEquipment;
 }
 
 bool Player::isAlive() const {
     return currentHealth > 0;
 }
+
+void Player::saveSnapshot(PlayerSnapshot& snapshot) const {
+    snapshot.baseMaxHealth = maxHealth;
+    snapshot.currentHealth = currentHealth;
+    snapshot.baseAttack = baseAttack;
+    snapshot.gold = gold;
+    snapshot.bossAttackBonus = bossAttackBonus;
+    snapshot.extraActions = extraActions;
+    snapshot.equipmentCount = (uint8_t)equipmentCount;
+    for (int i = 0; i < MAX_EQUIPMENT; i++) {
+        snapshot.equipment[i] = equipment[i];
+    }
+    snapshot.disabledEquipment = disabledEquipment;
+}
+
+void Player::restoreSnapshot(const PlayerSnapshot& snapshot) {
+    maxHealth = snapshot.baseMaxHealth;
+    currentHealth = snapshot.currentHealth;
+    baseAttack = snapshot.baseAttack;
+    gold = snapshot.gold;
+    bossAttackBonus = snapshot.bossAttackBonus;
+    extraActions = snapshot.extraActions;
+    equipmentCount = snapshot.equipmentCount;
+    for (int i = 0; i < EQUIPMENT_TYPE_COUNT; i++) {
+        equipmentTypeCounts[i] = 0;
+    }
+    for (int i = 0; i < MAX_EQUIPMENT; i++) {
+        equipment[i] = snapshot.equipment[i];
+        if (i < equipmentCount) {
+            equipmentTypeCounts[(int)equipment[i]]++;
+        }
+    }
+    disabledEquipment = snapshot.disabledEquipment;
+    updateDerivedStats();
+}
+
+std::vector<std::string> Player::getEquipmentTypes() {
+    return std::vector<std::string>(EQUIPMENT_NAMES, EQUIPMENT_NAMES + EQUIPMENT_TYPE_COUNT);
+}
+
+std::string Player::getRandomEquipment(Random& rng) {
+    return getEquipmentName(getRandomEquipmentType(rng));
+}
+
+EquipmentType Player::getRandomEquipmentType(Random& rng) {
+    return (EquipmentType)rng.nextInt(EQUIPMENT_TYPE_COUNT);
+}
@@ -1,8 +1,56 @@
 #ifndef PLAYER_H
 #define PLAYER_H
 
+#include "rng.h"
 #include <vector>
 #include <string>
+#include <cstdint>
+
+// Compact equipment identifiers (None marks "no equipment", e.g. nothing disabled)
+enum class EquipmentType : unsigned char {
+    Shield,
+    Sword,
+    Armor,
+    Shoes,
+    None
+};
+
+const int EQUIPMENT_TYPE_COUNT = 4;
+
+// Maximum number of equipment pieces a player can carry
+const int MAX_EQUIPMENT = 3;
+
+// What it does: Returns the display name of an equipment type
+// Inputs: type - equipment type
+// Outputs: Equipment name (C string, empty for None)
+const char* getEquipmentName(EquipmentType type);
+
+// What it does: Converts an equipment name to its type
+// Inputs: name - equipment name ("Shield", "Sword", "Armor" or "Shoes")
+// Outputs: Equipment type (None if the name is unknown or empty)
+EquipmentType parseEquipmentType(const std::string& name);
+
+// Player stats that depend on base stats and equipment
+// Recomputed only when base stats, equipment or disabled equipment change
+struct DerivedStats {
+    int attack;
+    int maxHealth;
+    double damageMultiplier;
+    int extraActions;
+};
+
+// Complete state of a player as plain values (trivially copyable, see Player::saveSnapshot)
+struct PlayerSnapshot {
+    int32_t baseMaxHealth;
+    int32_t currentHealth;
+    int32_t baseAttack;
+    int32_t gold;
+    int32_t bossAttackBonus;
+    int32_t extraActions;
+    uint8_t equipmentCount;
+    EquipmentType equipment[MAX_EQUIPMENT];
+    EquipmentType disabledEquipment;
+};
 
 class Player {
 private:
@@ -11,9 +59,17 @@ private:
     int baseAttack;
     int gold;
     int bossAttackBonus;
-    std::vector<std::string> equipment;
+    EquipmentType equipment[MAX_EQUIPMENT];
+    int equipmentCount;
+    unsigned char equipmentTypeCounts[EQUIPMENT_TYPE_COUNT];
     int extraActions;
-    std::string disabledEquipment;
+    EquipmentType disabledEquipment;
+    DerivedStats derived;
+    
+    // What it does: Recomputes the derived stats block from base stats and active equipment
+    // Inputs: None
+    // Outputs: None
+    void updateDerivedStats();
     
 public:
     // What it does: Initializes player with default values (100 health, 25 attack, 0 gold, empty equipment)
@@ -51,11 +107,26 @@ public:
     // Outputs: Boss attack bonus value (int)
     int getBossAttackBonus() const;
     
+    // What it does: Returns the cached block of stats derived from base stats and equipment
+    // Inputs: None
+    // Outputs: Reference to the derived stats
+    const DerivedStats& getDerivedStats() const { return derived; }
+    
     // What it does: Reduces player health by damage amount (after applying shield reduction)
     // Inputs: damage - raw damage amount before reduction
     // Outputs: None
     void takeDamage(int damage);
     
+    // What it does: Returns the factor incoming damage is multiplied by (0.5 per active shield)
+    // Inputs: None
+    // Outputs: Damage multiplier (double)
+    double getDamageMultiplier() const;
+    
+    // What it does: Reduces player health by an amount that has already been reduced by shields
+    // Inputs: amount - health to lose
+    // Outputs: None
+    void loseHealth(int amount);
+    
     // What it does: Restores player health by specified amount (capped at max health)
     // Inputs: amount - amount of health to restore
     // Outputs: None
@@ -71,6 +142,21 @@ public:
     // Outputs: Returns true if equipment was added, false if inventory is full
     bool addEquipment(const std::string& equipName);
     
+    // What it does: Adds equipment to player inventory (maximum 3 pieces)
+    // Inputs: type - equipment type to add
+    // Outputs: Returns true if equipment was added, false if inventory is full
+    bool addEquipment(EquipmentType type);
+    
+    // What it does: Returns number of equipment pieces carried
+    // Inputs: None
+    // Outputs: Equipment piece count (int)
+    int getEquippedCount() const;
+    
+    // What it does: Returns equipment in given inventory slot (in the order it was obtained)
+    // Inputs: slot - slot index (0 to getEquippedCount() - 1)
+    // Outputs: Equipment type
+    EquipmentType getEquippedItem(int slot) const;
+    
     // What it does: Returns list of all equipped items
     // Inputs: None
     // Outputs: Vector of equipment names
@@ -86,6 +172,11 @@ public:
     // Outputs: Number of that equipment type (int)
     int countEquipment(const std::string& equipName) const;
     
+    // What it does: Counts number of specific equipment pieces
+    // Inputs: type - equipment type to count
+    // Outputs: Number of that equipment type (int)
+    int countEquipment(EquipmentType type) const;
+    
     // What it does: Returns number of extra actions available (from Shoes equipment)
     // Inputs: None
     // Outputs: Number of extra actions (int)
@@ -171,15 +262,50 @@ public:
     // Outputs: None
     void setDisabledEquipment(const std::string& equipName);
     
+    // What it does: Sets disabled equipment for next battle (from negative events)
+    // Inputs: type - equipment type to disable (None to clear)
+    // Outputs: None
+    void setDisabledEquipment(EquipmentType type);
+    
     // What it does: Returns name of disabled equipment
     // Inputs: None
     // Outputs: Name of disabled equipment (empty string if none)
     std::string getDisabledEquipment() const;
     
+    // What it does: Returns type of disabled equipment
+    // Inputs: None
+    // Outputs: Disabled equipment type (None if none)
+    EquipmentType getDisabledEquipmentType() const;
+    
+    // What it does: Returns list of all equipment types
+    // Inputs: None
+    // Outputs: Vector of equipment names
+    static std::vector<std::string> getEquipmentTypes();
+    
+    // What it does: Returns a random equipment type name
+    // Inputs: rng - random number generator to draw from
+    // Outputs: Name of random equipment (string)
+    static std::string getRandomEquipment(Random& rng);
+    
+    // What it does: Returns a random equipment type without building any names (same draw as getRandomEquipment)
+    // Inputs: rng - random number generator to draw from
+    // Outputs: Random equipment type (never None)
+    static EquipmentType getRandomEquipmentType(Random& rng);
+    
     // What it does: Checks if player is alive
     // Inputs: None
     // Outputs: Returns true if health > 0, false otherwise
     bool isAlive() const;
+    
+    // What it does: Copies the player's state into a snapshot
+    // Inputs: snapshot - snapshot to fill
+    // Outputs: None
+    void saveSnapshot(PlayerSnapshot& snapshot) const;
+    
+    // What it does: Restores the state of a snapshot (no heap allocation)
+    // Inputs: snapshot - snapshot taken with saveSnapshot
+    // Outputs: None
+    void restoreSnapshot(const PlayerSnapshot& snapshot);
 };
 
 #endif
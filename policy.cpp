@@ -0,0 +1,50 @@
+#include "policy.h"
+using namespace std;
+
+AutoBattlePolicy::AutoBattlePolicy(int healThresholdPercent) 
+    : healThresholdPercent(healThresholdPercent) {
+}
+
+string AutoBattlePolicy::pickPotion(const Battle& battle, const PotionManager& potions) const {
+    const Player& player = battle.getPlayer();
+    if (player.getCurrentHealth() * 100 < player.getMaxHealth() * healThresholdPercent &&
+        potions.hasPotion(PotionType::Life)) {
+        return getPotionName(PotionType::Life);
+    }
+    if (potions.hasPotion(PotionType::Mystery)) {
+        return getPotionName(PotionType::Mystery);
+    }
+    if (potions.hasPotion(PotionType::Attacker)) {
+        return getPotionName(PotionType::Attacker);
+    }
+    if (potions.hasPotion(PotionType::Strength)) {
+        return getPotionName(PotionType::Strength);
+    }
+    return "";
+}
+
+BattleAction AutoBattlePolicy::chooseAction(const Battle& battle) {
+    if (!pickPotion(battle, battle.getPotionManager()).empty()) {
+        return BattleAction::UsePotion;
+    }
+    return BattleAction::Attack;
+}
+
+int AutoBattlePolicy::chooseTarget(const Battle& battle) {
+    const EnemyPool& enemies = battle.getEnemies();
+    int best = -1;
+    for (int i = 0; i < enemies.size(); i++) {
+        if (!enemies.isAlive(i)) continue;
+        if (best < 0 ||
+            enemies.getAttack(i) > enemies.getAttack(best) ||
+            (enemies.getAttack(i) == enemies.getAttack(best) && 
+             enemies.getHealth(i) < enemies.getHealth(best))) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+string AutoBattlePolicy::choosePotion(const Battle& battle, const PotionManager& potions) {
+    return pickPotion(battle, potions);
+}
@@ -0,0 +1,40 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "battle.h"
+
+// Battle policy that plays automatically without any terminal I/O (used for simulations)
+// Drinks permanent potions as soon as it has them, heals with Life Potions when low on HP,
+// and always attacks the most dangerous alive enemy
+class AutoBattlePolicy : public BattlePolicy {
+private:
+    int healThresholdPercent;
+    
+    // What it does: Picks the potion this policy would drink right now
+    // Inputs: battle - battle being played, potions - player's potion inventory
+    // Outputs: Name of the potion to drink, or empty string if none is worth drinking
+    std::string pickPotion(const Battle& battle, const PotionManager& potions) const;
+    
+public:
+    // What it does: Initializes the policy
+    // Inputs: healThresholdPercent - drink a Life Potion when HP is below this percentage of max HP
+    // Outputs: None
+    AutoBattlePolicy(int healThresholdPercent = 40);
+    
+    // What it does: Chooses to drink a potion when one is worth drinking, otherwise attacks
+    // Inputs: battle - battle being played
+    // Outputs: Chosen action
+    BattleAction chooseAction(const Battle& battle) override;
+    
+    // What it does: Chooses the alive enemy with the highest attack (lowest HP breaks ties)
+    // Inputs: battle - battle being played
+    // Outputs: Index of the chosen enemy
+    int chooseTarget(const Battle& battle) override;
+    
+    // What it does: Chooses the potion picked by pickPotion
+    // Inputs: battle - battle being played, potions - player's potion inventory
+    // Outputs: Name of the potion to use, or empty string to cancel
+    std::string choosePotion(const Battle& battle, const PotionManager& potions) override;
+};
+
+#endif
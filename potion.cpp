@@ -1,64 +1,129 @@
 #include "potion.h"
-#include <cstdlib>
-#include <ctime>
 #include <vector>
 using namespace std;
 
+const PotionType PotionView::ORDER[POTION_TYPE_COUNT] = {
+    PotionType::Attacker, PotionType::Life, PotionType::Mystery, PotionType::Strength
+};
+
+const char* getPotionName(PotionType type) {
+    if (type == PotionType::None) {
+        return "";
+    }
+    return getPotionTraits(type).name;
+}
+
+PotionType parsePotionType(const std::string& name) {
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        if (name == POTION_TRAITS[i].name) {
+            return (PotionType)i;
+        }
+    }
+    return PotionType::None;
+}
+
+int PotionView::size() const {
+    int held = 0;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        held += counts[i] > 0;
+    }
+    return held;
+}
+
+bool PotionView::empty() const {
+    return !(begin() != end());
+}
+
 PotionManager::PotionManager() {
-    potions.clear();
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        counts[i] = 0;
+    }
 }
 
 PotionManager::~PotionManager() {
-    potions.clear();
 }
 
 void PotionManager::addPotion(const std::string& potionName, int quantity) {
-    if (potions.find(potionName) != potions.end()) {
-        potions[potionName] += quantity;
-    } else {
-        potions[potionName] = quantity;
+    addPotion(parsePotionType(potionName), quantity);
+}
+
+void PotionManager::addPotion(PotionType type, int quantity) {
+    if (type != PotionType::None) {
+        counts[(int)type] += quantity;
     }
 }
 
 bool PotionManager::usePotion(const std::string& potionName) {
-    if (potions.find(potionName) != potions.end() && potions[potionName] > 0) {
-        potions[potionName]--;
-        if (potions[potionName] == 0) {
-            potions.erase(potionName);
-        }
+    return usePotion(parsePotionType(potionName));
+}
+
+bool PotionManager::usePotion(PotionType type) {
+    if (type != PotionType::None && counts[(int)type] > 0) {
+        counts[(int)type]--;
         return true;
     }
     return false;
 }
 
 int PotionManager::getQuantity(const std::string& potionName) const {
-    auto it = potions.find(potionName);
-    if (it != potions.end()) {
-        return it->second;
+    return getQuantity(parsePotionType(potionName));
+}
+
+int PotionManager::getQuantity(PotionType type) const {
+    return type != PotionType::None ? counts[(int)type] : 0;
+}
+
+PotionView PotionManager::getAllPotions() const {
+    return PotionView(counts);
+}
+
+int PotionManager::getTotalQuantity() const {
+    int total = 0;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        if (counts[i] > 0) {
+            total += counts[i];
+        }
     }
-    return 0;
+    return total;
 }
 
-std::map<std::string, int> PotionManager::getAllPotions() const {
-    return potions;
+bool PotionManager::isEmpty() const {
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        if (counts[i] > 0) {
+            return false;
+        }
+    }
+    return true;
 }
 
 bool PotionManager::hasPotion(const std::string& potionName) const {
-    return potions.find(potionName) != potions.end() && potions.at(potionName) > 0;
+    return hasPotion(parsePotionType(potionName));
 }
 
-std::vector<std::string> PotionManager::getPotionTypes() {
-    return {"Strength Potion", "Attacker Potion", "Life Potion", "Mystery Potion"};
+bool PotionManager::hasPotion(PotionType type) const {
+    return getQuantity(type) > 0;
 }
 
-std::string PotionManager::getRandomPotion() {
-    static bool initialized = false;
-    if (!initialized) {
-        srand(static_cast<unsigned int>(time(nullptr)));
-        initialized = true;
+void PotionManager::saveSnapshot(PotionSnapshot& snapshot) const {
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        snapshot.counts[i] = counts[i];
     }
-    
-    vector<string> types = getPotionTypes();
-    int index = rand() % types.size();
-    return types[index];
+}
+
+void PotionManager::restoreSnapshot(const PotionSnapshot& snapshot) {
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        counts[i] = snapshot.counts[i];
+    }
+}
+
+std::vector<std::string> PotionManager::getPotionTypes() {
+    vector<string> types;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        types.push_back(POTION_TRAITS[i].name);
+    }
+    return types;
+}
+
+std::string PotionManager::getRandomPotion(Random& rng) {
+    return POTION_TRAITS[rng.nextInt(POTION_TYPE_COUNT)].name;
 }
@@ -1,13 +1,148 @@
 #ifndef POTION_H
 #define POTION_H
 
+#include "rng.h"
 #include <string>
-#include <map>
 #include <vector>
+#include <cstdint>
 
+// Compact potion identifiers, in PotionManager::getPotionTypes order (None marks "no potion")
+enum class PotionType : unsigned char {
+    Strength,
+    Attacker,
+    Life,
+    Mystery,
+    None
+};
+
+// Number of potion types (see PotionManager::getPotionTypes)
+const int POTION_TYPE_COUNT = 4;
+
+// Compile-time description of one potion type and what drinking it does
+// (max HP is raised first, which raises current HP by the same amount, then HP is healed, then attack is raised)
+struct PotionTraits {
+    const char* name;
+    int maxHealth;
+    int heal;
+    int attack;
+};
+
+// Potion traits indexed by PotionType
+constexpr PotionTraits POTION_TRAITS[] = {
+    {"Strength Potion", 20, 20, 0},
+    {"Attacker Potion", 0, 0, 5},
+    {"Life Potion", 0, 50, 0},
+    {"Mystery Potion", 40, 40, 10}
+};
+
+static_assert(sizeof(POTION_TRAITS) / sizeof(POTION_TRAITS[0]) == POTION_TYPE_COUNT,
+              "POTION_TRAITS needs one entry per potion type");
+
+// What it does: Returns the compile-time traits of a potion type
+// Inputs: type - potion type (not None)
+// Outputs: Reference to the traits
+constexpr const PotionTraits& getPotionTraits(PotionType type) {
+    return POTION_TRAITS[(int)type];
+}
+
+// What it does: Returns the display name of a potion type
+// Inputs: type - potion type
+// Outputs: Potion name (C string, empty for None)
+const char* getPotionName(PotionType type);
+
+// What it does: Converts a potion name to its type
+// Inputs: name - potion name (e.g. "Life Potion")
+// Outputs: Potion type (None if the name is unknown or empty)
+PotionType parsePotionType(const std::string& name);
+
+// Potion counts of an inventory as plain values, indexed by PotionType
+struct PotionSnapshot {
+    int32_t counts[POTION_TYPE_COUNT];
+};
+
+// One kind of potion held in an inventory
+struct PotionStack {
+    PotionType type;
+    const char* name;
+    int quantity;
+};
+
+// Potions held in an inventory, in name order (the order menus, saves and status lines list them in).
+// The view reads the inventory's counts in place, so walking it never allocates; it is valid as long
+// as the inventory it was taken from.
+class PotionView {
+public:
+    // Potion types in name order
+    static const PotionType ORDER[POTION_TYPE_COUNT];
+    
+    class Iterator {
+    private:
+        const int32_t* counts;
+        int position;
+        
+        // What it does: Moves forward to the next potion type with a positive count (or the end)
+        // Inputs: None
+        // Outputs: None
+        void skipEmpty() {
+            while (position < POTION_TYPE_COUNT && counts[(int)ORDER[position]] <= 0) {
+                position++;
+            }
+        }
+        
+    public:
+        Iterator(const int32_t* counts, int position) : counts(counts), position(position) {
+            skipEmpty();
+        }
+        
+        PotionStack operator*() const {
+            PotionType type = ORDER[position];
+            return {type, getPotionTraits(type).name, counts[(int)type]};
+        }
+        
+        Iterator& operator++() {
+            position++;
+            skipEmpty();
+            return *this;
+        }
+        
+        bool operator!=(const Iterator& other) const {
+            return position != other.position;
+        }
+    };
+    
+    // What it does: Creates a view over the counts of an inventory
+    // Inputs: counts - array of POTION_TYPE_COUNT counts indexed by PotionType
+    // Outputs: None
+    explicit PotionView(const int32_t* counts) : counts(counts) {
+    }
+    
+    Iterator begin() const {
+        return Iterator(counts, 0);
+    }
+    
+    Iterator end() const {
+        return Iterator(counts, POTION_TYPE_COUNT);
+    }
+    
+    // What it does: Returns number of potion types held
+    // Inputs: None
+    // Outputs: Number of entries the view lists
+    int size() const;
+    
+    // What it does: Checks if the view lists no potions
+    // Inputs: None
+    // Outputs: Returns true if no potion type is held
+    bool empty() const;
+    
+private:
+    const int32_t* counts;
+};
+
+// Potion inventory: one count per potion type, indexed by PotionType. Names that are not potion
+// types are ignored (see parsePotionType).
 class PotionManager {
 private:
-    std::map<std::string, int> potions;
+    int32_t counts[POTION_TYPE_COUNT];
     
 public:
     // What it does: Initializes empty potion inventory
@@ -25,35 +160,75 @@ public:
     // Outputs: None
     void addPotion(const std::string& potionName, int quantity = 1);
     
+    // What it does: Adds potion to inventory with specified quantity
+    // Inputs: type - potion type to add, quantity - number of potions to add (default 1)
+    // Outputs: None
+    void addPotion(PotionType type, int quantity = 1);
+    
     // What it does: Removes one potion from inventory
     // Inputs: potionName - name of potion to use
     // Outputs: Returns true if potion was used, false if not available
     bool usePotion(const std::string& potionName);
     
+    // What it does: Removes one potion from inventory
+    // Inputs: type - potion type to use
+    // Outputs: Returns true if potion was used, false if not available
+    bool usePotion(PotionType type);
+    
     // What it does: Returns quantity of specific potion in inventory
     // Inputs: potionName - name of potion to check
     // Outputs: Number of that potion in inventory (int)
     int getQuantity(const std::string& potionName) const;
     
-    // What it does: Returns all potions in inventory as a map
+    // What it does: Returns quantity of specific potion in inventory
+    // Inputs: type - potion type to check
+    // Outputs: Number of that potion in inventory (int)
+    int getQuantity(PotionType type) const;
+    
+    // What it does: Returns the potions in inventory without copying them
     // Inputs: None
-    // Outputs: Map of potion names and quantities
-    std::map<std::string, int> getAllPotions() const;
+    // Outputs: View listing held potions with their quantities in name order
+    PotionView getAllPotions() const;
+    
+    // What it does: Returns total number of potions in inventory
+    // Inputs: None
+    // Outputs: Sum of all counts (int)
+    int getTotalQuantity() const;
+    
+    // What it does: Checks if the inventory holds no potions
+    // Inputs: None
+    // Outputs: Returns true if there are no potions, false otherwise
+    bool isEmpty() const;
     
     // What it does: Checks if potion exists in inventory
     // Inputs: potionName - name of potion to check
     // Outputs: Returns true if potion exists, false otherwise
     bool hasPotion(const std::string& potionName) const;
     
+    // What it does: Checks if potion exists in inventory
+    // Inputs: type - potion type to check
+    // Outputs: Returns true if potion exists, false otherwise
+    bool hasPotion(PotionType type) const;
+    
+    // What it does: Copies the counts into a snapshot
+    // Inputs: snapshot - snapshot to fill
+    // Outputs: None
+    void saveSnapshot(PotionSnapshot& snapshot) const;
+    
+    // What it does: Restores the counts of a snapshot
+    // Inputs: snapshot - snapshot taken with saveSnapshot
+    // Outputs: None
+    void restoreSnapshot(const PotionSnapshot& snapshot);
+    
     // What it does: Returns list of all available potion types
     // Inputs: None
     // Outputs: Vector of potion names
     static std::vector<std::string> getPotionTypes();
     
     // What it does: Returns a random potion type name
-    // Inputs: None
+    // Inputs: rng - random number generator to draw from
     // Outputs: Name of random potion (string)
-    static std::string getRandomPotion();
+    static std::string getRandomPotion(Random& rng);
 };
 
 #endif
@@ -0,0 +1,127 @@
+#include "renderer.h"
+#include "replay.h"
+#include "script.h"
+#include <limits>
+using namespace std;
+
+Renderer::FrameBuffer::FrameBuffer(ostream* target) : target(target) {
+    pending.reserve(FRAME_LIMIT);
+}
+
+Renderer::FrameBuffer::int_type Renderer::FrameBuffer::overflow(int_type ch) {
+    if (traits_type::eq_int_type(ch, traits_type::eof())) {
+        return traits_type::not_eof(ch);
+    }
+    pending.push_back(traits_type::to_char_type(ch));
+    if (pending.size() >= FRAME_LIMIT && sync() != 0) {
+        return traits_type::eof();
+    }
+    return ch;
+}
+
+streamsize Renderer::FrameBuffer::xsputn(const char* text, streamsize count) {
+    pending.append(text, count);
+    if (pending.size() >= FRAME_LIMIT && sync() != 0) {
+        return 0;
+    }
+    return count;
+}
+
+int Renderer::FrameBuffer::sync() {
+    if (!pending.empty()) {
+        target->write(pending.data(), pending.size());
+        pending.clear();
+    }
+    target->flush();
+    return target->good() ? 0 : -1;
+}
+
+Renderer::Renderer(istream& input, ostream& output, bool quiet)
+    : input(&input), script(nullptr), recorder(nullptr), quiet(quiet), frame(&output), frameStream(&frame), nullStream(nullptr) {
+}
+
+Renderer::~Renderer() {
+    present();
+}
+
+ostream& Renderer::out() {
+    return quiet ? nullStream : frameStream;
+}
+
+bool Renderer::read(int& value) {
+    present();
+    if (script) {
+        int result = script->readNumber(value);
+        if (result < 0) {
+            throw InputClosed();
+        }
+        if (recorder) {
+            if (result == 0) {
+                recorder->recordInvalid();
+            } else {
+                recorder->recordNumber(value);
+            }
+        }
+        return result > 0;
+    }
+    *input >> value;
+    if (input->fail() && input->eof()) {
+        throw InputClosed();
+    }
+    if (recorder) {
+        if (input->fail()) {
+            recorder->recordInvalid();
+        } else {
+            recorder->recordNumber(value);
+        }
+    }
+    return !input->fail();
+}
+
+bool Renderer::read(char& value) {
+    present();
+    if (script) {
+        if (!script->readLetter(value)) {
+            throw InputClosed();
+        }
+        if (recorder) {
+            recorder->recordLetter(value);
+        }
+        return true;
+    }
+    *input >> value;
+    if (input->fail()) {
+        throw InputClosed();
+    }
+    if (recorder) {
+        recorder->recordLetter(value);
+    }
+    return true;
+}
+
+void Renderer::skipLine() {
+    if (script) {
+        script->skipLine();
+        return;
+    }
+    input->clear();
+    input->ignore(numeric_limits<streamsize>::max(), '\n');
+}
+
+void Renderer::setScript(CommandScript* script) {
+    this->script = script;
+}
+
+void Renderer::setRecorder(ReplayRecorder* recorder) {
+    this->recorder = recorder;
+}
+
+void Renderer::present() {
+    if (!quiet) {
+        frameStream.flush();
+    }
+}
+
+bool Renderer::isQuiet() const {
+    return quiet;
+}
@@ -0,0 +1,114 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+class ReplayRecorder;
+class CommandScript;
+
+// Thrown when the player's input ends (end of file or closed connection); Game::run ends the session
+struct InputClosed {
+};
+
+// Output layer of the terminal game. Text is collected in a frame buffer and written to the
+// terminal in one piece when the game waits for input (or the frame grows large), instead of
+// flushing after every line. In quiet mode nothing is formatted or written at all.
+class Renderer {
+private:
+    // Stream buffer that appends to the pending frame (its capacity is kept between frames)
+    class FrameBuffer : public std::streambuf {
+    private:
+        std::ostream* target;
+        std::string pending;
+    
+    protected:
+        // What it does: Appends one character to the frame
+        // Inputs: ch - character to append
+        // Outputs: The character, or EOF if writing the frame failed
+        int_type overflow(int_type ch) override;
+        
+        // What it does: Appends characters to the frame
+        // Inputs: text - characters to append, count - number of characters
+        // Outputs: Number of characters appended
+        std::streamsize xsputn(const char* text, std::streamsize count) override;
+        
+        // What it does: Writes the pending frame to the target stream and flushes it
+        // Inputs: None
+        // Outputs: 0 on success, -1 on failure
+        int sync() override;
+    
+    public:
+        // What it does: Creates an empty frame buffer
+        // Inputs: target - stream frames are written to
+        // Outputs: None
+        explicit FrameBuffer(std::ostream* target);
+    };
+    
+    std::istream* input;
+    CommandScript* script;
+    ReplayRecorder* recorder;
+    bool quiet;
+    FrameBuffer frame;
+    std::ostream frameStream;
+    std::ostream nullStream;
+    
+public:
+    // Pending output size at which a frame is written even though no input is needed yet
+    static const size_t FRAME_LIMIT = 64 * 1024;
+    
+    // What it does: Creates a renderer on a pair of streams
+    // Inputs: input - stream player input is read from, output - stream frames are written to, quiet - true to skip all output
+    // Outputs: None
+    Renderer(std::istream& input, std::ostream& output, bool quiet = false);
+    
+    // What it does: Writes whatever is still pending
+    // Inputs: None
+    // Outputs: None
+    ~Renderer();
+    
+    // What it does: Returns the stream to print game text to (in quiet mode a stream in a failed
+    // state, so formatted output stops before any number or string is converted)
+    // Inputs: None
+    // Outputs: Output stream
+    std::ostream& out();
+    
+    // What it does: Shows the pending frame and reads a number the player types (recorded when a replay is being recorded).
+    // On invalid input the caller skips the rest of the line with skipLine.
+    // Inputs: value - reference to store the number
+    // Outputs: Returns true if a number was read, false on invalid input; throws InputClosed at the end of the input
+    bool read(int& value);
+    
+    // What it does: Shows the pending frame and reads one non-blank character (recorded like read(int&))
+    // Inputs: value - reference to store the character
+    // Outputs: Returns true if a character was read; throws InputClosed at the end of the input
+    bool read(char& value);
+    
+    // What it does: Skips the rest of the current input line after invalid input
+    // Inputs: None
+    // Outputs: None
+    void skipLine();
+    
+    // What it does: Reads player input from a command script instead of the input stream
+    // Inputs: script - command script (nullptr to read the input stream again)
+    // Outputs: None
+    void setScript(CommandScript* script);
+    
+    // What it does: Records every choice read from now on into a replay
+    // Inputs: recorder - replay recorder (nullptr to stop recording)
+    // Outputs: None
+    void setRecorder(ReplayRecorder* recorder);
+    
+    // What it does: Writes the pending frame to the terminal now
+    // Inputs: None
+    // Outputs: None
+    void present();
+    
+    // What it does: Checks if output is switched off
+    // Inputs: None
+    // Outputs: Returns true in quiet mode, false otherwise
+    bool isQuiet() const;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "replay.h"
+#include "save.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+using namespace std;
+
+static_assert(std::is_trivially_copyable<ReplayHeader>::value && sizeof(ReplayHeader) == 32,
+              "ReplayHeader must keep its on-disk layout");
+
+namespace {
+    const char REPLAY_MAGIC[4] = {'F', 'T', 'M', 'R'};
+    
+    // Decision kinds stored in the low two bits of every decision code
+    const int DECISION_NUMBER = 0;
+    const int DECISION_LETTER = 1;
+    const int DECISION_INVALID = 2;
+    
+    // Kinds of save files copied into a replay
+    const int FILE_SAVE = 0;
+    const int FILE_JOURNAL = 1;
+    
+    // What it does: Appends an unsigned value as a little-endian base-128 varint (1 byte for small menu choices)
+    // Inputs: out - buffer to append to, value - value to encode
+    // Outputs: None
+    void putVarint(string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back((char)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+    
+    // What it does: Reads a varint written by putVarint
+    // Inputs: data - buffer, pos - read position (advanced past the value), value - reference to store the value
+    // Outputs: Returns true if a complete value was read, false if the buffer ends inside it
+    bool getVarint(const string& data, size_t& pos, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos < data.size(); shift += 7) {
+            uint8_t byte = (uint8_t)data[pos++];
+            value |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+    
+    // What it does: Appends a fixed-width little-endian 32-bit value
+    // Inputs: out - buffer to append to, value - value to write
+    // Outputs: None
+    void putUint32(string& out, uint32_t value) {
+        out.append((const char*)&value, sizeof(value));
+    }
+    
+    // What it does: Reads a whole file into a string
+    // Inputs: fileName - file to read, data - string to fill
+    // Outputs: Returns true if the file exists and was read, false otherwise
+    bool readFile(const string& fileName, string& data) {
+        ifstream file(fileName, ios::binary);
+        if (!file) return false;
+        ostringstream contents;
+        contents << file.rdbuf();
+        data = contents.str();
+        return true;
+    }
+}
+
+ReplayRecorder::ReplayRecorder(const string& fileName, uint64_t seed, const string& savePrefix)
+    : fileName(fileName), seed(seed), decisionCount(0) {
+    string files;
+    int fileCount = 0;
+    for (int slot = 1; slot <= SAVE_SLOT_COUNT; slot++) {
+        SaveManager slotSave(savePrefix + SaveManager::getSlotFileName(slot));
+        const string* names[2] = {&slotSave.getFileName(), &slotSave.getJournalFileName()};
+        for (int kind = FILE_SAVE; kind <= FILE_JOURNAL; kind++) {
+            string data;
+            if (readFile(*names[kind], data)) {
+                files.push_back((char)slot);
+                files.push_back((char)kind);
+                putUint32(files, data.size());
+                files += data;
+                fileCount++;
+            }
+        }
+    }
+    saves.push_back((char)fileCount);
+    saves += files;
+}
+
+void ReplayRecorder::append(int value, int kind) {
+    uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    putVarint(decisions, ((uint64_t)zigzag << 2) | kind);
+    decisionCount++;
+}
+
+void ReplayRecorder::recordNumber(int value) {
+    append(value, DECISION_NUMBER);
+}
+
+void ReplayRecorder::recordLetter(char value) {
+    append((unsigned char)value, DECISION_LETTER);
+}
+
+void ReplayRecorder::recordInvalid() {
+    append(0, DECISION_INVALID);
+}
+
+bool ReplayRecorder::finish(uint32_t finalChecksum) const {
+    string payload = saves + decisions;
+    ReplayHeader header;
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.version = REPLAY_FORMAT_VERSION;
+    header.headerSize = sizeof(ReplayHeader);
+    header.seed = seed;
+    header.decisionCount = decisionCount;
+    header.finalChecksum = finalChecksum;
+    header.payloadSize = payload.size();
+    header.crc = SaveManager::crc32(payload.data(), payload.size());
+    
+    ofstream file(fileName, ios::binary | ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write(payload.data(), payload.size());
+    file.close();
+    return !file.fail();
+}
+
+int ReplayRecorder::getDecisionCount() const {
+    return decisionCount;
+}
+
+Replay::Replay() : seed(0), decisionCount(0), finalChecksum(0) {
+}
+
+bool Replay::load(const string& fileName) {
+    string data;
+    ReplayHeader header;
+    if (!readFile(fileName, data) || data.size() < sizeof(header)) return false;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic)) != 0 || header.version != REPLAY_FORMAT_VERSION ||
+        header.headerSize != sizeof(ReplayHeader) || data.size() - sizeof(header) != header.payloadSize ||
+        SaveManager::crc32(data.data() + sizeof(header), header.payloadSize) != header.crc) {
+        return false;
+    }
+    
+    // Walk the save file section to find where the decisions start
+    size_t pos = sizeof(header);
+    if (pos >= data.size()) return false;
+    int fileCount = (uint8_t)data[pos++];
+    for (int i = 0; i < fileCount; i++) {
+        uint32_t size;
+        if (data.size() - pos < 2 + sizeof(size)) return false;
+        memcpy(&size, data.data() + pos + 2, sizeof(size));
+        pos += 2 + sizeof(size);
+        if (data.size() - pos < size) return false;
+        pos += size;
+    }
+    
+    seed = header.seed;
+    decisionCount = header.decisionCount;
+    finalChecksum = header.finalChecksum;
+    saves = data.substr(sizeof(header), pos - sizeof(header));
+    decisions = data.substr(pos);
+    return true;
+}
+
+bool Replay::restoreSaves(const string& savePrefix) const {
+    for (int slot = 1; slot <= SAVE_SLOT_COUNT; slot++) {
+        SaveManager slotSave(savePrefix + SaveManager::getSlotFileName(slot));
+        slotSave.deleteSave();
+    }
+    
+    bool ok = true;
+    size_t pos = 0;
+    int fileCount = saves.empty() ? 0 : (uint8_t)saves[pos++];
+    for (int i = 0; i < fileCount; i++) {
+        int slot = (uint8_t)saves[pos];
+        int kind = (uint8_t)saves[pos + 1];
+        uint32_t size;
+        memcpy(&size, saves.data() + pos + 2, sizeof(size));
+        pos += 2 + sizeof(size);
+        
+        SaveManager slotSave(savePrefix + SaveManager::getSlotFileName(slot));
+        ofstream file(kind == FILE_JOURNAL ? slotSave.getJournalFileName() : slotSave.getFileName(),
+                      ios::binary | ios::trunc);
+        file.write(saves.data() + pos, size);
+        file.close();
+        ok = ok && !file.fail();
+        pos += size;
+    }
+    return ok;
+}
+
+string Replay::buildInput() const {
+    string input;
+    input.reserve(decisions.size() * 2);
+    size_t pos = 0;
+    uint64_t code;
+    while (getVarint(decisions, pos, code)) {
+        uint32_t zigzag = (uint32_t)(code >> 2);
+        int value = (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+        switch ((int)(code & 3)) {
+            case DECISION_NUMBER:
+                input += to_string(value);
+                break;
+            case DECISION_LETTER:
+                input.push_back((char)value);
+                break;
+            default:
+                input.push_back('x');
+                break;
+        }
+        input.push_back('\n');
+    }
+    return input;
+}
+
+uint64_t Replay::getSeed() const {
+    return seed;
+}
+
+int Replay::getDecisionCount() const {
+    return decisionCount;
+}
+
+uint32_t Replay::getFinalChecksum() const {
+    return finalChecksum;
+}
@@ -0,0 +1,116 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+#include <cstdint>
+
+// Version of the replay file layout written by ReplayRecorder
+const int REPLAY_FORMAT_VERSION = 1;
+
+// Fixed-size header at the start of every replay file. The payload after it holds the save
+// slot files as they were when recording started, then every decision as a variable-length code.
+struct ReplayHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+    uint64_t seed;
+    uint32_t decisionCount;
+    uint32_t finalChecksum;
+    uint32_t payloadSize;
+    uint32_t crc;
+};
+
+// Records a played game: the seed, the save slots it started from, and every choice the player
+// typed (menus, battle actions, targets, potions, shop), then writes them to a replay file.
+class ReplayRecorder {
+private:
+    std::string fileName;
+    uint64_t seed;
+    std::string saves;
+    std::string decisions;
+    uint32_t decisionCount;
+    
+    // What it does: Appends one encoded decision
+    // Inputs: value - decision value, kind - decision kind (number, letter or invalid input)
+    // Outputs: None
+    void append(int value, int kind);
+    
+public:
+    // What it does: Starts a recording and copies the current save slot files into it
+    // Inputs: fileName - replay file to write, seed - seed of the recorded game, savePrefix - prefix of the game's save file names
+    // Outputs: None
+    ReplayRecorder(const std::string& fileName, uint64_t seed, const std::string& savePrefix = "");
+    
+    // What it does: Records a number the player entered
+    // Inputs: value - number read
+    // Outputs: None
+    void recordNumber(int value);
+    
+    // What it does: Records a letter the player entered (y/n questions)
+    // Inputs: value - character read
+    // Outputs: None
+    void recordLetter(char value);
+    
+    // What it does: Records input that could not be read as a number
+    // Inputs: None
+    // Outputs: None
+    void recordInvalid();
+    
+    // What it does: Writes the replay file
+    // Inputs: finalChecksum - Game::getStateChecksum() at the end of the recorded game
+    // Outputs: Returns true if the file was written, false otherwise
+    bool finish(uint32_t finalChecksum) const;
+    
+    // What it does: Returns number of decisions recorded so far
+    // Inputs: None
+    // Outputs: Decision count (int)
+    int getDecisionCount() const;
+};
+
+// A replay file loaded for playback
+class Replay {
+private:
+    uint64_t seed;
+    uint32_t decisionCount;
+    uint32_t finalChecksum;
+    std::string saves;
+    std::string decisions;
+    
+public:
+    // What it does: Creates an empty replay
+    // Inputs: None
+    // Outputs: None
+    Replay();
+    
+    // What it does: Reads a replay file and checks its header and CRC-32
+    // Inputs: fileName - replay file to read
+    // Outputs: Returns true if the replay was loaded, false if it is missing, damaged or from a newer version
+    bool load(const std::string& fileName);
+    
+    // What it does: Puts the save slot files back the way they were when recording started
+    // Inputs: savePrefix - prefix of the save file names to restore (e.g. a scratch directory)
+    // Outputs: Returns true if every file was restored, false otherwise
+    bool restoreSaves(const std::string& savePrefix) const;
+    
+    // What it does: Rebuilds the input the player typed, one decision per line (invalid input as "x")
+    // Inputs: None
+    // Outputs: Input text for the game's input stream
+    std::string buildInput() const;
+    
+    // What it does: Returns seed of the recorded game
+    // Inputs: None
+    // Outputs: Seed (uint64_t)
+    uint64_t getSeed() const;
+    
+    // What it does: Returns number of recorded decisions
+    // Inputs: None
+    // Outputs: Decision count (int)
+    int getDecisionCount() const;
+    
+    // What it does: Returns state checksum the recorded game ended with
+    // Inputs: None
+    // Outputs: Checksum (uint32_t)
+    uint32_t getFinalChecksum() const;
+};
+
+#endif
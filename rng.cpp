@@ -0,0 +1,39 @@
+#include "rng.h"
+#include <chrono>
+using namespace std;
+
+namespace {
+    // What it does: Advances a splitmix64 state and returns its next output (used to spread seeds)
+    // Inputs: x - splitmix64 state (will be modified)
+    // Outputs: Next splitmix64 output
+    uint64_t splitMix64(uint64_t& x) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+}
+
+Random::Random(uint64_t seed) {
+    this->seed(seed);
+}
+
+void Random::seed(uint64_t seed) {
+    uint64_t x = seed;
+    for (int i = 0; i < 4; i++) {
+        state[i] = splitMix64(x);
+    }
+}
+
+uint64_t Random::randomSeed() {
+    uint64_t time = chrono::high_resolution_clock::now().time_since_epoch().count();
+    uint64_t local = 0;
+    uint64_t address = (uint64_t)(uintptr_t)&local;
+    return time ^ (address << 16);
+}
+
+uint64_t Random::deriveSeed(uint64_t seed, uint64_t stream) {
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+    splitMix64(x);
+    return splitMix64(x);
+}
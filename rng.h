@@ -0,0 +1,78 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Fast seedable random number generator (xoshiro256**)
+// Every game session owns its own Random, so the same seed always replays the same run
+// and sessions on different threads never share state
+class Random {
+private:
+    uint64_t state[4];
+    
+    // What it does: Rotates bits of a 64-bit value to the left
+    // Inputs: x - value to rotate, k - number of bits
+    // Outputs: Rotated value
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+    
+public:
+    // What it does: Initializes the generator from a seed
+    // Inputs: seed - any 64-bit value (equal seeds give equal sequences)
+    // Outputs: None
+    explicit Random(uint64_t seed = 0);
+    
+    // What it does: Restarts the generator from a seed
+    // Inputs: seed - any 64-bit value
+    // Outputs: None
+    void seed(uint64_t seed);
+    
+    // What it does: Returns the next raw 64-bit random value
+    // Inputs: None
+    // Outputs: Random value (uint64_t)
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+    
+    // What it does: Returns a random integer in [0, bound)
+    // Inputs: bound - exclusive upper limit (must be > 0)
+    // Outputs: Random integer (int)
+    int nextInt(int bound) {
+        return (int)(((next() >> 32) * (uint64_t)bound) >> 32);
+    }
+    
+    // What it does: Returns one word of the internal xoshiro256** state (lets SIMD kernels run the same sequence)
+    // Inputs: index - state word (0-3)
+    // Outputs: State word (uint64_t)
+    uint64_t getState(int index) const {
+        return state[index];
+    }
+    
+    // What it does: Replaces one word of the internal state (snapshots restore a generator with it)
+    // Inputs: index - state word (0-3), value - word saved with getState
+    // Outputs: None
+    void setState(int index, uint64_t value) {
+        state[index] = value;
+    }
+    
+    // What it does: Returns a seed that differs between program runs (clock and address entropy)
+    // Inputs: None
+    // Outputs: Seed value (uint64_t)
+    static uint64_t randomSeed();
+    
+    // What it does: Derives an independent seed for a sub-stream (e.g. one simulated campaign)
+    // Inputs: seed - base seed, stream - sub-stream number
+    // Outputs: Seed value for that sub-stream (uint64_t)
+    static uint64_t deriveSeed(uint64_t seed, uint64_t stream);
+};
+
+#endif
@@ -1,18 +1,366 @@
 #include "save.h"
+#include "metrics.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <type_traits>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 using namespace std;
 
-SaveManager::SaveManager(const std::string& filename) : saveFileName(filename) {
+static_assert(std::is_trivially_copyable<SaveHeader>::value && sizeof(SaveHeader) == 16,
+              "SaveHeader must keep its on-disk layout");
+static_assert(std::is_trivially_copyable<SaveRecord>::value && sizeof(SaveRecord) == 48,
+              "SaveRecord must keep its on-disk layout (bump SAVE_FORMAT_VERSION when changing it)");
+
+namespace {
+    const char SAVE_MAGIC[4] = {'F', 'T', 'M', 'S'};
+    const char JOURNAL_MAGIC[4] = {'F', 'T', 'M', 'J'};
+    
+    // One save file or journal checkpoint as laid out on disk
+    struct SaveEntry {
+        SaveHeader header;
+        SaveRecord record;
+    };
+    
+    // Lookup table of the reflected CRC-32 polynomial, built once on first use
+    struct CrcTable {
+        uint32_t values[256];
+        
+        CrcTable() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; bit++) {
+                    value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+                }
+                values[i] = value;
+            }
+        }
+    };
+    
+    // What it does: Fills an entry header for a record
+    // Inputs: entry - entry whose record is already filled, magic - file kind (SAVE_MAGIC or JOURNAL_MAGIC)
+    // Outputs: None
+    void sealEntry(SaveEntry& entry, const char* magic) {
+        memcpy(entry.header.magic, magic, sizeof(entry.header.magic));
+        entry.header.version = SAVE_FORMAT_VERSION;
+        entry.header.headerSize = sizeof(SaveHeader);
+        entry.header.payloadSize = sizeof(SaveRecord);
+        entry.header.crc = SaveManager::crc32(&entry.record, sizeof(entry.record));
+    }
+    
+    // What it does: Checks an entry inside a mapped file and copies its record out
+    // Inputs: bytes - start of the entry, available - bytes left in the file, magic - expected file kind, record - record to fill
+    // Outputs: Returns true if the entry is complete, of this version and its CRC matches, false otherwise
+    bool readEntry(const char* bytes, size_t available, const char* magic, SaveRecord& record) {
+        SaveHeader header;
+        if (available < sizeof(header)) return false;
+        memcpy(&header, bytes, sizeof(header));
+        if (memcmp(header.magic, magic, sizeof(header.magic)) != 0 || header.version != SAVE_FORMAT_VERSION ||
+            header.headerSize != sizeof(SaveHeader) || header.payloadSize != sizeof(SaveRecord) ||
+            available - sizeof(header) < header.payloadSize) {
+            return false;
+        }
+        memcpy(&record, bytes + header.headerSize, sizeof(record));
+        return SaveManager::crc32(&record, sizeof(record)) == header.crc;
+    }
+    
+    // What it does: Writes a whole buffer to a file descriptor, retrying short writes
+    // Inputs: fd - open file descriptor, data - bytes to write, size - number of bytes
+    // Outputs: Returns true if every byte was written, false on error
+    bool writeAll(int fd, const void* data, size_t size) {
+        const char* bytes = (const char*)data;
+        while (size > 0) {
+            ssize_t written = write(fd, bytes, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            bytes += written;
+            size -= written;
+        }
+        return true;
+    }
+    
+    // What it does: Flushes the directory holding a file so a rename in it survives a crash
+    // Inputs: fileName - path of a file in the directory
+    // Outputs: None
+    void syncDirectory(const string& fileName) {
+        size_t slash = fileName.find_last_of('/');
+        string directory = slash == string::npos ? "." : (slash == 0 ? "/" : fileName.substr(0, slash));
+        int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+    }
+    
+    // What it does: Replaces a file atomically: writes "<file>.tmp", fsyncs it and renames it over the file
+    // Inputs: fileName - file to replace, data - new contents, size - number of bytes, durable - false to skip the fsyncs
+    // Outputs: Returns true if the new contents are on disk, false otherwise (the old file is left untouched)
+    bool replaceFile(const string& fileName, const void* data, size_t size, bool durable) {
+        string tempName = fileName + ".tmp";
+        int fd = open(tempName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        
+        bool ok = writeAll(fd, data, size) && (!durable || fsync(fd) == 0);
+        ok = close(fd) == 0 && ok;
+        if (!ok || rename(tempName.c_str(), fileName.c_str()) != 0) {
+            unlink(tempName.c_str());
+            return false;
+        }
+        if (durable) {
+            syncDirectory(fileName);
+        }
+        return true;
+    }
+    
+    // What it does: Memory-maps a whole file for reading
+    // Inputs: fileName - file to map, size - reference to store the file size
+    // Outputs: Start of the mapping, or nullptr if the file is missing, empty or cannot be mapped
+    const char* mapFile(const string& fileName, size_t& size) {
+        int fd = open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+        
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            close(fd);
+            return nullptr;
+        }
+        size = (size_t)info.st_size;
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        return mapping == MAP_FAILED ? nullptr : (const char*)mapping;
+    }
+}
+
+SaveManager::SaveManager(const std::string& filename)
+    : saveFileName(filename), journalFileName(filename + ".journal"), durable(true) {
 }
 
 SaveManager::~SaveManager() {
 }
 
+uint32_t SaveManager::crc32(const void* data, size_t size) {
+    static const CrcTable table;
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.values[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void SaveManager::captureState(Player* player, PotionManager* potionManager, int currentLevel, int difficulty,
+                               SaveState& state) {
+    player->saveSnapshot(state.player);
+    potionManager->saveSnapshot(state.potions);
+    state.level = currentLevel;
+    state.difficulty = difficulty;
+}
+
+void SaveManager::buildRecord(const SaveState& state, SaveRecord& record) {
+    memset(&record, 0, sizeof(record));
+    record.level = state.level;
+    record.difficulty = state.difficulty;
+    record.baseMaxHealth = state.player.baseMaxHealth;
+    record.currentHealth = state.player.currentHealth;
+    record.baseAttack = state.player.baseAttack;
+    record.gold = state.player.gold;
+    record.bossAttackBonus = state.player.bossAttackBonus;
+    
+    record.equipmentCount = state.player.equipmentCount;
+    for (int i = 0; i < state.player.equipmentCount; i++) {
+        record.equipment[i] = (uint8_t)state.player.equipment[i];
+    }
+    
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        record.potionCounts[i] = state.potions.counts[i];
+    }
+}
+
+bool SaveManager::applyRecord(const SaveRecord& record, Player* player, PotionManager* potionManager,
+                              int& currentLevel, int& difficulty) {
+    if (record.level < 1 || (record.difficulty != 0 && record.difficulty != 1) ||
+        record.equipmentCount > MAX_EQUIPMENT) {
+        return false;
+    }
+    for (int i = 0; i < record.equipmentCount; i++) {
+        if (record.equipment[i] >= EQUIPMENT_TYPE_COUNT) return false;
+    }
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        if (record.potionCounts[i] < 0) return false;
+    }
+    
+    currentLevel = record.level;
+    difficulty = record.difficulty;
+    player->setBaseMaxHealth(record.baseMaxHealth);
+    player->setCurrentHealth(record.currentHealth);
+    player->setBaseAttack(record.baseAttack);
+    player->setGold(record.gold);
+    player->setBossAttackBonus(record.bossAttackBonus);
+    
+    player->clearEquipment();
+    for (int i = 0; i < record.equipmentCount; i++) {
+        player->addEquipment((EquipmentType)record.equipment[i]);
+    }
+    
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        if (record.potionCounts[i] > 0) {
+            potionManager->addPotion((PotionType)i, record.potionCounts[i]);
+        }
+    }
+    return true;
+}
+
 bool SaveManager::saveGame(Player* player, PotionManager* potionManager, int currentLevel, int difficulty) {
-    ofstream file(saveFileName);
+    SaveState state;
+    captureState(player, potionManager, currentLevel, difficulty, state);
+    return saveState(state);
+}
+
+bool SaveManager::saveState(const SaveState& state) {
+    METRIC_TIME(MetricPhase::Save);
+    SaveEntry entry;
+    buildRecord(state, entry.record);
+    sealEntry(entry, SAVE_MAGIC);
+    
+    if (!replaceFile(saveFileName, &entry, sizeof(entry), durable)) {
+        cerr << "Error: Cannot write save file." << endl;
+        return false;
+    }
+    return true;
+}
+
+bool SaveManager::loadGame(Player* player, PotionManager* potionManager, int& currentLevel, int& difficulty) {
+    METRIC_TIME(MetricPhase::Load);
+    size_t fileSize = 0;
+    const char* bytes = mapFile(saveFileName, fileSize);
+    if (!bytes) {
+        vector<SaveRecord> records;
+        if (!readJournal(records) || records.empty()) {
+            return false;
+        }
+        return applyRecord(records.back(), player, potionManager, currentLevel, difficulty);
+    }
+    
+    if (fileSize < sizeof(SAVE_MAGIC) || memcmp(bytes, SAVE_MAGIC, sizeof(SAVE_MAGIC)) != 0) {
+        munmap((void*)bytes, fileSize);
+        return importText(player, potionManager, currentLevel, difficulty, saveFileName);
+    }
+    
+    SaveRecord record;
+    bool valid = readEntry(bytes, fileSize, SAVE_MAGIC, record);
+    munmap((void*)bytes, fileSize);
+    
+    if (!valid) {
+        cerr << "Error: Save file is damaged or from an unsupported version." << endl;
+        return false;
+    }
+    return applyRecord(record, player, potionManager, currentLevel, difficulty);
+}
+
+bool SaveManager::appendCheckpoint(Player* player, PotionManager* potionManager, int currentLevel, int difficulty) {
+    SaveState state;
+    captureState(player, potionManager, currentLevel, difficulty, state);
+    return appendCheckpoints(&state, 1);
+}
+
+bool SaveManager::appendCheckpoints(const SaveState* states, int count) {
+    METRIC_TIME(MetricPhase::Save);
+    vector<SaveEntry> entries(count);
+    for (int i = 0; i < count; i++) {
+        buildRecord(states[i], entries[i].record);
+        sealEntry(entries[i], JOURNAL_MAGIC);
+    }
+    
+    int fd = open(journalFileName.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        cerr << "Error: Cannot open checkpoint journal." << endl;
+        return false;
+    }
+    
+    // Drop the torn tail of a checkpoint interrupted by a crash so new entries stay aligned
+    struct stat info;
+    bool ok = fstat(fd, &info) == 0;
+    if (ok && info.st_size % sizeof(SaveEntry) != 0) {
+        ok = ftruncate(fd, info.st_size - info.st_size % sizeof(SaveEntry)) == 0;
+    }
+    ok = ok && writeAll(fd, entries.data(), sizeof(SaveEntry) * count) && (!durable || fdatasync(fd) == 0);
+    ok = close(fd) == 0 && ok;
+    if (ok && durable && info.st_size == 0) {
+        syncDirectory(journalFileName);
+    }
+    return ok;
+}
+
+bool SaveManager::replaceCheckpoints(const SaveState* states, int count) {
+    METRIC_TIME(MetricPhase::Save);
+    vector<SaveEntry> entries(count);
+    for (int i = 0; i < count; i++) {
+        buildRecord(states[i], entries[i].record);
+        sealEntry(entries[i], JOURNAL_MAGIC);
+    }
+    
+    if (!replaceFile(journalFileName, entries.data(), sizeof(SaveEntry) * count, durable)) {
+        cerr << "Error: Cannot write checkpoint journal." << endl;
+        return false;
+    }
+    return true;
+}
+
+bool SaveManager::readJournal(vector<SaveRecord>& records) const {
+    size_t fileSize = 0;
+    const char* bytes = mapFile(journalFileName, fileSize);
+    if (!bytes) {
+        return false;
+    }
+    
+    records.reserve(fileSize / sizeof(SaveEntry));
+    SaveRecord record;
+    for (size_t offset = 0; offset + sizeof(SaveEntry) <= fileSize; offset += sizeof(SaveEntry)) {
+        if (!readEntry(bytes + offset, fileSize - offset, JOURNAL_MAGIC, record)) break;
+        records.push_back(record);
+    }
+    munmap((void*)bytes, fileSize);
+    return true;
+}
+
+vector<int> SaveManager::getCheckpointLevels() const {
+    vector<SaveRecord> records;
+    vector<int> levels;
+    readJournal(records);
+    for (const auto& record : records) {
+        levels.push_back(record.level);
+    }
+    sort(levels.begin(), levels.end());
+    levels.erase(unique(levels.begin(), levels.end()), levels.end());
+    return levels;
+}
+
+bool SaveManager::loadCheckpoint(int level, Player* player, PotionManager* potionManager,
+                                 int& currentLevel, int& difficulty) {
+    METRIC_TIME(MetricPhase::Load);
+    vector<SaveRecord> records;
+    readJournal(records);
+    for (auto it = records.rbegin(); it != records.rend(); ++it) {
+        if (it->level == level) {
+            return applyRecord(*it, player, potionManager, currentLevel, difficulty);
+        }
+    }
+    return false;
+}
+
+bool SaveManager::exportText(Player* player, PotionManager* potionManager, int currentLevel, int difficulty,
+                             const string& textFileName) const {
+    ofstream file(textFileName);
     if (!file.is_open()) {
         cerr << "Error: Cannot open save file for writing." << endl;
         return false;
@@ -32,18 +380,19 @@ bool SaveManager::saveGame(Player* player, PotionManager* potionManager, int cur
         file << "EQUIPMENT " << equip << endl;
     }
     
-    auto potions = potionManager->getAllPotions();
+    PotionView potions = potionManager->getAllPotions();
     file << "POTION_COUNT " << potions.size() << endl;
-    for (const auto& pair : potions) {
-        file << "POTION " << pair.first << " " << pair.second << endl;
+    for (PotionStack stack : potions) {
+        file << "POTION " << stack.name << " " << stack.quantity << endl;
     }
     
     file.close();
     return true;
 }
 
-bool SaveManager::loadGame(Player* player, PotionManager* potionManager, int& currentLevel, int& difficulty) {
-    ifstream file(saveFileName);
+bool SaveManager::importText(Player* player, PotionManager* potionManager, int& currentLevel, int& difficulty,
+                             const string& textFileName) const {
+    ifstream file(textFileName);
     if (!file.is_open()) {
         return false;
     }
@@ -98,9 +447,9 @@ bool SaveManager::loadGame(Player* player, PotionManager* potionManager, int& cu
             string restOfLine;
             getline(iss, restOfLine);
             size_t lastSpace = restOfLine.find_last_of(' ');
-            if (lastSpace != string::npos) {
+            if (lastSpace != string::npos && lastSpace > 0) {
                 potionName = restOfLine.substr(1, lastSpace - 1);
-                quantity = stoi(restOfLine.substr(lastSpace + 1));
+                quantity = atoi(restOfLine.c_str() + lastSpace + 1);
             } else {
                 continue;
             }
@@ -113,13 +462,46 @@ bool SaveManager::loadGame(Player* player, PotionManager* potionManager, int& cu
     return true;
 }
 
+bool SaveManager::importLegacySave(const string& textFileName) {
+    struct stat info;
+    if (saveExists() || stat(textFileName.c_str(), &info) != 0) {
+        return false;
+    }
+    
+    Player player;
+    PotionManager potionManager;
+    int currentLevel = 1;
+    int difficulty = 0;
+    if (!importText(&player, &potionManager, currentLevel, difficulty, textFileName)) {
+        cerr << "Error: Cannot read old save file " << textFileName << "." << endl;
+        return false;
+    }
+    return saveGame(&player, &potionManager, currentLevel, difficulty);
+}
+
 bool SaveManager::saveExists() const {
-    ifstream file(saveFileName);
-    bool exists = file.good();
-    file.close();
-    return exists;
+    struct stat info;
+    return stat(saveFileName.c_str(), &info) == 0 || stat(journalFileName.c_str(), &info) == 0;
 }
 
 bool SaveManager::deleteSave() {
-    return remove(saveFileName.c_str()) == 0;
+    bool removedSave = remove(saveFileName.c_str()) == 0;
+    bool removedJournal = remove(journalFileName.c_str()) == 0;
+    return removedSave || removedJournal;
+}
+
+void SaveManager::setDurable(bool durable) {
+    this->durable = durable;
+}
+
+const string& SaveManager::getFileName() const {
+    return saveFileName;
+}
+
+const string& SaveManager::getJournalFileName() const {
+    return journalFileName;
+}
+
+string SaveManager::getSlotFileName(int slot) {
+    return slot <= 1 ? "savegame.dat" : "savegame" + to_string(slot) + ".dat";
 }
@@ -5,41 +5,182 @@
 #include "potion.h"
 #include <string>
 #include <vector>
+#include <cstdint>
 
+// Version of the binary save layout written by saveGame (bump when SaveRecord changes)
+const int SAVE_FORMAT_VERSION = 1;
+
+// Number of save slots offered by the game
+const int SAVE_SLOT_COUNT = 3;
+
+// Text save file written by versions of the game before the binary format (imported into slot 1)
+const char* const LEGACY_SAVE_FILE_NAME = "savegame.txt";
+
+// Fixed-size header at the start of every binary save file and of every checkpoint in a journal
+struct SaveHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t payloadSize;
+    uint32_t crc;
+};
+
+// Game state stored right after the header (fixed-width fields, little-endian, no pointers,
+// so a save is loaded with a single memcpy)
+struct SaveRecord {
+    int32_t level;
+    int32_t difficulty;
+    int32_t baseMaxHealth;
+    int32_t currentHealth;
+    int32_t baseAttack;
+    int32_t gold;
+    int32_t bossAttackBonus;
+    uint8_t equipmentCount;
+    uint8_t equipment[MAX_EQUIPMENT];
+    int32_t potionCounts[POTION_TYPE_COUNT];
+};
+
+// Game state of a save as plain values: copied out of the game in O(size) by captureState and turned
+// into a SaveRecord only when it is written (so the autosave writer thread does the serialization)
+struct SaveState {
+    PlayerSnapshot player;
+    PotionSnapshot potions;
+    int32_t level;
+    int32_t difficulty;
+};
+
+// Saves of one slot: a snapshot file replaced atomically (temp file, fsync, rename) and an
+// append-only journal next to it ("<file>.journal") holding one checkpoint per completed level
 class SaveManager {
 private:
     std::string saveFileName;
+    std::string journalFileName;
+    bool durable;
+    
+    // What it does: Fills a save record from a captured game state
+    // Inputs: state - game state to save, record - record to fill
+    // Outputs: None
+    static void buildRecord(const SaveState& state, SaveRecord& record);
+    
+    // What it does: Checks a save record and restores the game state from it
+    // Inputs: record - loaded record, player - pointer to player object (will be modified), potionManager - pointer to potion manager (will be modified), currentLevel - reference to store level number, difficulty - reference to store difficulty mode
+    // Outputs: Returns true if the record holds valid values, false otherwise (nothing is modified then)
+    static bool applyRecord(const SaveRecord& record, Player* player, PotionManager* potionManager, int& currentLevel, int& difficulty);
+    
+    // What it does: Reads every intact checkpoint of the journal (stops at a torn or damaged entry)
+    // Inputs: records - vector to fill with checkpoints, oldest first
+    // Outputs: Returns true if the journal could be read, false if it does not exist
+    bool readJournal(std::vector<SaveRecord>& records) const;
     
 public:
     // What it does: Initializes save manager with filename
-    // Inputs: filename - name of save file (default: "savegame.txt")
+    // Inputs: filename - name of binary save file (default: "savegame.dat", the file of slot 1)
     // Outputs: None
-    SaveManager(const std::string& filename = "savegame.txt");
+    SaveManager(const std::string& filename = "savegame.dat");
     
     // What it does: Cleans up save manager resources
     // Inputs: None
     // Outputs: None
     ~SaveManager();
     
-    // What it does: Saves game state to file including player stats, equipment, potions, level, and difficulty
+    // What it does: Saves game state to the binary save file (header with version and CRC-32, then a SaveRecord).
+    // The file is written to "<file>.tmp", flushed to disk and renamed over the old save, so a crash leaves either the old or the new save.
     // Inputs: player - pointer to player object, potionManager - pointer to potion manager, currentLevel - current level number, difficulty - difficulty mode (0=easy, 1=hard)
     // Outputs: Returns true if save was successful, false otherwise
     bool saveGame(Player* player, PotionManager* potionManager, int currentLevel, int difficulty);
     
-    // What it does: Loads game state from file and restores player stats, equipment, potions, level, and difficulty
+    // What it does: Saves a captured game state to the binary save file, like saveGame
+    // Inputs: state - game state taken with captureState
+    // Outputs: Returns true if save was successful, false otherwise
+    bool saveState(const SaveState& state);
+    
+    // What it does: Loads game state by memory-mapping the save file and copying the checked record out of it
+    // (files in the old text format are read with importText instead; without a save file the newest checkpoint is used)
     // Inputs: player - pointer to player object (will be modified), potionManager - pointer to potion manager (will be modified), currentLevel - reference to store loaded level number, difficulty - reference to store loaded difficulty mode
-    // Outputs: Returns true if load was successful, false otherwise
+    // Outputs: Returns true if load was successful, false if the file is missing, truncated, corrupted or from a newer version
     bool loadGame(Player* player, PotionManager* potionManager, int& currentLevel, int& difficulty);
     
-    // What it does: Checks if save file exists
+    // What it does: Appends a checkpoint to the journal (one small write and fsync instead of rewriting the save)
+    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, currentLevel - level the checkpoint resumes at, difficulty - difficulty mode
+    // Outputs: Returns true if the checkpoint is on disk, false otherwise
+    bool appendCheckpoint(Player* player, PotionManager* potionManager, int currentLevel, int difficulty);
+    
+    // What it does: Appends captured game states to the journal as checkpoints, with one write and one fsync for all of them
+    // Inputs: states - game states taken with captureState, oldest first, count - number of states
+    // Outputs: Returns true if the checkpoints are on disk, false otherwise
+    bool appendCheckpoints(const SaveState* states, int count);
+    
+    // What it does: Replaces the journal with a new one holding only the given checkpoints (written to a temporary
+    // file and renamed, so the old journal stays intact until the new one is complete)
+    // Inputs: states - game states taken with captureState, oldest first, count - number of states (0 for an empty journal)
+    // Outputs: Returns true if the new journal is on disk, false otherwise
+    bool replaceCheckpoints(const SaveState* states, int count);
+    
+    // What it does: Returns the levels a run can be resumed at from the journal
     // Inputs: None
-    // Outputs: Returns true if save file exists, false otherwise
+    // Outputs: Sorted vector of distinct checkpoint levels (empty if there is no journal)
+    std::vector<int> getCheckpointLevels() const;
+    
+    // What it does: Restores the newest checkpoint of a level from the journal
+    // Inputs: level - level to resume at, player - pointer to player object (will be modified), potionManager - pointer to potion manager (will be modified), currentLevel - reference to store loaded level number, difficulty - reference to store loaded difficulty mode
+    // Outputs: Returns true if a checkpoint of that level was loaded, false otherwise
+    bool loadCheckpoint(int level, Player* player, PotionManager* potionManager, int& currentLevel, int& difficulty);
+    
+    // What it does: Writes game state as a readable text file (LEVEL, PLAYER_GOLD, POTION lines, ...)
+    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, currentLevel - current level number, difficulty - difficulty mode, textFileName - file to write
+    // Outputs: Returns true if export was successful, false otherwise
+    bool exportText(Player* player, PotionManager* potionManager, int currentLevel, int difficulty, const std::string& textFileName) const;
+    
+    // What it does: Reads game state from a text file written by exportText (or by older versions of the game)
+    // Inputs: player - pointer to player object (will be modified), potionManager - pointer to potion manager (will be modified), currentLevel - reference to store loaded level number, difficulty - reference to store loaded difficulty mode, textFileName - file to read
+    // Outputs: Returns true if import was successful, false otherwise
+    bool importText(Player* player, PotionManager* potionManager, int& currentLevel, int& difficulty, const std::string& textFileName) const;
+    
+    // What it does: Converts a text save of an older version into the binary save file, unless this save file or its journal already exists
+    // (the text file is left in place)
+    // Inputs: textFileName - text save to import
+    // Outputs: Returns true if the text save was imported, false if there was nothing to import or it could not be converted
+    bool importLegacySave(const std::string& textFileName);
+    
+    // What it does: Checks if save file or checkpoint journal exists
+    // Inputs: None
+    // Outputs: Returns true if there is something to load, false otherwise
     bool saveExists() const;
     
-    // What it does: Deletes save file
+    // What it does: Deletes save file and checkpoint journal
     // Inputs: None
     // Outputs: Returns true if deletion was successful, false otherwise
     bool deleteSave();
+    
+    // What it does: Turns the fsyncs of saves and checkpoints on or off (off for scratch saves that need not survive a crash)
+    // Inputs: durable - true to flush every save to disk (default), false to only write it
+    // Outputs: None
+    void setDurable(bool durable);
+    
+    // What it does: Returns name of the binary save file
+    // Inputs: None
+    // Outputs: File name (string)
+    const std::string& getFileName() const;
+    
+    // What it does: Returns name of the checkpoint journal
+    // Inputs: None
+    // Outputs: File name ("<save file>.journal")
+    const std::string& getJournalFileName() const;
+    
+    // What it does: Copies the game state a save holds into plain values (no serialization or I/O)
+    // Inputs: player - pointer to player object, potionManager - pointer to potion manager, currentLevel - level the save resumes at, difficulty - difficulty mode, state - state to fill
+    // Outputs: None
+    static void captureState(Player* player, PotionManager* potionManager, int currentLevel, int difficulty, SaveState& state);
+    
+    // What it does: Returns the save file name of a slot
+    // Inputs: slot - slot number (1 to SAVE_SLOT_COUNT)
+    // Outputs: File name ("savegame.dat" for slot 1, "savegame<slot>.dat" for the others)
+    static std::string getSlotFileName(int slot);
+    
+    // What it does: Computes the CRC-32 (IEEE 802.3) checksum used by save files
+    // Inputs: data - bytes to check, size - number of bytes
+    // Outputs: Checksum (uint32_t)
+    static uint32_t crc32(const void* data, size_t size);
 };
 
 #endif
@@ -0,0 +1,167 @@
+#include "script.h"
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+namespace {
+    // What it does: Checks if a character separates tokens (the characters isspace accepts in the C locale)
+    // Inputs: ch - character to check
+    // Outputs: Returns true for blanks and line breaks
+    inline bool isBlank(char ch) {
+        return ch == ' ' || (ch >= '\t' && ch <= '\r');
+    }
+}
+
+CommandScript::CommandScript()
+    : data(nullptr), size(0), position(0), mapped(false), errorOffset(NO_ERROR) {
+}
+
+CommandScript::CommandScript(const char* text, size_t length)
+    : data(text), size(length), position(0), mapped(false), errorOffset(NO_ERROR) {
+}
+
+CommandScript::~CommandScript() {
+    if (mapped) {
+        munmap((void*)data, size);
+    }
+}
+
+bool CommandScript::open(const std::string& fileName, std::string& error) {
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + fileName;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        error = "cannot read " + fileName;
+        return false;
+    }
+    
+    const char* text = nullptr;
+    if (info.st_size > 0) {
+        void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            close(fd);
+            error = "cannot map " + fileName;
+            return false;
+        }
+        madvise(mapping, (size_t)info.st_size, MADV_SEQUENTIAL);
+        text = (const char*)mapping;
+    }
+    close(fd);
+    
+    if (mapped) {
+        munmap((void*)data, size);
+    }
+    data = text;
+    size = (size_t)info.st_size;
+    mapped = text != nullptr;
+    position = 0;
+    errorOffset = NO_ERROR;
+    errorToken.clear();
+    return true;
+}
+
+void CommandScript::skipBlanks() {
+    while (position < size && isBlank(data[position])) {
+        position++;
+    }
+}
+
+int CommandScript::readNumber(int& value) {
+    skipBlanks();
+    if (position >= size) {
+        return -1;
+    }
+    
+    size_t start = position;
+    size_t cursor = position;
+    bool negative = false;
+    if (data[cursor] == '-' || data[cursor] == '+') {
+        negative = data[cursor] == '-';
+        cursor++;
+    }
+    long long number = 0;
+    size_t digits = cursor;
+    while (cursor < size && data[cursor] >= '0' && data[cursor] <= '9') {
+        if (number <= INT_MAX) {
+            number = number * 10 + (data[cursor] - '0');
+        }
+        cursor++;
+    }
+    
+    if (negative) {
+        number = -number;
+    }
+    if (cursor == digits || number > INT_MAX || number < INT_MIN) {
+        if (errorOffset == NO_ERROR) {
+            size_t end = start;
+            while (end < size && !isBlank(data[end])) {
+                end++;
+            }
+            errorOffset = start;
+            errorToken.assign(data + start, end - start);
+        }
+        position = cursor;
+        // Like the stream, a number cut off by the end of the input ends the input
+        return cursor < size ? 0 : -1;
+    }
+    position = cursor;
+    value = (int)number;
+    return 1;
+}
+
+bool CommandScript::readLetter(char& value) {
+    skipBlanks();
+    if (position >= size) {
+        return false;
+    }
+    value = data[position++];
+    return true;
+}
+
+void CommandScript::skipLine() {
+    while (position < size && data[position] != '\n') {
+        position++;
+    }
+    if (position < size) {
+        position++;
+    }
+}
+
+bool CommandScript::hasError() const {
+    return errorOffset != NO_ERROR;
+}
+
+size_t CommandScript::getErrorOffset() const {
+    return errorOffset;
+}
+
+std::string CommandScript::describeError() const {
+    if (errorOffset == NO_ERROR) {
+        return "";
+    }
+    size_t line = 1;
+    size_t lineStart = 0;
+    for (size_t i = 0; i < errorOffset; i++) {
+        if (data[i] == '\n') {
+            line++;
+            lineStart = i + 1;
+        }
+    }
+    return "offset " + to_string(errorOffset) + " (line " + to_string(line) + ", column " +
+           to_string(errorOffset - lineStart + 1) + "): expected a number, found \"" + errorToken + "\"";
+}
+
+size_t CommandScript::getPosition() const {
+    return position;
+}
+
+size_t CommandScript::getSize() const {
+    return size;
+}
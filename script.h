@@ -0,0 +1,96 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <cstddef>
+#include <string>
+
+// Command script for batch mode: the whole file is memory-mapped and choices are parsed straight out
+// of the mapping, without copies, streams or locale handling. Tokens are read the way "cin >> choice"
+// reads them (a number is an optional sign followed by digits, a letter is one non-blank character),
+// and an invalid number stops where the stream would stop, so after the caller skips the rest of the
+// line (as the console's error recovery does) a script plays exactly like the same text typed on
+// stdin. The first invalid number is remembered with its offset for error reports.
+class CommandScript {
+private:
+    const char* data;
+    size_t size;
+    size_t position;
+    bool mapped;
+    size_t errorOffset;
+    std::string errorToken;
+    
+    // What it does: Skips blanks and line breaks
+    // Inputs: None
+    // Outputs: None
+    void skipBlanks();
+    
+public:
+    // Offset reported by getErrorOffset when the script has no error
+    static const size_t NO_ERROR = (size_t)-1;
+    
+    // What it does: Creates an empty script (open loads a file into it)
+    // Inputs: None
+    // Outputs: None
+    CommandScript();
+    
+    // What it does: Creates a script over text owned by the caller (it must outlive the script)
+    // Inputs: text - script text, length - size of the text in bytes
+    // Outputs: None
+    CommandScript(const char* text, size_t length);
+    
+    // What it does: Unmaps the script file
+    // Inputs: None
+    // Outputs: None
+    ~CommandScript();
+    
+    CommandScript(const CommandScript&) = delete;
+    CommandScript& operator=(const CommandScript&) = delete;
+    
+    // What it does: Memory-maps a script file and starts reading at its beginning
+    // Inputs: fileName - script to open, error - reference to store the reason if it cannot be opened
+    // Outputs: Returns true if the script was opened, false otherwise
+    bool open(const std::string& fileName, std::string& error);
+    
+    // What it does: Reads the next number
+    // Inputs: value - reference to store the number
+    // Outputs: Returns 1 if a number was read, 0 if the next token is not a number (the caller skips the rest of
+    //          its line with skipLine; the first such error is remembered), -1 at the end of the script
+    int readNumber(int& value);
+    
+    // What it does: Reads the next non-blank character
+    // Inputs: value - reference to store the character
+    // Outputs: Returns true if a character was read, false at the end of the script
+    bool readLetter(char& value);
+    
+    // What it does: Skips the rest of the current line
+    // Inputs: None
+    // Outputs: None
+    void skipLine();
+    
+    // What it does: Checks if the script contained an invalid number so far
+    // Inputs: None
+    // Outputs: Returns true if readNumber met a token that is not a number
+    bool hasError() const;
+    
+    // What it does: Returns the byte offset of the first invalid number
+    // Inputs: None
+    // Outputs: Offset from the start of the script (NO_ERROR if there was none)
+    size_t getErrorOffset() const;
+    
+    // What it does: Describes the first invalid number with its offset, line and column
+    // Inputs: None
+    // Outputs: Error message (empty if there was no error)
+    std::string describeError() const;
+    
+    // What it does: Returns number of bytes read so far
+    // Inputs: None
+    // Outputs: Byte offset of the next token
+    size_t getPosition() const;
+    
+    // What it does: Returns size of the script
+    // Inputs: None
+    // Outputs: Size in bytes
+    size_t getSize() const;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "gameserver.h"
+#include "rng.h"
+#include "metrics.h"
+#include "autosave.h"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <sys/stat.h>
+using namespace std;
+
+// What it does: Prints command line usage of the server
+// Inputs: program - name the program was started with
+// Outputs: None
+static void printUsage(const char* program) {
+    cout << "Usage: " << program << " (--unix PATH | --tcp PORT [--host ADDR]) [--save-dir DIR] [--seed S] [--max-sessions N] [--metrics FILE]" << endl;
+}
+
+// What it does: Entry point of the multi-session game server. Serves every player from one epoll loop.
+// Inputs: argc - argument count, argv - command line arguments
+// Outputs: Returns exit code (0 on success, 1 on bad arguments or socket errors)
+int main(int argc, char* argv[]) {
+    string unixPath;
+    string host = "127.0.0.1";
+    int port = 0;
+    string saveDir = "server-saves";
+    uint64_t seed = Random::randomSeed();
+    long long maxSessions = 0;
+    string metricsFile;
+    
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--unix") == 0 && hasValue) {
+            unixPath = argv[++i];
+        } else if (strcmp(argv[i], "--tcp") == 0 && hasValue) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--host") == 0 && hasValue) {
+            host = argv[++i];
+        } else if (strcmp(argv[i], "--save-dir") == 0 && hasValue) {
+            saveDir = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--max-sessions") == 0 && hasValue) {
+            maxSessions = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics") == 0 && hasValue) {
+            metricsFile = argv[++i];
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (unixPath.empty() == (port == 0)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    signal(SIGPIPE, SIG_IGN);
+    mkdir(saveDir.c_str(), 0755);
+    
+    GameServer server(seed, saveDir + "/");
+    bool listening = unixPath.empty() ? server.listenTcp(host, port) : server.listenUnix(unixPath);
+    if (!listening) {
+        return 1;
+    }
+    cout << "Serving on " << (unixPath.empty() ? host + ":" + to_string(port) : unixPath)
+         << ", seed " << seed << ", saves in " << saveDir << "/" << endl;
+    
+    server.run(maxSessions);
+    cout << "Server stopped after " << server.getFinishedSessions() << " session(s)." << endl;
+    AutosaveStallStats stalls = Autosave::getStallStats();
+    if (stalls.count > 0) {
+        cout << "Autosave stalls of the server loop: " << stalls.count << " hand-offs, " << stalls.waits << " waited, p99 "
+             << stalls.p99Nanoseconds / 1000 << " us, max " << stalls.maxNanoseconds / 1000 << " us" << endl;
+    }
+    if (!metricsFile.empty()) {
+        if (!metricsEnabled()) {
+            cout << "This build records no metrics; rebuild with 'make clean && make server METRICS=1'." << endl;
+        }
+        if (!writeMetricsFile(metricsFile)) {
+            cout << "Failed to write " << metricsFile << endl;
+            return 1;
+        }
+        cout << "Metrics written to " << metricsFile << endl;
+    }
+    return 0;
+}
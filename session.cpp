@@ -0,0 +1,279 @@
+#include "session.h"
+#include "game.h"
+#include <cerrno>
+#include <cctype>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/socket.h>
+using namespace std;
+
+namespace {
+    // What it does: Checks if a player name can be used in save file names
+    // Inputs: name - name the player typed
+    // Outputs: Returns true if it has 1 to MAX_NAME_LENGTH letters, digits, '-' or '_'
+    bool isValidName(const string& name) {
+        if (name.empty() || name.size() > GameSession::MAX_NAME_LENGTH) {
+            return false;
+        }
+        for (char ch : name) {
+            if (!isalnum((unsigned char)ch) && ch != '-' && ch != '_') {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+CoroutineSession::InputBuffer::InputBuffer(CoroutineSession* session) : session(session) {
+}
+
+CoroutineSession::InputBuffer::int_type CoroutineSession::InputBuffer::underflow() {
+    while (session->received.empty()) {
+        if (session->inputClosed) {
+            return traits_type::eof();
+        }
+        session->waitingForInput = true;
+        session->decisions++;
+        session->coroutine.suspend();
+        session->waitingForInput = false;
+    }
+    
+    current.swap(session->received);
+    session->received.clear();
+    setg(&current[0], &current[0], &current[0] + current.size());
+    return traits_type::to_int_type(current[0]);
+}
+
+CoroutineSession::CoroutineSession(uint64_t seed, const string& savePrefix, ostream& output, bool quiet)
+    : seed(seed), savePrefix(savePrefix), inputClosed(false), waitingForInput(false), quiet(quiet), durableSaves(true),
+      decisions(0), inputBuffer(this), input(&inputBuffer), output(&output), coroutine(&CoroutineSession::play, this, STACK_SIZE) {
+}
+
+CoroutineSession::~CoroutineSession() {
+}
+
+void CoroutineSession::play(void* session) {
+    CoroutineSession* self = (CoroutineSession*)session;
+    string prefix;
+    if (!self->openSaves(self->input, *self->output, prefix)) {
+        return;
+    }
+    {
+        Game game(self->input, *self->output, self->seed, self->quiet, prefix);
+        game.setDurableSaves(self->durableSaves);
+        game.run();
+    }
+    self->closeSaves(prefix);
+}
+
+bool CoroutineSession::openSaves(istream&, ostream&, string& prefix) {
+    prefix = savePrefix;
+    return true;
+}
+
+void CoroutineSession::closeSaves(const string&) {
+}
+
+bool CoroutineSession::start() {
+    return coroutine.start();
+}
+
+void CoroutineSession::setDurableSaves(bool durable) {
+    durableSaves = durable;
+}
+
+void CoroutineSession::supply(const char* text, size_t count) {
+    received.append(text, count);
+}
+
+void CoroutineSession::closeInput() {
+    inputClosed = true;
+}
+
+void CoroutineSession::wake() {
+    if (waitingForInput && (!received.empty() || inputClosed)) {
+        coroutine.resume();
+    }
+}
+
+void CoroutineSession::finish() {
+    closeInput();
+    wake();
+}
+
+bool CoroutineSession::isFinished() const {
+    return coroutine.isFinished();
+}
+
+bool CoroutineSession::isInputClosed() const {
+    return inputClosed;
+}
+
+bool CoroutineSession::isWaitingForInput() const {
+    return waitingForInput;
+}
+
+long long CoroutineSession::getDecisions() const {
+    return decisions;
+}
+
+GameSession::OutputBuffer::OutputBuffer(GameSession* session) : session(session) {
+}
+
+GameSession::OutputBuffer::int_type GameSession::OutputBuffer::overflow(int_type ch) {
+    if (!traits_type::eq_int_type(ch, traits_type::eof()) && !session->connectionLost) {
+        session->outgoing.push_back(traits_type::to_char_type(ch));
+    }
+    return traits_type::not_eof(ch);
+}
+
+streamsize GameSession::OutputBuffer::xsputn(const char* text, streamsize count) {
+    if (!session->connectionLost) {
+        session->outgoing.append(text, count);
+    }
+    return count;
+}
+
+int GameSession::OutputBuffer::sync() {
+    session->flush();
+    return 0;
+}
+
+GameSession::GameSession(int fd, int id, uint64_t seed, const string& savePrefix)
+    : CoroutineSession(seed, savePrefix, output, false), fd(fd), id(id), nameLockFd(-1), sentBytes(0), connectionLost(false),
+      outputBuffer(this), output(&outputBuffer) {
+}
+
+GameSession::~GameSession() {
+    finish();
+    if (nameLockFd >= 0) close(nameLockFd);
+    close(fd);
+}
+
+bool GameSession::openSaves(istream& input, ostream& output, string& prefix) {
+    output << "Player name (letters, digits, - and _; empty to play as a guest): " << std::flush;
+    string name;
+    while (getline(input, name)) {
+        if (!name.empty() && name.back() == '\r') {
+            name.pop_back();
+        }
+        if (name.empty()) {
+            CoroutineSession::openSaves(input, output, prefix);
+            prefix += "guest_" + to_string(id) + "_";
+            return true;
+        }
+        if (!isValidName(name)) {
+            output << "Invalid name. Player name: " << std::flush;
+            continue;
+        }
+        
+        // The lock file stays locked while the player is connected, so two connections never share save files
+        CoroutineSession::openSaves(input, output, prefix);
+        prefix += "player_" + name + "_";
+        int lockFd = open((prefix + "lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (lockFd >= 0 && flock(lockFd, LOCK_EX | LOCK_NB) == 0) {
+            nameLockFd = lockFd;
+            output << "Welcome, " << name << "!\n";
+            return true;
+        }
+        if (lockFd >= 0) close(lockFd);
+        output << name << " is already playing. Player name: " << std::flush;
+    }
+    return false;
+}
+
+void GameSession::closeSaves(const string& prefix) {
+    if (nameLockFd >= 0) {
+        close(nameLockFd);
+        nameLockFd = -1;
+        return;
+    }
+    for (int slot = 1; slot <= SAVE_SLOT_COUNT; slot++) {
+        SaveManager slotSave(prefix + SaveManager::getSlotFileName(slot));
+        slotSave.deleteSave();
+    }
+}
+
+void GameSession::receive() {
+    char chunk[4096];
+    while (!isInputClosed()) {
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if (count > 0) {
+            supply(chunk, count);
+        } else if (count == 0) {
+            closeInput();
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                closeInput();
+                connectionLost = true;
+            }
+            break;
+        }
+    }
+    wake();
+}
+
+bool GameSession::flush() {
+    while (sentBytes < outgoing.size() && !connectionLost) {
+        ssize_t count = send(fd, outgoing.data() + sentBytes, outgoing.size() - sentBytes, MSG_NOSIGNAL);
+        if (count > 0) {
+            sentBytes += count;
+        } else if (count < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK) connectionLost = true;
+            break;
+        }
+    }
+    
+    if (sentBytes == outgoing.size() || connectionLost) {
+        outgoing.clear();
+        sentBytes = 0;
+    } else if (outgoing.size() - sentBytes > MAX_PENDING_OUTPUT) {
+        closeInput();
+        connectionLost = true;
+        outgoing.clear();
+        sentBytes = 0;
+    } else {
+        outgoing.erase(0, sentBytes);
+        sentBytes = 0;
+    }
+    return outgoing.empty();
+}
+
+bool GameSession::isConnectionLost() const {
+    return connectionLost;
+}
+
+bool GameSession::hasPendingOutput() const {
+    return !outgoing.empty();
+}
+
+int GameSession::getFd() const {
+    return fd;
+}
+
+int GameSession::getId() const {
+    return id;
+}
+
+LocalSession::LocalSession(uint64_t seed, const string& savePrefix)
+    : CoroutineSession(seed, savePrefix, output, true), output(nullptr) {
+}
+
+LocalSession::~LocalSession() {
+    finish();
+}
+
+void LocalSession::send(const string& text) {
+    supply(text.data(), text.size());
+    wake();
+}
+
+void LocalSession::hangUp() {
+    closeInput();
+    wake();
+}
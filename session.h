@@ -0,0 +1,266 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "coroutine.h"
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <cstdint>
+
+// A Game running as a coroutine. The game reads its input through a stream that suspends the
+// coroutine at every choice whose input has not arrived yet (menus, battle action, target and potion,
+// shop), so Battle::execute and the campaign loop keep their plain blocking code while the owner
+// drives any number of sessions from one thread, handing each one input whenever it has some.
+class CoroutineSession {
+private:
+    // Input side of the session: hands the game the bytes received so far, suspends it when there are none
+    class InputBuffer : public std::streambuf {
+    private:
+        CoroutineSession* session;
+        std::string current;
+    
+    protected:
+        // What it does: Makes the next received bytes readable, suspending the game until data arrives
+        // Inputs: None
+        // Outputs: Next character, or EOF once the input is closed (the game then ends its session)
+        int_type underflow() override;
+    
+    public:
+        // What it does: Creates the input buffer of a session
+        // Inputs: session - owning session
+        // Outputs: None
+        explicit InputBuffer(CoroutineSession* session);
+    };
+    
+    uint64_t seed;
+    std::string savePrefix;
+    std::string received;
+    bool inputClosed;
+    bool waitingForInput;
+    bool quiet;
+    bool durableSaves;
+    long long decisions;
+    InputBuffer inputBuffer;
+    std::istream input;
+    std::ostream* output;
+    Coroutine coroutine;
+    
+    // What it does: Runs the session's game from start to end (body of the session coroutine)
+    // Inputs: session - session to play
+    // Outputs: None
+    static void play(void* session);
+    
+protected:
+    // What it does: Picks the save files of the game before it starts (runs on the session coroutine, so it may read input)
+    // Inputs: input - session input, output - session output, prefix - reference to store the prefix of the game's save file names
+    // Outputs: Returns true to start the game, false to end the session (e.g. the input closed)
+    virtual bool openSaves(std::istream& input, std::ostream& output, std::string& prefix);
+    
+    // What it does: Lets go of the save files after the game has ended (runs on the session coroutine)
+    // Inputs: prefix - prefix the game's save files were given by openSaves
+    // Outputs: None
+    virtual void closeSaves(const std::string& prefix);
+    
+
+    // What it does: Creates a session whose game has not started yet
+    // Inputs: seed - seed of the session's game, savePrefix - prefix of the session's save files,
+    //         output - stream the game writes to (owned by the derived session), quiet - true to skip all game output
+    // Outputs: None
+    CoroutineSession(uint64_t seed, const std::string& savePrefix, std::ostream& output, bool quiet);
+    
+    // What it does: Queues input for the game (it reads it once it is resumed)
+    // Inputs: text - received bytes, count - number of bytes
+    // Outputs: None
+    void supply(const char* text, size_t count);
+    
+    // What it does: Marks the end of the input (the game ends once it has read what was queued)
+    // Inputs: None
+    // Outputs: None
+    void closeInput();
+    
+    // What it does: Lets the game continue if it is waiting and input (or the end of input) is available
+    // Inputs: None
+    // Outputs: None
+    void wake();
+    
+    // What it does: Closes the input and lets a game that is still running unwind (derived sessions call it
+    // in their destructor, while the output stream the game writes to still exists)
+    // Inputs: None
+    // Outputs: None
+    void finish();
+    
+public:
+    // Size of the stack every session's game runs on
+    static const size_t STACK_SIZE = 256 * 1024;
+    
+    // What it does: Frees the session stack
+    // Inputs: None
+    // Outputs: None
+    virtual ~CoroutineSession();
+    
+    CoroutineSession(const CoroutineSession&) = delete;
+    CoroutineSession& operator=(const CoroutineSession&) = delete;
+    
+    // What it does: Starts the game, running it until it first waits for input
+    // Inputs: None
+    // Outputs: Returns false if the session stack could not be allocated
+    bool start();
+    
+    // What it does: Turns the fsyncs of the session's saves on or off (call it before start)
+    // Inputs: durable - true to flush every save to disk (default), false to only write it
+    // Outputs: None
+    void setDurableSaves(bool durable);
+    
+    // What it does: Checks if the session's game has ended
+    // Inputs: None
+    // Outputs: Returns true if the game has returned
+    bool isFinished() const;
+    
+    // What it does: Checks if the end of the input has been reached (or the session was told to stop reading)
+    // Inputs: None
+    // Outputs: Returns true if no more input will be accepted
+    bool isInputClosed() const;
+    
+    // What it does: Checks if the game is suspended at a choice it has no input for
+    // Inputs: None
+    // Outputs: Returns true if the game is waiting for input
+    bool isWaitingForInput() const;
+    
+    // What it does: Returns how many times the game has waited for input
+    // Inputs: None
+    // Outputs: Number of suspensions (long long)
+    long long getDecisions() const;
+};
+
+// One player connected to the game server. Output is queued and sent without blocking; the session
+// is resumed once the socket has data. The player first gives a name: the saves of a named player are kept
+// under that name for later connections (one connection per name at a time), while a guest (empty name)
+// gets save files of its own that are deleted when the session ends.
+class GameSession : public CoroutineSession {
+private:
+    // Output side of the connection: queues game text and sends it when the renderer presents a frame
+    class OutputBuffer : public std::streambuf {
+    private:
+        GameSession* session;
+    
+    protected:
+        // What it does: Queues one character
+        // Inputs: ch - character to queue
+        // Outputs: The character
+        int_type overflow(int_type ch) override;
+        
+        // What it does: Queues characters
+        // Inputs: text - characters to queue, count - number of characters
+        // Outputs: Number of characters queued
+        std::streamsize xsputn(const char* text, std::streamsize count) override;
+        
+        // What it does: Sends as much queued output as the socket accepts
+        // Inputs: None
+        // Outputs: 0
+        int sync() override;
+    
+    public:
+        // What it does: Creates the output buffer of a session
+        // Inputs: session - owning session
+        // Outputs: None
+        explicit OutputBuffer(GameSession* session);
+    };
+    
+    int fd;
+    int id;
+    int nameLockFd;
+    std::string outgoing;
+    size_t sentBytes;
+    bool connectionLost;
+    OutputBuffer outputBuffer;
+    std::ostream output;
+    
+protected:
+    // What it does: Asks for the player name until a valid one that is not in use arrives, and locks it
+    // Inputs: input - session input, output - session output, prefix - reference to store the prefix of the player's save file names
+    // Outputs: Returns true once a name (or guest play) is chosen, false if the input closed first
+    bool openSaves(std::istream& input, std::ostream& output, std::string& prefix) override;
+    
+    // What it does: Deletes a guest's save files, or unlocks the player name
+    // Inputs: prefix - prefix of the player's save file names
+    // Outputs: None
+    void closeSaves(const std::string& prefix) override;
+    
+public:
+    // Queued output after which a client that does not read is disconnected
+    static const size_t MAX_PENDING_OUTPUT = 1024 * 1024;
+    
+    // Longest player name accepted
+    static const size_t MAX_NAME_LENGTH = 32;
+    
+    // What it does: Creates a session on an accepted, non-blocking connection
+    // Inputs: fd - connection socket (owned by the session), id - session number, seed - seed of the session's game,
+    //         savePrefix - prefix of every player's save files (e.g. the save directory)
+    // Outputs: None
+    GameSession(int fd, int id, uint64_t seed, const std::string& savePrefix);
+    
+    // What it does: Ends a game that is still running and closes the connection
+    // Inputs: None
+    // Outputs: None
+    ~GameSession() override;
+    
+    // What it does: Reads everything the client sent and lets the game continue if it was waiting for it
+    // Inputs: None
+    // Outputs: None
+    void receive();
+    
+    // What it does: Sends as much queued output as the socket accepts without blocking
+    // Inputs: None
+    // Outputs: Returns true if no output is left queued
+    bool flush();
+    
+    // What it does: Checks if the connection failed (output can no longer be sent)
+    // Inputs: None
+    // Outputs: Returns true if the connection is lost
+    bool isConnectionLost() const;
+    
+    // What it does: Checks if output is waiting for the socket to become writable
+    // Inputs: None
+    // Outputs: Returns true if output is queued
+    bool hasPendingOutput() const;
+    
+    // What it does: Returns the connection socket
+    // Inputs: None
+    // Outputs: File descriptor (int)
+    int getFd() const;
+    
+    // What it does: Returns the session number
+    // Inputs: None
+    // Outputs: Session id (int)
+    int getId() const;
+};
+
+// Session fed from memory by its owner instead of a socket (game output is skipped). Benchmarks use it
+// to drive thousands of games from one loop without any I/O.
+class LocalSession : public CoroutineSession {
+private:
+    std::ostream output;
+    
+public:
+    // What it does: Creates a session whose game has not started yet
+    // Inputs: seed - seed of the session's game, savePrefix - prefix of the session's save files
+    // Outputs: None
+    LocalSession(uint64_t seed, const std::string& savePrefix);
+    
+    // What it does: Ends a game that is still running
+    // Inputs: None
+    // Outputs: None
+    ~LocalSession() override;
+    
+    // What it does: Hands the game input and lets it run until it needs more or ends
+    // Inputs: text - input to send (e.g. one choice followed by a newline)
+    // Outputs: None
+    void send(const std::string& text);
+    
+    // What it does: Ends the input; the game ends once it has read what was sent
+    // Inputs: None
+    // Outputs: None
+    void hangUp();
+};
+
+#endif
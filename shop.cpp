@@ -1,6 +1,5 @@
 #include "shop.h"
-#include <iostream>
-#include <limits>
+#include "metrics.h"
 using namespace std;
 
 Shop::Shop() {
@@ -9,53 +8,51 @@ Shop::Shop() {
 Shop::~Shop() {
 }
 
-void Shop::displayItems() const {
-    cout << "\n=== SHOP ===" << endl;
-    cout << "1. Hamburger - Permanently increase Max HP by 20 (Cost: 1 gold)" << endl;
-    cout << "2. Coke - Permanently increase Attack by 10 (Cost: 1 gold)" << endl;
-    cout << "3. Exit Shop" << endl;
-    cout << "============\n" << endl;
+void Shop::displayItems(Renderer* renderer) const {
+    renderer->out() << "\n=== SHOP ===\n";
+    renderer->out() << "1. Hamburger - Permanently increase Max HP by 20 (Cost: 1 gold)\n";
+    renderer->out() << "2. Coke - Permanently increase Attack by 10 (Cost: 1 gold)\n";
+    renderer->out() << "3. Exit Shop\n";
+    renderer->out() << "============\n\n";
 }
 
-bool Shop::open(Player* player) {
+bool Shop::open(Player* player, Renderer* renderer) {
+    METRIC_TIME(MetricPhase::ShopVisit);
     while (true) {
-        displayItems();
-        cout << "Your gold: " << player->getGold() << endl;
-        cout << "Your current stats:" << endl;
-        cout << "  Max HP: " << player->getMaxHealth() << endl;
-        cout << "  Attack: " << player->getAttack() << endl;
-        cout << "\nSelect item to purchase (1-3): ";
+        displayItems(renderer);
+        renderer->out() << "Your gold: " << player->getGold() << '\n';
+        renderer->out() << "Your current stats:\n";
+        renderer->out() << "  Max HP: " << player->getMaxHealth() << '\n';
+        renderer->out() << "  Attack: " << player->getAttack() << '\n';
+        renderer->out() << "\nSelect item to purchase (1-3): ";
         
         int choice;
-        cin >> choice;
-        
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "Invalid input. Please enter a number." << endl;
+        if (!renderer->read(choice)) {
+            renderer->skipLine();
+            renderer->out() << "Invalid input. Please enter a number.\n";
             continue;
         }
         
         switch (choice) {
             case 1:
                 if (purchaseItem(player, "Hamburger")) {
-                    cout << "Purchase successful!" << endl;
+                    renderer->out() << "Purchase successful!\n";
                 } else {
-                    cout << "Purchase failed! Insufficient gold." << endl;
+                    renderer->out() << "Purchase failed! Insufficient gold.\n";
                 }
                 break;
             case 2:
                 if (purchaseItem(player, "Coke")) {
-                    cout << "Purchase successful!" << endl;
+                    renderer->out() << "Purchase successful!\n";
                 } else {
-                    cout << "Purchase failed! Insufficient gold." << endl;
+                    renderer->out() << "Purchase failed! Insufficient gold.\n";
                 }
                 break;
             case 3:
-                cout << "Leaving shop..." << endl;
+                renderer->out() << "Leaving shop...\n";
                 return false;
             default:
-                cout << "Invalid choice. Please select 1-3." << endl;
+                renderer->out() << "Invalid choice. Please select 1-3.\n";
                 break;
         }
     }
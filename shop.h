@@ -2,13 +2,14 @@
 #define SHOP_H
 
 #include "player.h"
+#include "renderer.h"
 
 class Shop {
 private:
     // What it does: Displays available items in shop menu
-    // Inputs: None
+    // Inputs: renderer - renderer to print to
     // Outputs: None
-    void displayItems() const;
+    void displayItems(Renderer* renderer) const;
     
 public:
     // What it does: Initializes shop
@@ -22,9 +23,9 @@ public:
     ~Shop();
     
     // What it does: Opens shop menu and handles purchases
-    // Inputs: player - pointer to player object
+    // Inputs: player - pointer to player object, renderer - renderer the menu is shown and input is read through
     // Outputs: Returns true if player wants to continue, false if they want to exit
-    bool open(Player* player);
+    bool open(Player* player, Renderer* renderer);
     
     // What it does: Processes item purchase and applies effects to player
     // Inputs: player - pointer to player object, itemName - name of item to purchase
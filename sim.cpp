@@ -0,0 +1,537 @@
+#include "simulator.h"
+#include "level.h"
+#include "event.h"
+#include "lockstep.h"
+#include "policy.h"
+#include "solver.h"
+#include "mcts.h"
+#include "metrics.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <sys/resource.h>
+using namespace std;
+
+// What it does: Prints command line usage of the simulator
+// Inputs: program - name the program was started with
+// Outputs: None
+static void printUsage(const char* program) {
+    cout << "Usage: " << program << " [--runs N] [--threads T] [--difficulty easy|hard|both] [--start-gold G] [--seed S]"
+         << " [--levels FILE] [--events FILE] [--endless LEVELS] [--metrics FILE]" << endl;
+    cout << "       " << program << " --lockstep LEVEL [--runs N] [--difficulty easy|hard] [--equipment A,B,...]"
+         << " [--isa scalar|avx2|avx512] [--verify] [--seed S]" << endl;
+    cout << "       " << program << " --solve [--difficulty easy|hard|both] [--equipment A,B,...] [--potions Life=2,Mystery=1,...]"
+         << " [--max-states N] [--policy FILE|-] [--verify] [--runs N] [--seed S]" << endl;
+    cout << "       " << program << " --horde SIZE [--runs N] [--difficulty easy|hard] [--equipment A,B,...] [--potions Life=2,...] [--seed S]" << endl;
+    cout << "       " << program << " --mcts [--runs N] [--threads T] [--budget-ms MS] [--simulations N] [--difficulty easy|hard|both]"
+         << " [--start-gold G] [--seed S] [--metrics FILE]" << endl;
+}
+
+// What it does: Simulates one battle level many times with the lockstep SIMD kernel and prints throughput,
+// optionally checking every outcome against Battle::execute
+// Inputs: levelNum - battle level to fight, hard - true for hard mode turn order, equipment - equipment names the player owns,
+//         isa - instruction set to use, runs - number of battles, seed - base seed, verify - true to cross-check with Battle
+// Outputs: Returns true if verification passed (or was not requested), false otherwise
+static bool runLockstep(int levelNum, bool hard, const vector<string>& equipment, KernelIsa isa,
+                        long long runs, uint64_t seed, bool verify) {
+    Player player;
+    for (const auto& name : equipment) {
+        player.addEquipment(name);
+    }
+    Level level = Level::createLevel(levelNum);
+    LockstepBattleKernel kernel(player, level.getEnemies(), !hard, false, EquipmentType::None, isa);
+    
+    vector<uint64_t> seeds(runs);
+    for (long long i = 0; i < runs; i++) {
+        seeds[i] = Random::deriveSeed(seed, i);
+    }
+    vector<LockstepOutcome> outcomes(runs);
+    
+    auto start = chrono::steady_clock::now();
+    kernel.run(seeds.data(), (int)runs, outcomes.data());
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    
+    long long wins = 0;
+    long long turns = 0;
+    for (const auto& outcome : outcomes) {
+        wins += outcome.won;
+        turns += outcome.turns;
+    }
+    double count = runs > 0 ? (double)runs : 1.0;
+    cout << fixed << setprecision(2);
+    cout << "\n=== Lockstep level " << levelNum << " (" << (hard ? "Hard" : "Easy") << ", "
+         << LockstepBattleKernel::getIsaName(isa) << ", " << LockstepBattleKernel::getLaneCount(isa)
+         << " lane(s)) ===" << endl;
+    cout << "Battles: " << runs << " (" << setprecision(0) << runs / (seconds > 0 ? seconds : 1e-9)
+         << " battles/s)" << setprecision(2) << endl;
+    cout << "Win rate: " << 100.0 * wins / count << "%" << endl;
+    cout << "Average turns: " << turns / count << endl;
+    
+    if (!verify) return true;
+    
+    AutoBattlePolicy policy;
+    long long mismatches = 0;
+    for (long long i = 0; i < runs; i++) {
+        Player copy = player;
+        PotionManager potions;
+        Random rng(seeds[i]);
+        Battle battle(&copy, &potions, &rng, level.getEnemies(), !hard);
+        bool won = battle.execute(policy);
+        if (won != outcomes[i].won || battle.getTurnCount() != outcomes[i].turns ||
+            copy.getCurrentHealth() != outcomes[i].playerHealth) {
+            if (mismatches == 0) {
+                cout << "First mismatch at battle " << i << " (seed " << seeds[i] << ")" << endl;
+            }
+            mismatches++;
+        }
+    }
+    cout << "Verification against Battle::execute: " << (mismatches == 0 ? "passed" : "FAILED")
+         << " (" << mismatches << " mismatches)" << endl;
+    return mismatches == 0;
+}
+
+// What it does: Plays horde battles (a boss followed by random Slims, Bathos and Gousts) with the automatic policy and
+// prints throughput and how far the player got. The player's max HP is raised to outlast the whole horde's attacks
+// until the turn limit, so every battle plays out at full size instead of ending on the first enemy turn.
+// Inputs: size - enemies per battle, hard - true for hard mode turn order, equipment - equipment names the player owns,
+//         potions - potions the player carries, runs - number of battles, seed - base seed
+// Outputs: None
+static void runHorde(int size, bool hard, const vector<string>& equipment, const PotionManager& potions,
+                     long long runs, uint64_t seed) {
+    Player player;
+    for (const auto& name : equipment) {
+        player.addEquipment(name);
+    }
+    AutoBattlePolicy policy;
+    vector<EnemyType> horde(size);
+    long long wins = 0;
+    long long turns = 0;
+    long long defeated = 0;
+    long long survivors[ENEMY_TYPE_COUNT] = {};
+    double seconds = 0.0;
+    
+    for (long long i = 0; i < runs; i++) {
+        Random rng(Random::deriveSeed(seed, i));
+        long long hordeAttack = 0;
+        horde[0] = EnemyType::Boss;
+        for (int j = 1; j < size; j++) {
+            horde[j] = (EnemyType)rng.nextInt((int)EnemyType::Boss);
+        }
+        for (int j = 0; j < size; j++) {
+            hordeAttack += getEnemyTypeAttack(horde[j]);
+        }
+        Player copy = player;
+        copy.setBaseMaxHealth((int)min(hordeAttack * 51 + 100, 2000000000LL));
+        PotionManager potionCopy = potions;
+        
+        auto start = chrono::steady_clock::now();
+        Battle battle(&copy, &potionCopy, &rng, horde.data(), size, !hard);
+        wins += battle.execute(policy);
+        seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        
+        turns += battle.getTurnCount();
+        defeated += battle.getEnemies().getDefeatedCount();
+        for (int type = 0; type < ENEMY_TYPE_COUNT; type++) {
+            survivors[type] += battle.getEnemies().countAlive((EnemyType)type);
+        }
+    }
+    
+    double count = runs > 0 ? (double)runs : 1.0;
+    seconds = seconds > 0 ? seconds : 1e-9;
+    cout << fixed << setprecision(2);
+    cout << "\n=== Horde of " << size << " (" << (hard ? "Hard" : "Easy") << ") ===" << endl;
+    cout << "Battles: " << runs << " (" << runs / seconds << " battles/s, "
+         << setprecision(1) << 1e6 * seconds / max(1LL, turns) << " us per turn)" << setprecision(2) << endl;
+    cout << "Win rate: " << 100.0 * wins / count << "%" << endl;
+    cout << "Average turns: " << turns / count << endl;
+    cout << "Average enemies defeated: " << defeated / count << endl;
+    cout << "Average survivors:";
+    for (int type = 0; type < ENEMY_TYPE_COUNT; type++) {
+        cout << " " << getEnemyTypeName((EnemyType)type) << " " << survivors[type] / count;
+    }
+    cout << endl;
+}
+
+// What it does: Solves every battle level exactly and prints the win probability under optimal play and the optimal
+// opening, optionally writing the whole optimal policy and checking each probability by playing it through Battle::execute
+// Inputs: easy, hard - difficulties to solve, equipment - equipment names the player owns, potions - potions the player carries,
+//         maxStates - solved states a level may keep before it is reported as too large, policyFile - file to write the
+//         optimal policy of every level to ("-" for standard output, empty for none),
+//         runs - battles per level for verification, seed - base seed, verify - true to cross-check with Battle
+// Outputs: Returns true if every level was solved, the policy was written and verification passed (or was not requested), false otherwise
+static bool runSolver(bool easy, bool hard, const vector<string>& equipment, const PotionManager& potions,
+                      size_t maxStates, const string& policyFile, long long runs, uint64_t seed, bool verify) {
+    Player player;
+    for (const auto& name : equipment) {
+        player.addEquipment(name);
+    }
+    
+    ofstream policyStream;
+    ostream* policyOut = nullptr;
+    if (policyFile == "-") {
+        policyOut = &cout;
+    } else if (!policyFile.empty()) {
+        policyStream.open(policyFile);
+        if (!policyStream) {
+            cout << "Failed to write " << policyFile << endl;
+            return false;
+        }
+        policyOut = &policyStream;
+    }
+    size_t policyLines = 0;
+    
+    bool passed = true;
+    for (int difficulty = 0; difficulty <= 1; difficulty++) {
+        if ((difficulty == 0 && !easy) || (difficulty == 1 && !hard)) continue;
+        cout << "\n=== Optimal play (" << (difficulty == 0 ? "Easy" : "Hard") << ") ===" << endl;
+        cout << left << setw(7) << "Level" << setw(22) << "Enemies" << right << setw(10) << "Win %"
+             << setw(10) << "States" << setw(10) << "Time" << "  " << left << setw(28) << "Opening move";
+        if (verify) {
+            cout << right << setw(12) << "Played %";
+        }
+        cout << endl;
+        
+        for (int levelNum = 1; levelNum <= Level::getTotalLevels(); levelNum++) {
+            Level level = Level::createLevel(levelNum);
+            if (!level.isBattle()) continue;
+            string enemies;
+            for (const auto& name : level.getEnemies()) {
+                enemies += (enemies.empty() ? "" : ",") + name;
+            }
+            
+            auto start = chrono::steady_clock::now();
+            BattleSolver solver(player, potions, level.getEnemies(), difficulty == 0);
+            solver.setStateLimit(maxStates);
+            double winChance = 0.0;
+            bool solved = solver.solve(winChance);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            
+            if (!solved) {
+                cout << left << setw(7) << levelNum << setw(22) << enemies << "Too large to solve: more than " << maxStates
+                     << " states (raise --max-states or carry fewer potions)" << endl;
+                passed = false;
+                continue;
+            }
+            cout << fixed << left << setw(7) << levelNum << setw(22) << enemies << right << setprecision(4)
+                 << setw(10) << 100.0 * winChance << setw(10) << solver.getStateCount() << setprecision(3)
+                 << setw(9) << seconds << "s" << "  " << left << setw(28) << BattleSolver::describe(solver.getOpeningDecision());
+            
+            if (verify) {
+                OptimalBattlePolicy policy(&solver);
+                long long wins = 0;
+                for (long long i = 0; i < runs; i++) {
+                    Player copy = player;
+                    PotionManager potionCopy = potions;
+                    Random rng(Random::deriveSeed(seed, i));
+                    Battle battle(&copy, &potionCopy, &rng, level.getEnemies(), difficulty == 0);
+                    wins += battle.execute(policy);
+                }
+                double played = runs > 0 ? (double)wins / runs : 0.0;
+                double error = runs > 0 ? sqrt(winChance * (1 - winChance) / runs) : 0.0;
+                bool close = fabs(played - winChance) <= 4 * error + 1e-9;
+                passed = passed && close;
+                cout << right << setprecision(4) << setw(12) << 100.0 * played << (close ? "" : "  MISMATCH");
+            }
+            cout << endl;
+            
+            if (policyOut) {
+                *policyOut << (policyOut == &cout ? "\n" : "") << "--- Level " << levelNum << " (" << (difficulty == 0 ? "Easy" : "Hard")
+                           << "): " << enemies << ", win " << fixed << setprecision(4) << 100.0 * winChance << "% ---" << endl;
+                policyLines += solver.writePolicy(*policyOut);
+                *policyOut << (policyOut == &cout ? "\n" : "") << flush;
+            }
+        }
+    }
+    if (policyOut && policyOut != &cout) {
+        policyStream.close();
+        if (!policyStream) {
+            cout << "Failed to write " << policyFile << endl;
+            return false;
+        }
+        cout << "\nOptimal policy written to " << policyFile << " (" << policyLines << " decisions)" << endl;
+    }
+    if (verify) {
+        cout << "\nVerification against Battle::execute (" << runs << " battles per level): "
+             << (passed ? "passed" : "FAILED") << endl;
+    }
+    return passed;
+}
+
+// What it does: Prints the balance report for one difficulty
+// Inputs: name - difficulty name, stats - aggregated campaign results, seconds - wall time of the run
+// Outputs: None
+static void printReport(const string& name, const SimStats& stats, double seconds) {
+    double runs = stats.runs > 0 ? (double)stats.runs : 1.0;
+    cout << fixed << setprecision(2);
+    cout << "\n=== " << name << " ===" << endl;
+    cout << "Campaigns: " << stats.runs << " (" << setprecision(0) << stats.runs / seconds 
+         << " campaigns/s)" << setprecision(2) << endl;
+    cout << "Win rate: " << 100.0 * stats.wins / runs << "%" << endl;
+    cout << "Levels cleared: " << stats.levelsCleared << " (" << stats.levelsCleared / runs << " per run, deepest level "
+         << stats.deepestLevel << ")" << endl;
+    
+    cout << "Deaths per level:" << endl;
+    for (int level = 1; level <= Level::getTotalLevels(); level++) {
+        if (stats.deathsAtLevel[level] > 0) {
+            cout << "  Level " << setw(2) << level << ": " << setw(10) << stats.deathsAtLevel[level]
+                 << " (" << 100.0 * stats.deathsAtLevel[level] / runs << "%)" << endl;
+        }
+    }
+    long long endlessDeaths = stats.deathsAtLevel[Level::getTotalLevels() + 1];
+    if (endlessDeaths > 0) {
+        cout << "  Endless : " << setw(10) << endlessDeaths << " (" << 100.0 * endlessDeaths / runs << "%)" << endl;
+    }
+    
+    cout << "Final gold:" << endl;
+    for (size_t gold = 0; gold < stats.goldHistogram.size(); gold++) {
+        if (stats.goldHistogram[gold] > 0) {
+            cout << "  " << gold << (gold + 1 == stats.goldHistogram.size() ? "+" : " ") << ": " 
+                 << 100.0 * stats.goldHistogram[gold] / runs << "%" << endl;
+        }
+    }
+    
+    cout << "Equipment pieces owned:" << endl;
+    for (size_t count = 0; count < stats.equipmentSlotsUsed.size(); count++) {
+        cout << "  " << count << ": " << 100.0 * stats.equipmentSlotsUsed[count] / runs << "%" << endl;
+    }
+    
+    cout << "Average equipment per run:" << endl;
+    vector<string> types = Player::getEquipmentTypes();
+    for (size_t i = 0; i < types.size(); i++) {
+        cout << "  " << types[i] << ": " << setprecision(3) << stats.equipmentTotals[i] / runs 
+             << setprecision(2) << endl;
+    }
+}
+
+// What it does: Plays campaigns with the MCTS bot and with the automatic policy on the same seeds, printing the bot's
+// balance report, both win rates and the search throughput
+// Inputs: difficulty - difficulty mode (0=easy, 1=hard), runs - number of campaigns, threads - search threads per decision (0 = one per core),
+//         budgetMs - search time per decision, simulations - simulation cap per decision (0 = none), startGold - starting gold, seed - base seed
+// Outputs: None
+static void runMcts(int difficulty, long long runs, int threads, double budgetMs, long long simulations, int startGold, uint64_t seed) {
+    MctsBattlePolicy bot(threads, budgetMs, simulations, seed);
+    AutoBattlePolicy autoPolicy;
+    SimStats botStats;
+    SimStats autoStats;
+    Random rng;
+    
+    auto start = chrono::steady_clock::now();
+    for (long long i = 0; i < runs; i++) {
+        rng.seed(Random::deriveSeed(seed, i * 2 + difficulty));
+        CampaignSimulator::runCampaign(difficulty, startGold, rng, bot, botStats);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (long long i = 0; i < runs; i++) {
+        rng.seed(Random::deriveSeed(seed, i * 2 + difficulty));
+        CampaignSimulator::runCampaign(difficulty, startGold, rng, autoPolicy, autoStats);
+    }
+    
+    string name = difficulty == 0 ? "Easy" : "Hard";
+    printReport(name + ", MCTS bot", botStats, seconds > 0 ? seconds : 1e-9);
+    double searchSeconds = bot.getSearchSeconds() > 0 ? bot.getSearchSeconds() : 1e-9;
+    cout << "Automatic policy win rate on the same campaigns: " << 100.0 * autoStats.wins / max(1LL, autoStats.runs) << "%" << endl;
+    cout << "Search: " << bot.getDecisionCount() << " decisions on " << bot.getThreadCount() << " thread(s), "
+         << setprecision(1) << bot.getDecisionCount() / searchSeconds << " decisions/s, "
+         << setprecision(0) << bot.getSimulationCount() / searchSeconds << " simulations/s, "
+         << bot.getSimulationCount() / max(1LL, bot.getDecisionCount()) << " simulations per decision" << setprecision(2) << endl;
+}
+
+// What it does: Writes the metrics recorded during the simulation (Prometheus text for a ".prom" file, JSON otherwise)
+// Inputs: fileName - file to write
+// Outputs: Returns true if the file was written, false otherwise
+static bool saveMetrics(const string& fileName) {
+    if (!metricsEnabled()) {
+        cout << "This build records no metrics; rebuild with 'make clean && make sim METRICS=1'." << endl;
+    }
+    if (!writeMetricsFile(fileName)) {
+        cout << "Failed to write " << fileName << endl;
+        return false;
+    }
+    cout << "Metrics written to " << fileName << endl;
+    return true;
+}
+
+// What it does: Entry point of the Monte Carlo balance simulator. Runs full campaigns on all cores and prints statistics.
+// Inputs: argc - argument count, argv - command line arguments
+// Outputs: Returns exit code (0 on success, 1 on bad arguments)
+int main(int argc, char* argv[]) {
+    long long runs = 10000;
+    int threads = 0;
+    int startGold = 0;
+    uint64_t seed = Random::randomSeed();
+    bool easy = true;
+    bool hard = true;
+    int lockstepLevel = 0;
+    int hordeSize = 0;
+    vector<string> equipment;
+    KernelIsa isa = LockstepBattleKernel::detectIsa();
+    bool verify = false;
+    bool solve = false;
+    size_t maxStates = BattleSolver::DEFAULT_STATE_LIMIT;
+    string policyFile;
+    PotionManager potions;
+    bool mcts = false;
+    double budgetMs = 20.0;
+    long long simulations = 0;
+    int levelCount = 0;
+    string metricsFile;
+    
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+            runs = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--start-gold") == 0 && hasValue) {
+            startGold = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--difficulty") == 0 && hasValue) {
+            string mode = argv[++i];
+            easy = (mode == "easy" || mode == "both");
+            hard = (mode == "hard" || mode == "both");
+        } else if (strcmp(argv[i], "--lockstep") == 0 && hasValue) {
+            lockstepLevel = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--horde") == 0 && hasValue) {
+            hordeSize = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--equipment") == 0 && hasValue) {
+            string list = argv[++i];
+            size_t begin = 0;
+            while (begin <= list.size()) {
+                size_t end = list.find(',', begin);
+                if (end == string::npos) end = list.size();
+                if (end > begin) equipment.push_back(list.substr(begin, end - begin));
+                begin = end + 1;
+            }
+        } else if (strcmp(argv[i], "--isa") == 0 && hasValue) {
+            string name = argv[++i];
+            if (name == "scalar") {
+                isa = KernelIsa::Scalar;
+            } else if (name == "avx2") {
+                isa = KernelIsa::Avx2;
+            } else if (name == "avx512") {
+                isa = KernelIsa::Avx512;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--potions") == 0 && hasValue) {
+            string list = argv[++i];
+            size_t begin = 0;
+            while (begin < list.size()) {
+                size_t end = list.find(',', begin);
+                if (end == string::npos) end = list.size();
+                string item = list.substr(begin, end - begin);
+                size_t equals = item.find('=');
+                string name = item.substr(0, equals);
+                int count = equals == string::npos ? 1 : atoi(item.c_str() + equals + 1);
+                PotionType type = parsePotionType(name);
+                if (type == PotionType::None) {
+                    type = parsePotionType(name + " Potion");
+                }
+                potions.addPotion(type, count);
+                if (type == PotionType::None) {
+                    cout << "Unknown potion " << name << "." << endl;
+                    return 1;
+                }
+                begin = end + 1;
+            }
+        } else if (strcmp(argv[i], "--levels") == 0 && hasValue) {
+            string error;
+            if (!Level::loadTable(argv[++i], error)) {
+                cout << "Invalid level table: " << error << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--events") == 0 && hasValue) {
+            string error;
+            if (!EventManager::loadTable(argv[++i], error)) {
+                cout << "Invalid event weights: " << error << endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--endless") == 0 && hasValue) {
+            levelCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--metrics") == 0 && hasValue) {
+            metricsFile = argv[++i];
+        } else if (strcmp(argv[i], "--mcts") == 0) {
+            mcts = true;
+        } else if (strcmp(argv[i], "--budget-ms") == 0 && hasValue) {
+            budgetMs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--simulations") == 0 && hasValue) {
+            simulations = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--solve") == 0) {
+            solve = true;
+        } else if (strcmp(argv[i], "--max-states") == 0 && hasValue) {
+            maxStates = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--policy") == 0 && hasValue) {
+            policyFile = argv[++i];
+        } else if (strcmp(argv[i], "--verify") == 0) {
+            verify = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (solve) {
+        cout << "Solving every battle level exactly" << (verify ? ", verifying with " + to_string(runs) + " battles per level" : "")
+             << "..." << endl;
+        return runSolver(easy, hard, equipment, potions, maxStates, policyFile, runs, seed, verify) ? 0 : 1;
+    }
+    
+    if (mcts) {
+        cout << "Running " << runs << " campaigns per difficulty with the MCTS bot, seed " << seed << "..." << endl;
+        for (int difficulty = 0; difficulty <= 1; difficulty++) {
+            if ((difficulty == 0 && !easy) || (difficulty == 1 && !hard)) continue;
+            runMcts(difficulty, runs, threads, budgetMs, simulations, startGold, seed);
+        }
+        return metricsFile.empty() || saveMetrics(metricsFile) ? 0 : 1;
+    }
+    
+    if (hordeSize != 0) {
+        if (hordeSize < 1 || hordeSize > Battle::MAX_HORDE_ENEMIES) {
+            cout << "A horde has 1 to " << Battle::MAX_HORDE_ENEMIES << " enemies." << endl;
+            return 1;
+        }
+        cout << "Running " << runs << " horde battles of " << hordeSize << " enemies, seed " << seed << "..." << endl;
+        runHorde(hordeSize, hard && !easy, equipment, potions, runs, seed);
+        return 0;
+    }
+    
+    if (lockstepLevel != 0) {
+        if (lockstepLevel < 1 || lockstepLevel > Level::getTotalLevels() ||
+            !Level::createLevel(lockstepLevel).isBattle()) {
+            cout << "Level " << lockstepLevel << " is not a battle level." << endl;
+            return 1;
+        }
+        if ((int)isa > (int)LockstepBattleKernel::detectIsa()) {
+            cout << "This CPU does not support " << LockstepBattleKernel::getIsaName(isa) << "." << endl;
+            return 1;
+        }
+        cout << "Running " << runs << " lockstep battles, seed " << seed << "..." << endl;
+        return runLockstep(lockstepLevel, hard && !easy, equipment, isa, runs, seed, verify) ? 0 : 1;
+    }
+    
+    CampaignSimulator simulator(threads, startGold, seed, levelCount);
+    cout << "Running " << runs << " campaigns of " << (levelCount > 0 ? levelCount : Level::getTotalLevels())
+         << " levels per difficulty on " << simulator.getThreadCount() << " thread(s), seed " << seed << "..." << endl;
+    
+    for (int difficulty = 0; difficulty <= 1; difficulty++) {
+        if ((difficulty == 0 && !easy) || (difficulty == 1 && !hard)) continue;
+        auto start = chrono::steady_clock::now();
+        SimStats stats = simulator.run(difficulty, runs);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printReport(difficulty == 0 ? "Easy" : "Hard", stats, seconds > 0 ? seconds : 1e-9);
+    }
+    
+    struct rusage usage;
+    if (levelCount > 0 && getrusage(RUSAGE_SELF, &usage) == 0) {
+        cout << "\nPeak memory: " << usage.ru_maxrss / 1024.0 << " MB" << endl;
+    }
+    return metricsFile.empty() || saveMetrics(metricsFile) ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include "simulator.h"
+#include "level.h"
+#include "event.h"
+#include "shop.h"
+#include "policy.h"
+#include "metrics.h"
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <utility>
+using namespace std;
+
+namespace {
+    const int GOLD_BUCKETS = 8;
+    const long long CHUNK_SIZE = 64;
+}
+
+SimStats::SimStats() 
+    : runs(0), wins(0), levelsCleared(0), deepestLevel(0), deathsAtLevel(Level::getTotalLevels() + 2, 0), 
+      goldHistogram(GOLD_BUCKETS, 0), equipmentTotals(Player::getEquipmentTypes().size(), 0),
+      equipmentSlotsUsed(4, 0) {
+}
+
+void SimStats::merge(const SimStats& other) {
+    runs += other.runs;
+    wins += other.wins;
+    levelsCleared += other.levelsCleared;
+    deepestLevel = max(deepestLevel, other.deepestLevel);
+    for (size_t i = 0; i < deathsAtLevel.size(); i++) {
+        deathsAtLevel[i] += other.deathsAtLevel[i];
+    }
+    for (size_t i = 0; i < goldHistogram.size(); i++) {
+        goldHistogram[i] += other.goldHistogram[i];
+    }
+    for (size_t i = 0; i < equipmentTotals.size(); i++) {
+        equipmentTotals[i] += other.equipmentTotals[i];
+    }
+    for (size_t i = 0; i < equipmentSlotsUsed.size(); i++) {
+        equipmentSlotsUsed[i] += other.equipmentSlotsUsed[i];
+    }
+}
+
+CampaignSimulator::CampaignSimulator(int threadCount, int startGold, uint64_t seed, int levelCount) 
+    : threadCount(threadCount), startGold(startGold), seed(seed), levelCount(levelCount) {
+    if (this->threadCount <= 0) {
+        this->threadCount = max(1u, thread::hardware_concurrency());
+    }
+}
+
+int CampaignSimulator::getThreadCount() const {
+    return threadCount;
+}
+
+SimStats CampaignSimulator::run(int difficulty, long long campaigns) const {
+    vector<SimStats> results(threadCount);
+    atomic<long long> nextChunk(0);
+    
+    // Every worker counts into statistics it allocated itself (their counters live in heap buffers, which
+    // would share cache lines if one thread allocated them all back to back) and hands them over at the end
+    auto worker = [&](SimStats& result) {
+        SimStats stats;
+        AutoBattlePolicy policy;
+        Random rng;
+        while (true) {
+            long long begin = nextChunk.fetch_add(CHUNK_SIZE, memory_order_relaxed);
+            if (begin >= campaigns) break;
+            long long end = min(campaigns, begin + CHUNK_SIZE);
+            for (long long i = begin; i < end; i++) {
+                rng.seed(Random::deriveSeed(seed, i * 2 + difficulty));
+                runCampaign(difficulty, startGold, rng, policy, stats, levelCount);
+            }
+        }
+        result = move(stats);
+    };
+    
+    vector<thread> workers;
+    for (int i = 1; i < threadCount; i++) {
+        workers.emplace_back(worker, ref(results[i]));
+    }
+    worker(results[0]);
+    for (auto& t : workers) {
+        t.join();
+    }
+    
+    SimStats total;
+    for (const auto& stats : results) {
+        total.merge(stats);
+    }
+    return total;
+}
+
+bool CampaignSimulator::runCampaign(int difficulty, int startGold, Random& rng, BattlePolicy& policy, SimStats& stats, int levelCount) {
+    Player player;
+    PotionManager potionManager;
+    EventManager eventManager(&rng, difficulty == 1);
+    Shop shop;
+    bool enemyDoubleHP = false;
+    string disabledEquipment = "";
+    bool won = true;
+    
+    player.setGold(startGold);
+    stats.runs++;
+    
+    int lastLevel = levelCount > 0 ? levelCount : Level::getTotalLevels();
+    for (int currentLevel = 1; currentLevel <= lastLevel; currentLevel++) {
+        player.restoreToFull();
+        Level level = Level::createLevel(currentLevel);
+        
+        if (level.isBattle()) {
+            Battle battle(&player, &potionManager, &rng, level, difficulty == 0,
+                          enemyDoubleHP, disabledEquipment);
+            enemyDoubleHP = false;
+            disabledEquipment = "";
+            if (!battle.execute(policy)) {
+                stats.deathsAtLevel[min(currentLevel, Level::getTotalLevels() + 1)]++;
+                stats.deepestLevel = max(stats.deepestLevel, currentLevel);
+                won = false;
+                break;
+            }
+            potionManager.addPotion(PotionManager::getRandomPotion(rng), 1);
+            if (level.awardsEquipment()) {
+                player.addEquipment(Player::getRandomEquipment(rng));
+            }
+        } else {
+            eventManager.executeRandomEvent(&player, &potionManager, enemyDoubleHP, disabledEquipment);
+        }
+        
+        {
+            METRIC_TIME(MetricPhase::ShopVisit);
+            bool buyCoke = true;
+            while (player.getGold() > 0) {
+                shop.purchaseItem(&player, buyCoke ? "Coke" : "Hamburger");
+                buyCoke = !buyCoke;
+            }
+        }
+        stats.levelsCleared++;
+    }
+    
+    if (won) {
+        stats.deepestLevel = max(stats.deepestLevel, lastLevel);
+        stats.wins++;
+        player.addGold(1);
+    }
+    
+    stats.goldHistogram[min(player.getGold(), GOLD_BUCKETS - 1)]++;
+    for (int i = 0; i < EQUIPMENT_TYPE_COUNT; i++) {
+        stats.equipmentTotals[i] += player.countEquipment((EquipmentType)i);
+    }
+    stats.equipmentSlotsUsed[player.getEquippedCount()]++;
+    return won;
+}
@@ -0,0 +1,61 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "battle.h"
+#include <vector>
+
+// Aggregated results of many simulated campaigns for one difficulty
+struct SimStats {
+    long long runs;
+    long long wins;
+    long long levelsCleared;
+    int deepestLevel;
+    std::vector<long long> deathsAtLevel;       // index = level number where the run died (last entry: any endless level)
+    std::vector<long long> goldHistogram;       // index = final gold (last bucket collects the rest)
+    std::vector<long long> equipmentTotals;     // index = position in Player::getEquipmentTypes()
+    std::vector<long long> equipmentSlotsUsed;  // index = number of equipment pieces owned at the end
+    
+    // What it does: Creates empty statistics
+    // Inputs: None
+    // Outputs: None
+    SimStats();
+    
+    // What it does: Adds another set of statistics into this one
+    // Inputs: other - statistics to add
+    // Outputs: None
+    void merge(const SimStats& other);
+};
+
+// Runs complete 12-level campaigns headlessly and in parallel to measure game balance
+class CampaignSimulator {
+private:
+    int threadCount;
+    int startGold;
+    uint64_t seed;
+    int levelCount;
+    
+public:
+    // What it does: Initializes the simulator
+    // Inputs: threadCount - number of worker threads (0 = one per hardware core), startGold - gold every campaign starts with, seed - base seed (campaign i always uses the same derived seed, whatever the thread count),
+    //         levelCount - levels per campaign (0 = the level table; more continues with generated endless levels)
+    // Outputs: None
+    CampaignSimulator(int threadCount = 0, int startGold = 0, uint64_t seed = 0, int levelCount = 0);
+    
+    // What it does: Runs many campaigns spread across the worker threads
+    // Inputs: difficulty - difficulty mode (0=easy, 1=hard), campaigns - number of campaigns to run
+    // Outputs: Aggregated statistics of all campaigns
+    SimStats run(int difficulty, long long campaigns) const;
+    
+    // What it does: Returns number of worker threads used
+    // Inputs: None
+    // Outputs: Thread count (int)
+    int getThreadCount() const;
+    
+    // What it does: Plays one full campaign from level 1 with the same rules as Game::gameLoop
+    // Inputs: difficulty - difficulty mode (0=easy, 1=hard), startGold - starting gold, rng - random number generator of this campaign, policy - battle decision maker, stats - statistics to record the run into,
+    //         levelCount - levels to play (0 = the level table)
+    // Outputs: Returns true if all levels were completed, false if the player died
+    static bool runCampaign(int difficulty, int startGold, Random& rng, BattlePolicy& policy, SimStats& stats, int levelCount = 0);
+};
+
+#endif
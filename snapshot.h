@@ -0,0 +1,89 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <type_traits>
+
+// Tree of snapshots (BattleSnapshot, GameSnapshot) for undo and what-if branches. A branch is just
+// the index of its newest snapshot; every snapshot links to the one before it, and snapshots are
+// never changed once pushed. Forking a branch therefore copies nothing (the fork shares its whole
+// history), undo moves to the previous snapshot, and pushing onto a fork appends one snapshot
+// without touching the branches it shares history with (copy-on-write). Snapshots live in one
+// contiguous vector, so with reserve() a history allocates nothing while it is played.
+template <typename Snapshot>
+class SnapshotHistory {
+    static_assert(std::is_trivially_copyable<Snapshot>::value, "SnapshotHistory holds trivially copyable snapshots");
+    
+private:
+    // One snapshot and the snapshot before it on its branch
+    struct Entry {
+        Snapshot state;
+        int previous;
+        int depth;
+    };
+    
+    std::vector<Entry> entries;
+    
+public:
+    // Branch handle: index of the branch's newest snapshot
+    typedef int Branch;
+    
+    // Branch without any snapshot
+    static const Branch EMPTY = -1;
+    
+    // What it does: Makes room for snapshots, so pushing up to that many never allocates
+    // Inputs: count - number of snapshots
+    // Outputs: None
+    void reserve(size_t count) {
+        entries.reserve(count);
+    }
+    
+    // What it does: Adds a snapshot on top of a branch (the branch itself is unchanged, forks of it keep their history)
+    // Inputs: branch - branch to extend (EMPTY to start a new one), state - snapshot to add
+    // Outputs: Branch ending with the new snapshot
+    Branch push(Branch branch, const Snapshot& state) {
+        Entry entry;
+        entry.state = state;
+        entry.previous = branch;
+        entry.depth = branch == EMPTY ? 1 : entries[branch].depth + 1;
+        entries.push_back(entry);
+        return (Branch)entries.size() - 1;
+    }
+    
+    // What it does: Returns the newest snapshot of a branch
+    // Inputs: branch - branch that is not EMPTY
+    // Outputs: Reference to the snapshot (valid until the history is cleared or grows past its reserved size)
+    const Snapshot& top(Branch branch) const {
+        return entries[branch].state;
+    }
+    
+    // What it does: Returns the branch without its newest snapshot (one step of undo)
+    // Inputs: branch - branch that is not EMPTY
+    // Outputs: Previous branch (EMPTY if the branch held one snapshot)
+    Branch undo(Branch branch) const {
+        return entries[branch].previous;
+    }
+    
+    // What it does: Returns number of snapshots on a branch
+    // Inputs: branch - branch to measure
+    // Outputs: Snapshot count (0 for EMPTY)
+    int depth(Branch branch) const {
+        return branch == EMPTY ? 0 : entries[branch].depth;
+    }
+    
+    // What it does: Returns number of snapshots stored for all branches together
+    // Inputs: None
+    // Outputs: Snapshot count
+    size_t size() const {
+        return entries.size();
+    }
+    
+    // What it does: Drops every branch (the memory is kept for the next history)
+    // Inputs: None
+    // Outputs: None
+    void clear() {
+        entries.clear();
+    }
+};
+
+#endif
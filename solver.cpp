@@ -0,0 +1,783 @@
+#include "solver.h"
+#include <algorithm>
+#include <new>
+#include <sstream>
+#include <iomanip>
+using namespace std;
+
+namespace {
+    // Marks a free slot of the transposition table (real keys never set the top bits)
+    const uint64_t EMPTY_KEY = ~0ULL;
+    
+    // Number of slots the turn 1 table and the node table start with
+    const size_t INITIAL_TABLE_SIZE = 1 << 16;
+    
+    // Bits of the player's health in a state key (max HP must stay below 2^HEALTH_BITS)
+    const int HEALTH_BITS = 10;
+    
+    // Bits of one enemy slot in a state key: 0 for an empty slot, enemyCodeBase(type) + health otherwise
+    const int ENEMY_BITS = 10;
+    
+    // What it does: Returns the first code of an enemy type in a key slot (types before it take twice their
+    // health in codes, enough for double HP enemies)
+    // Inputs: type - enemy type index (ENEMY_TYPE_COUNT for the end of the last type)
+    // Outputs: Code base (int)
+    constexpr int enemyCodeBase(int type) {
+        int base = 0;
+        for (int i = 0; i < type; i++) {
+            base += 2 * getEnemyTypeHealth((EnemyType)i);
+        }
+        return base;
+    }
+    
+    static_assert(enemyCodeBase(ENEMY_TYPE_COUNT) < (1 << ENEMY_BITS), "enemy health does not fit in a state key slot");
+    
+    // What it does: Finds the slot of a key in an open-addressing table (its slot or the free slot it would go in)
+    // Inputs: slots - table whose size is a power of two, key - packed state
+    // Outputs: Slot index
+    template <typename Slot>
+    size_t findSlot(const vector<Slot>& slots, uint64_t key) {
+        uint64_t hash = key * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot].key != EMPTY_KEY && slots[slot].key != key) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+    
+    // What it does: Doubles an open-addressing table, moving every used slot (throws bad_alloc without changing it)
+    // Inputs: slots - table to grow, empty - value of a free slot
+    // Outputs: None
+    template <typename Slot>
+    void growSlots(vector<Slot>& slots, const Slot& empty) {
+        vector<Slot> old(slots.size() * 2, empty);
+        old.swap(slots);
+        for (const auto& slot : old) {
+            if (slot.key != EMPTY_KEY) {
+                slots[findSlot(slots, slot.key)] = slot;
+            }
+        }
+    }
+    
+    // What it does: Returns the exact probability that Random::nextInt(bound) returns less than limit
+    // (nextInt maps the top 32 bits of a draw onto [0, bound), so the values are not exactly equally likely)
+    // Inputs: limit - exclusive upper end of the rolls counted, bound - bound passed to nextInt
+    // Outputs: Probability (double)
+    double rollBelow(int limit, int bound) {
+        uint64_t draws = (((uint64_t)limit << 32) + bound - 1) / bound;
+        return draws / 4294967296.0;
+    }
+}
+
+BattleSolver::BattleSolver(const Player& player, const PotionManager& potions, const vector<string>& enemyTypes,
+                           bool playerFirst, bool enemyDoubleHP, EquipmentType disabledEquip)
+    : stats(player), playerFirst(playerFirst), entryCount(0), stateCount(0), stateLimit(DEFAULT_STATE_LIMIT), tooLarge(false),
+      firstPolicyTurn(2), swept(false) {
+    stats.setDisabledEquipment(disabledEquip);
+    extraActions = stats.getDerivedStats().extraActions;
+    
+    start.health = stats.getMaxHealth();
+    start.baseMaxHealth = stats.getBaseMaxHealth();
+    start.baseAttack = stats.getBaseAttack();
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        start.potions[i] = min(potions.getQuantity((PotionType)i), MAX_POTIONS);
+    }
+    start.enemyCount = 0;
+    for (const auto& name : enemyTypes) {
+        EnemyType type;
+        if (parseEnemyType(name, type) && start.enemyCount < ENEMY_SLOTS) {
+            start.enemyType[start.enemyCount] = type;
+            start.enemyHealth[start.enemyCount] = getEnemyTypeHealth(type) * (enemyDoubleHP ? 2 : 1);
+            start.enemyCount++;
+        }
+    }
+    start.turn = 1;
+    start.actionsLeft = 0;
+    sortEnemies(start);
+    
+    double damageMultiplier = stats.getDamageMultiplier();
+    for (int i = 0; i < ENEMY_TYPE_COUNT; i++) {
+        enemyDamage[i] = (int)(getEnemyTypeAttack((EnemyType)i) * damageMultiplier);
+    }
+    
+    // The key holds the player's health in HEALTH_BITS bits, so max HP after every potion must fit
+    int peakBaseMaxHealth = start.baseMaxHealth;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        peakBaseMaxHealth += start.potions[i] * getPotionTraits((PotionType)i).maxHealth;
+    }
+    tooLarge = maxHealthFor(peakBaseMaxHealth) >= (1 << HEALTH_BITS) || actionsFor(1) > 7;
+    table.assign(INITIAL_TABLE_SIZE, Entry{EMPTY_KEY, 0.0});
+    nodeTable.assign(INITIAL_TABLE_SIZE, NodeSlot{EMPTY_KEY, 0});
+    
+    // Turn node 0 is the won battle, which has no successors
+    turnKeys.push_back(EMPTY_KEY);
+    turnEdgeStart = {0, 0};
+    choiceStart.push_back(0);
+    choiceEdgeStart.push_back(0);
+}
+
+void BattleSolver::sortEnemies(State& state) {
+    for (int i = 1; i < state.enemyCount; i++) {
+        for (int j = i; j > 0; j--) {
+            bool before = state.enemyType[j] < state.enemyType[j - 1] ||
+                          (state.enemyType[j] == state.enemyType[j - 1] && state.enemyHealth[j] < state.enemyHealth[j - 1]);
+            if (!before) break;
+            swap(state.enemyType[j], state.enemyType[j - 1]);
+            swap(state.enemyHealth[j], state.enemyHealth[j - 1]);
+        }
+    }
+}
+
+uint64_t BattleSolver::packKey(const State& state) {
+    // Health (10 bits), potion counts (3 bits each), actions left (3 bits), then one 10-bit code per enemy slot
+    uint64_t key = (uint64_t)state.health;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        key |= (uint64_t)state.potions[i] << (HEALTH_BITS + 3 * i);
+    }
+    key |= (uint64_t)state.actionsLeft << 22;
+    for (int i = 0; i < state.enemyCount; i++) {
+        uint64_t code = enemyCodeBase((int)state.enemyType[i]) + state.enemyHealth[i];
+        key |= code << (25 + ENEMY_BITS * i);
+    }
+    return key;
+}
+
+BattleSolver::State BattleSolver::unpackKey(uint64_t key) const {
+    State state;
+    state.health = (int)(key & ((1 << HEALTH_BITS) - 1));
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        state.potions[i] = (int)(key >> (HEALTH_BITS + 3 * i) & 7);
+    }
+    state.actionsLeft = (int)(key >> 22 & 7);
+    state.enemyCount = 0;
+    for (int i = 0; i < ENEMY_SLOTS; i++) {
+        int code = (int)(key >> (25 + ENEMY_BITS * i) & ((1 << ENEMY_BITS) - 1));
+        if (code == 0) break;
+        int type = 0;
+        while (enemyCodeBase(type + 1) < code) {
+            type++;
+        }
+        state.enemyType[i] = (EnemyType)type;
+        state.enemyHealth[i] = code - enemyCodeBase(type);
+        state.enemyCount++;
+    }
+    state.turn = 0;
+    deriveBaseStats(state);
+    return state;
+}
+
+void BattleSolver::deriveBaseStats(State& state) const {
+    state.baseMaxHealth = start.baseMaxHealth;
+    state.baseAttack = start.baseAttack;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        int drunk = max(start.potions[i] - state.potions[i], 0);
+        state.baseMaxHealth += drunk * getPotionTraits((PotionType)i).maxHealth;
+        state.baseAttack += drunk * getPotionTraits((PotionType)i).attack;
+    }
+}
+
+bool BattleSolver::countState() {
+    if (stateCount >= stateLimit) {
+        tooLarge = true;
+        return false;
+    }
+    stateCount++;
+    return true;
+}
+
+void BattleSolver::store(uint64_t key, double value) {
+    size_t slot = findSlot(table, key);
+    if (table[slot].key == EMPTY_KEY) {
+        if (!countState()) return;
+        if ((entryCount + 1) * 2 > table.size()) {
+            growSlots(table, Entry{EMPTY_KEY, 0.0});
+            slot = findSlot(table, key);
+        }
+        entryCount++;
+    }
+    table[slot] = Entry{key, value};
+}
+
+uint32_t BattleSolver::findNode(const State& state) {
+    uint64_t key = packKey(state);
+    size_t slot = findSlot(nodeTable, key);
+    if (nodeTable[slot].key != EMPTY_KEY) return nodeTable[slot].index;
+    if (!countState()) return 0;
+    
+    size_t nodeCount = turnKeys.size() - 1 + actionKeys.size();
+    if ((nodeCount + 1) * 2 > nodeTable.size()) {
+        growSlots(nodeTable, NodeSlot{EMPTY_KEY, 0});
+        slot = findSlot(nodeTable, key);
+    }
+    vector<uint64_t>& keys = state.actionsLeft > 0 ? actionKeys : turnKeys;
+    nodeTable[slot] = NodeSlot{key, (uint32_t)keys.size()};
+    keys.push_back(key);
+    return nodeTable[slot].index;
+}
+
+bool BattleSolver::buildGraph() {
+    vector<SolverDecision> decisions;
+    vector<Outcome> outcomes;
+    
+    // Nodes are expanded in the order they were found, so the successors of each node stay contiguous
+    while (!tooLarge) {
+        size_t turnNode = turnEdgeStart.size() - 1;
+        size_t actionNode = choiceStart.size() - 1;
+        if (turnNode < turnKeys.size()) {
+            State state = unpackKey(turnKeys[turnNode]);
+            if (playerFirst) {
+                state.actionsLeft = 1;
+                turnEdges.push_back({findNode(state), 1.0});
+            } else {
+                expandEnemyPhase(state, outcomes);
+                for (const auto& outcome : outcomes) {
+                    if (outcome.damage >= state.health) continue;
+                    State next = outcome.state;
+                    next.health = state.health - outcome.damage;
+                    next.actionsLeft = 1;
+                    turnEdges.push_back({findNode(next), outcome.probability});
+                }
+            }
+            turnEdgeStart.push_back((uint32_t)turnEdges.size());
+        } else if (actionNode < actionKeys.size()) {
+            State state = unpackKey(actionKeys[actionNode]);
+            listDecisions(state, decisions);
+            for (const auto& decision : decisions) {
+                State after = applyDecision(state, decision);
+                if (after.enemyCount == 0) {
+                    choiceEdges.push_back({0, 1.0});
+                } else if (playerFirst) {
+                    expandEnemyPhase(after, outcomes);
+                    for (const auto& outcome : outcomes) {
+                        if (outcome.damage >= after.health) continue;
+                        State next = outcome.state;
+                        next.health = after.health - outcome.damage;
+                        choiceEdges.push_back({findNode(next), outcome.probability});
+                    }
+                } else {
+                    choiceEdges.push_back({findNode(after), 1.0});
+                }
+                choiceEdgeStart.push_back((uint32_t)choiceEdges.size());
+            }
+            choiceStart.push_back((uint32_t)(choiceEdgeStart.size() - 1));
+        } else {
+            break;
+        }
+    }
+    return !tooLarge;
+}
+
+void BattleSolver::sweepTurns() {
+    size_t turnCount = turnKeys.size();
+    size_t actionCount = actionKeys.size();
+    vector<double> next(turnCount, 0.0);
+    vector<double> current(turnCount, 0.0);
+    vector<double> actionValues(actionCount);
+    next[0] = 1.0;
+    current[0] = 1.0;
+    policy.assign((size_t)(TURN_LIMIT - 1) * actionCount, 0);
+    
+    // next holds the values at the start of the turn after the one being swept (all 0 after TURN_LIMIT)
+    for (int turn = TURN_LIMIT; turn >= 2; turn--) {
+        uint8_t* row = policy.data() + (size_t)(turn - 2) * actionCount;
+        for (size_t node = 0; node < actionCount; node++) {
+            double best = -1.0;
+            for (uint32_t choice = choiceStart[node]; choice < choiceStart[node + 1]; choice++) {
+                double value = 0.0;
+                for (uint32_t i = choiceEdgeStart[choice]; i < choiceEdgeStart[choice + 1]; i++) {
+                    value += choiceEdges[i].probability * next[choiceEdges[i].target];
+                }
+                if (value > best) {
+                    best = value;
+                    row[node] = (uint8_t)(choice - choiceStart[node]);
+                }
+            }
+            actionValues[node] = best;
+        }
+        for (size_t node = 1; node < turnCount; node++) {
+            double value = 0.0;
+            for (uint32_t i = turnEdgeStart[node]; i < turnEdgeStart[node + 1]; i++) {
+                value += turnEdges[i].probability * actionValues[turnEdges[i].target];
+            }
+            current[node] = value;
+        }
+        
+        // Once a turn has the same values as the next one, every earlier turn repeats it
+        firstPolicyTurn = turn;
+        bool settled = current == next;
+        current.swap(next);
+        if (settled) break;
+    }
+    turnValues.swap(next);
+}
+
+int BattleSolver::attackFor(int baseAttack) {
+    stats.setBaseAttack(baseAttack);
+    return stats.getAttack();
+}
+
+int BattleSolver::maxHealthFor(int baseMaxHealth) {
+    stats.setBaseMaxHealth(baseMaxHealth);
+    return stats.getMaxHealth();
+}
+
+int BattleSolver::actionsFor(int turn) const {
+    return 1 + (turn == 1 ? extraActions : 0);
+}
+
+void BattleSolver::listDecisions(const State& state, vector<SolverDecision>& decisions) const {
+    decisions.clear();
+    for (int i = 0; i < state.enemyCount; i++) {
+        if (i > 0 && state.enemyType[i] == state.enemyType[i - 1] && state.enemyHealth[i] == state.enemyHealth[i - 1]) {
+            continue;
+        }
+        decisions.push_back({BattleAction::Attack, state.enemyType[i], state.enemyHealth[i], -1});
+    }
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        if (state.potions[i] > 0) {
+            decisions.push_back({BattleAction::UsePotion, EnemyType::Slim, 0, i});
+        }
+    }
+    if (decisions.empty()) {
+        decisions.push_back({BattleAction::Skip, EnemyType::Slim, 0, -1});
+    }
+}
+
+BattleSolver::State BattleSolver::applyDecision(const State& state, const SolverDecision& decision) {
+    State next = state;
+    next.actionsLeft--;
+    
+    if (decision.action == BattleAction::Attack) {
+        int target = 0;
+        while (next.enemyType[target] != decision.targetType || next.enemyHealth[target] != decision.targetHealth) {
+            target++;
+        }
+        next.enemyHealth[target] -= attackFor(next.baseAttack);
+        if (next.enemyHealth[target] <= 0) {
+            for (int i = target; i + 1 < next.enemyCount; i++) {
+                next.enemyType[i] = next.enemyType[i + 1];
+                next.enemyHealth[i] = next.enemyHealth[i + 1];
+            }
+            next.enemyCount--;
+        }
+        sortEnemies(next);
+    } else if (decision.action == BattleAction::UsePotion) {
+        // Same effects as Battle::playerUsePotion (POTION_TRAITS); raising max HP raises current HP by the same amount first
+        const PotionTraits& effect = getPotionTraits((PotionType)decision.potion);
+        next.potions[decision.potion]--;
+        next.baseMaxHealth += effect.maxHealth;
+        if (effect.maxHealth > 0 || effect.heal > 0) {
+            next.health = min(next.health + effect.maxHealth + effect.heal, maxHealthFor(next.baseMaxHealth));
+        }
+        next.baseAttack += effect.attack;
+    }
+    return next;
+}
+
+void BattleSolver::expandEnemyPhase(const State& state, vector<Outcome>& outcomes) const {
+    outcomes.clear();
+    outcomes.push_back({1.0, 0, state});
+    
+    // Enemies summoned during the phase are appended after the acting ones and do not act until next turn
+    int bossDamage = enemyDamage[(int)EnemyType::Boss];
+    for (int i = 0; i < state.enemyCount; i++) {
+        EnemyType type = state.enemyType[i];
+        if (type != EnemyType::Boss) {
+            for (auto& outcome : outcomes) {
+                outcome.damage += enemyDamage[(int)type];
+            }
+            continue;
+        }
+        
+        size_t count = outcomes.size();
+        for (size_t k = 0; k < count; k++) {
+            Outcome attack = outcomes[k];
+            attack.damage += bossDamage;
+            State& summoned = outcomes[k].state;
+            double probability = outcomes[k].probability;
+            int alive = summoned.enemyCount;
+            
+            if (alive >= 3) {
+                outcomes[k] = attack;
+            } else if (alive == 2) {
+                double attackChance = rollBelow(1, 2);
+                attack.probability = probability * attackChance;
+                outcomes[k].probability = probability * (1 - attackChance);
+                summoned.enemyType[alive] = EnemyType::Goust;
+                summoned.enemyHealth[alive] = getEnemyTypeHealth(EnemyType::Goust);
+                summoned.enemyCount++;
+                outcomes.push_back(attack);
+            } else {
+                double attackChance = rollBelow(34, 100);
+                double bathoChance = rollBelow(67, 100) - attackChance;
+                Outcome batho = outcomes[k];
+                batho.probability = probability * bathoChance;
+                int toAdd = min(2, ENEMY_SLOTS - alive);
+                for (int j = 0; j < toAdd; j++) {
+                    batho.state.enemyType[batho.state.enemyCount] = EnemyType::Batho;
+                    batho.state.enemyHealth[batho.state.enemyCount] = getEnemyTypeHealth(EnemyType::Batho);
+                    batho.state.enemyCount++;
+                }
+                attack.probability = probability * attackChance;
+                outcomes[k].probability = probability * (1 - attackChance - bathoChance);
+                summoned.enemyType[alive] = EnemyType::Goust;
+                summoned.enemyHealth[alive] = getEnemyTypeHealth(EnemyType::Goust);
+                summoned.enemyCount++;
+                outcomes.push_back(attack);
+                outcomes.push_back(batho);
+            }
+        }
+    }
+    
+    for (auto& outcome : outcomes) {
+        sortEnemies(outcome.state);
+    }
+}
+
+double BattleSolver::valueTurn(const State& state) {
+    if (state.turn > TURN_LIMIT || tooLarge) return 0.0;
+    if (state.turn > 1) {
+        uint32_t node = findNode(state);
+        return swept && !tooLarge ? turnValues[node] : 0.0;
+    }
+    
+    uint64_t key = packKey(state);
+    const Entry& entry = table[findSlot(table, key)];
+    if (entry.key != EMPTY_KEY) return entry.value;
+    
+    double value;
+    if (playerFirst) {
+        State next = state;
+        next.actionsLeft = actionsFor(state.turn);
+        value = valueAction(next);
+    } else {
+        value = valueEnemyPhase(state);
+    }
+    store(key, value);
+    return value;
+}
+
+double BattleSolver::valueAction(const State& state) {
+    if (state.enemyCount == 0) return 1.0;
+    if (tooLarge) return 0.0;
+    
+    uint64_t key = packKey(state);
+    const Entry& entry = table[findSlot(table, key)];
+    if (entry.key != EMPTY_KEY) return entry.value;
+    
+    double value;
+    bestDecision(state, value);
+    store(key, value);
+    return value;
+}
+
+double BattleSolver::valueAfterPlayer(const State& state) {
+    if (state.enemyCount == 0) return 1.0;
+    if (playerFirst) {
+        return valueEnemyPhase(state);
+    }
+    State next = state;
+    next.turn++;
+    next.actionsLeft = 0;
+    return valueTurn(next);
+}
+
+double BattleSolver::valueEnemyPhase(const State& state) {
+    vector<Outcome> outcomes;
+    expandEnemyPhase(state, outcomes);
+    
+    double value = 0.0;
+    for (const auto& outcome : outcomes) {
+        if (outcome.damage >= state.health) continue;
+        State next = outcome.state;
+        next.health = state.health - outcome.damage;
+        if (playerFirst) {
+            next.turn++;
+            next.actionsLeft = 0;
+            value += outcome.probability * valueTurn(next);
+        } else {
+            next.actionsLeft = actionsFor(next.turn);
+            value += outcome.probability * valueAction(next);
+        }
+    }
+    return value;
+}
+
+SolverDecision BattleSolver::bestDecision(const State& state, double& value) {
+    vector<SolverDecision> decisions;
+    listDecisions(state, decisions);
+    
+    SolverDecision best = decisions.back();
+    value = -1.0;
+    for (const auto& decision : decisions) {
+        State next = applyDecision(state, decision);
+        double result = next.actionsLeft > 0 ? valueAction(next) : valueAfterPlayer(next);
+        if (result > value) {
+            value = result;
+            best = decision;
+        }
+    }
+    return best;
+}
+
+void BattleSolver::setStateLimit(size_t limit) {
+    stateLimit = limit;
+}
+
+bool BattleSolver::solve(double& winChance) {
+    if (tooLarge) {
+        return false;
+    }
+    try {
+        // The first pass over turn 1 only finds the turn 2 states it leads to, so its values are dropped
+        valueTurn(start);
+        table.assign(INITIAL_TABLE_SIZE, Entry{EMPTY_KEY, 0.0});
+        stateCount -= entryCount;
+        entryCount = 0;
+        if (!buildGraph()) {
+            return false;
+        }
+        sweepTurns();
+        swept = true;
+        winChance = valueTurn(start);
+    } catch (const bad_alloc&) {
+        tooLarge = true;
+    }
+    return !tooLarge;
+}
+
+SolverDecision BattleSolver::chooseDecision(const Battle& battle) {
+    BattleSnapshot snapshot;
+    if (!battle.saveSnapshot(snapshot)) {
+        // Horde battles are beyond the solver's ENEMY_SLOTS enemies
+        return {BattleAction::Skip, EnemyType::Slim, 0, -1};
+    }
+    
+    // Base stats are derived from the potions drunk so far, like in every state the solver keys
+    State state;
+    state.health = snapshot.player.currentHealth;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        state.potions[i] = min((int)snapshot.potions.counts[i], MAX_POTIONS);
+    }
+    deriveBaseStats(state);
+    state.enemyCount = 0;
+    for (int i = 0; i < snapshot.enemyCount && state.enemyCount < ENEMY_SLOTS; i++) {
+        if (snapshot.enemies[i].alive) {
+            state.enemyType[state.enemyCount] = snapshot.enemies[i].type;
+            state.enemyHealth[state.enemyCount] = snapshot.enemies[i].health;
+            state.enemyCount++;
+        }
+    }
+    state.turn = snapshot.turnCount;
+    state.actionsLeft = snapshot.actionsLeft;
+    sortEnemies(state);
+    
+    if (state.turn > 1) {
+        return sweptDecision(state, state.turn);
+    }
+    double value;
+    return bestDecision(state, value);
+}
+
+SolverDecision BattleSolver::sweptDecision(const State& state, int turn) {
+    vector<SolverDecision> decisions;
+    listDecisions(state, decisions);
+    const NodeSlot& slot = nodeTable[findSlot(nodeTable, packKey(state))];
+    if (!swept || slot.key == EMPTY_KEY || turn > TURN_LIMIT) {
+        return decisions.front();
+    }
+    size_t row = max(turn, firstPolicyTurn) - 2;
+    return decisions[policy[row * actionKeys.size() + slot.index]];
+}
+
+SolverDecision BattleSolver::getOpeningDecision() {
+    State state = start;
+    if (!playerFirst) {
+        // The first player action comes after the enemies act: follow their most likely result
+        vector<Outcome> outcomes;
+        expandEnemyPhase(start, outcomes);
+        const Outcome* likely = nullptr;
+        for (const auto& outcome : outcomes) {
+            if (outcome.damage < start.health && (!likely || outcome.probability > likely->probability)) {
+                likely = &outcome;
+            }
+        }
+        if (!likely) {
+            return {BattleAction::Skip, EnemyType::Slim, 0, -1};
+        }
+        state = likely->state;
+        state.health = start.health - likely->damage;
+    }
+    state.actionsLeft = actionsFor(state.turn);
+    
+    double value;
+    return bestDecision(state, value);
+}
+
+size_t BattleSolver::writeFirstTurn(const State& state, ostream& out, vector<uint64_t>& written, vector<bool>& reached) {
+    vector<Outcome> outcomes;
+    if (state.actionsLeft == 0) {
+        // Start of the first turn: the player acts after the enemy phase on hard
+        size_t lines = 0;
+        if (playerFirst) {
+            State next = state;
+            next.actionsLeft = actionsFor(state.turn);
+            return writeFirstTurn(next, out, written, reached);
+        }
+        expandEnemyPhase(state, outcomes);
+        for (const auto& outcome : outcomes) {
+            if (outcome.damage >= state.health) continue;
+            State next = outcome.state;
+            next.health = state.health - outcome.damage;
+            next.actionsLeft = actionsFor(next.turn);
+            lines += writeFirstTurn(next, out, written, reached);
+        }
+        return lines;
+    }
+    
+    uint64_t key = packKey(state);
+    if (state.enemyCount == 0 || find(written.begin(), written.end(), key) != written.end()) return 0;
+    written.push_back(key);
+    
+    double value;
+    SolverDecision decision = bestDecision(state, value);
+    writePolicyLine(out, "Turn 1", state, decision, value);
+    size_t lines = 1;
+    
+    State next = applyDecision(state, decision);
+    if (next.enemyCount == 0) return lines;
+    if (next.actionsLeft > 0) {
+        return lines + writeFirstTurn(next, out, written, reached);
+    }
+    if (playerFirst) {
+        expandEnemyPhase(next, outcomes);
+        for (const auto& outcome : outcomes) {
+            if (outcome.damage >= next.health) continue;
+            State reachedState = outcome.state;
+            reachedState.health = next.health - outcome.damage;
+            reached[findNode(reachedState)] = true;
+        }
+    } else {
+        reached[findNode(next)] = true;
+    }
+    return lines;
+}
+
+void BattleSolver::writePolicyLine(ostream& out, const string& turns, const State& state,
+                                   const SolverDecision& decision, double value) {
+    ostringstream line;
+    line << turns << ": HP " << state.health << " |";
+    bool anyPotion = false;
+    for (int i = 0; i < POTION_TYPE_COUNT; i++) {
+        if (state.potions[i] > 0) {
+            line << (anyPotion ? ", " : " ") << getPotionName((PotionType)i) << " x" << state.potions[i];
+            anyPotion = true;
+        }
+    }
+    line << (anyPotion ? " |" : " no potions |");
+    for (int i = 0; i < state.enemyCount; i++) {
+        line << (i > 0 ? ", " : " ") << getEnemyTypeName(state.enemyType[i]) << " " << state.enemyHealth[i];
+    }
+    line << " -> " << describe(decision);
+    if (value >= 0.0) {
+        line << fixed << setprecision(4) << " (win " << 100.0 * value << "%)";
+    }
+    out << line.str() << "\n";
+}
+
+size_t BattleSolver::writePolicy(ostream& out) {
+    if (!swept) return 0;
+    
+    vector<uint64_t> written;
+    vector<bool> reached(turnKeys.size(), false);
+    size_t lines = writeFirstTurn(start, out, written, reached);
+    
+    // Follow the swept decisions turn by turn, merging the turns a state keeps its decision in
+    struct Range {
+        int first;
+        int last;
+        uint32_t node;
+        uint8_t choice;
+    };
+    vector<Range> ranges;
+    vector<int64_t> latest(actionKeys.size(), -1);
+    vector<bool> next(turnKeys.size());
+    for (int turn = 2; turn <= TURN_LIMIT; turn++) {
+        const uint8_t* row = policy.data() + (size_t)(max(turn, firstPolicyTurn) - 2) * actionKeys.size();
+        fill(next.begin(), next.end(), false);
+        for (size_t node = 1; node < turnKeys.size(); node++) {
+            if (!reached[node]) continue;
+            for (uint32_t i = turnEdgeStart[node]; i < turnEdgeStart[node + 1]; i++) {
+                uint32_t action = turnEdges[i].target;
+                uint8_t choice = row[action];
+                int64_t& range = latest[action];
+                if (range >= 0 && ranges[range].last == turn) continue;
+                if (range >= 0 && ranges[range].last == turn - 1 && ranges[range].choice == choice) {
+                    ranges[range].last = turn;
+                } else {
+                    range = (int64_t)ranges.size();
+                    ranges.push_back({turn, turn, action, choice});
+                }
+                uint32_t taken = choiceStart[action] + choice;
+                for (uint32_t j = choiceEdgeStart[taken]; j < choiceEdgeStart[taken + 1]; j++) {
+                    next[choiceEdges[j].target] = true;
+                }
+            }
+        }
+        next[0] = false;
+        reached.swap(next);
+    }
+    
+    stable_sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.first < b.first; });
+    vector<SolverDecision> decisions;
+    for (const auto& range : ranges) {
+        State state = unpackKey(actionKeys[range.node]);
+        listDecisions(state, decisions);
+        string turns = range.first == range.last ? "Turn " + to_string(range.first)
+                                                 : "Turns " + to_string(range.first) + "-" + to_string(range.last);
+        writePolicyLine(out, turns, state, decisions[range.choice], -1.0);
+    }
+    return lines + ranges.size();
+}
+
+size_t BattleSolver::getStateCount() const {
+    return stateCount;
+}
+
+string BattleSolver::describe(const SolverDecision& decision) {
+    switch (decision.action) {
+        case BattleAction::Attack:
+            return string("Attack ") + getEnemyTypeName(decision.targetType) + " (" + to_string(decision.targetHealth) + " HP)";
+        case BattleAction::UsePotion:
+            return string("Use ") + getPotionName((PotionType)decision.potion);
+        default:
+            return "Skip";
+    }
+}
+
+OptimalBattlePolicy::OptimalBattlePolicy(BattleSolver* solver)
+    : solver(solver), pending{BattleAction::Skip, EnemyType::Slim, 0, -1} {
+}
+
+BattleAction OptimalBattlePolicy::chooseAction(const Battle& battle) {
+    pending = solver->chooseDecision(battle);
+    return pending.action;
+}
+
+int OptimalBattlePolicy::chooseTarget(const Battle& battle) {
+    const EnemyPool& enemies = battle.getEnemies();
+    for (int i = 0; i < enemies.size(); i++) {
+        if (enemies.isAlive(i) && enemies.getType(i) == pending.targetType && enemies.getHealth(i) == pending.targetHealth) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+string OptimalBattlePolicy::choosePotion(const Battle& battle, const PotionManager& potions) {
+    (void)battle;
+    (void)potions;
+    return pending.potion >= 0 ? getPotionName((PotionType)pending.potion) : "";
+}
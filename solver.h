@@ -0,0 +1,309 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "battle.h"
+#include "player.h"
+#include "potion.h"
+#include "enemy.h"
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstdint>
+
+// One choice of the player for a battle action
+struct SolverDecision {
+    BattleAction action;
+    EnemyType targetType;
+    int targetHealth;
+    int potion;
+};
+
+// Exact solver for one battle setup. Searches every reachable battle state (player HP and stats,
+// potion counts, enemy HP multiset, turn and actions left) with expectimax: the player picks the
+// action with the best win probability, boss rolls in Battle::bossAction are averaged with their
+// exact Random::nextInt probabilities.
+// From turn 2 on every turn has the same rules, so the states are built once as a graph without the
+// turn number (each keyed by its packed state in a hash table) and the values are swept backwards
+// from TURN_LIMIT, keeping only the values of two turns and one policy byte per state and turn. A
+// sweep that changes no value ends early: every earlier turn then has the same values and decisions.
+// The extra actions of turn 1 are solved on top with a memoized search.
+// Supported setups: up to MAX_POTIONS potions of each type and at most 1023 max HP after drinking
+// them all. A solve that would need more states than the state limit stops and reports that the
+// battle is too large.
+class BattleSolver {
+public:
+    // Number of enemy slots (same cap as Battle::MAX_ENEMIES)
+    static const int ENEMY_SLOTS = 3;
+    
+    // Last turn the player can still win in (Battle::isLost ends the battle after it)
+    static const int TURN_LIMIT = 50;
+    
+    // Highest potion count of one type the state key can hold (larger counts are capped)
+    static const int MAX_POTIONS = 7;
+    
+    // States kept by default before a solve gives up (the graph and the policy then take about 1.2 GiB)
+    static const size_t DEFAULT_STATE_LIMIT = (size_t)1 << 23;
+    
+private:
+    // Battle state at the start of a turn (actionsLeft == 0) or before a player action. The base stats
+    // follow from the potions drunk, so they are not part of the state key.
+    struct State {
+        int health;
+        int baseMaxHealth;
+        int baseAttack;
+        int potions[POTION_TYPE_COUNT];
+        int enemyCount;
+        EnemyType enemyType[ENEMY_SLOTS];
+        int enemyHealth[ENEMY_SLOTS];
+        int turn;
+        int actionsLeft;
+    };
+    
+    // One possible result of an enemy phase
+    struct Outcome {
+        double probability;
+        int damage;
+        State state;
+    };
+    
+    // One slot of the turn 1 table (key == EMPTY_KEY marks a free slot)
+    struct Entry {
+        uint64_t key;
+        double value;
+    };
+    
+    // One slot of the graph's node table (key == EMPTY_KEY marks a free slot)
+    struct NodeSlot {
+        uint64_t key;
+        uint32_t index;
+    };
+    
+    // One successor of a graph node
+    struct Edge {
+        uint32_t target;
+        double probability;
+    };
+    
+    Player stats;
+    State start;
+    bool playerFirst;
+    int extraActions;
+    int enemyDamage[ENEMY_TYPE_COUNT];
+    std::vector<Entry> table;
+    size_t entryCount;
+    size_t stateCount;
+    size_t stateLimit;
+    bool tooLarge;
+    
+    // Graph of the turns after the first: turn nodes (actionsLeft == 0, node 0 stands for a won battle) lead to
+    // action nodes with the chance of each enemy phase result (hard) or straight to theirs (easy); each choice of
+    // an action node leads to the turn nodes of the next turn
+    std::vector<NodeSlot> nodeTable;
+    std::vector<uint64_t> turnKeys;
+    std::vector<uint32_t> turnEdgeStart;
+    std::vector<Edge> turnEdges;
+    std::vector<uint64_t> actionKeys;
+    std::vector<uint32_t> choiceStart;
+    std::vector<uint32_t> choiceEdgeStart;
+    std::vector<Edge> choiceEdges;
+    
+    // Win probability of every turn node at turn 2, and the best choice of every action node for the turns from
+    // firstPolicyTurn to TURN_LIMIT (one row per turn; earlier turns use the row of firstPolicyTurn)
+    std::vector<double> turnValues;
+    std::vector<uint8_t> policy;
+    int firstPolicyTurn;
+    bool swept;
+    
+    // What it does: Sorts the enemies of a state so equal multisets give equal keys
+    // Inputs: state - state to normalize
+    // Outputs: None
+    static void sortEnemies(State& state);
+    
+    // What it does: Packs a state into a 64-bit key (without the turn)
+    // Inputs: state - state to pack
+    // Outputs: Key (uint64_t)
+    static uint64_t packKey(const State& state);
+    
+    // What it does: Rebuilds a state from its key, deriving the base stats from the potions drunk since the start
+    // Inputs: key - packed state
+    // Outputs: State (turn 0)
+    State unpackKey(uint64_t key) const;
+    
+    // What it does: Sets the base stats of a state from the potions drunk since the start of the battle
+    // Inputs: state - state whose potion counts are set
+    // Outputs: None
+    void deriveBaseStats(State& state) const;
+    
+    // What it does: Counts one more solved state (marks the battle as too large once the state limit is reached)
+    // Inputs: None
+    // Outputs: Returns true if the state fits under the limit
+    bool countState();
+    
+    // What it does: Stores a solved turn 1 state, growing the table when it is half full
+    // Inputs: key - packed state, value - win probability
+    // Outputs: None
+    void store(uint64_t key, double value);
+    
+    // What it does: Returns the graph node of a state after the first turn, adding it when it is new
+    // Inputs: state - state at the start of a turn or before a player action
+    // Outputs: Index among the turn nodes (actionsLeft == 0) or the action nodes
+    uint32_t findNode(const State& state);
+    
+    // What it does: Adds the successors of every graph node, including the nodes they discover
+    // Inputs: None
+    // Outputs: Returns false if the battle is too large
+    bool buildGraph();
+    
+    // What it does: Sweeps the graph's values from TURN_LIMIT back to turn 2, filling turnValues and policy
+    // Inputs: None
+    // Outputs: None
+    void sweepTurns();
+    
+    // What it does: Returns the player's attack for a base attack (equipment and boss bonus applied)
+    // Inputs: baseAttack - base attack
+    // Outputs: Attack damage (int)
+    int attackFor(int baseAttack);
+    
+    // What it does: Returns the player's max HP for a base max HP (armor applied)
+    // Inputs: baseMaxHealth - base max HP
+    // Outputs: Max HP (int)
+    int maxHealthFor(int baseMaxHealth);
+    
+    // What it does: Returns number of player actions in a turn (extra actions only count on the first turn)
+    // Inputs: turn - turn number
+    // Outputs: Action count (int)
+    int actionsFor(int turn) const;
+    
+    // What it does: Lists the decisions available in a state
+    // Inputs: state - state before a player action, decisions - vector to fill
+    // Outputs: None
+    void listDecisions(const State& state, std::vector<SolverDecision>& decisions) const;
+    
+    // What it does: Applies one decision like Battle::playerAttack / playerUsePotion
+    // Inputs: state - state before the action, decision - decision to apply
+    // Outputs: State after the action (actionsLeft reduced by one)
+    State applyDecision(const State& state, const SolverDecision& decision);
+    
+    // What it does: Lists every result of an enemy phase with its probability (boss rolls included)
+    // Inputs: state - state before the enemies act, outcomes - vector to fill
+    // Outputs: None
+    void expandEnemyPhase(const State& state, std::vector<Outcome>& outcomes) const;
+    
+    // What it does: Computes the win probability at the start of a turn (from the graph after the first turn)
+    // Inputs: state - state with actionsLeft == 0
+    // Outputs: Win probability under optimal play
+    double valueTurn(const State& state);
+    
+    // What it does: Computes the win probability before a player action of the first turn
+    // Inputs: state - state with actionsLeft > 0
+    // Outputs: Win probability under optimal play
+    double valueAction(const State& state);
+    
+    // What it does: Computes the win probability once the player's actions of the turn are done
+    // Inputs: state - state after the last action of the turn
+    // Outputs: Win probability under optimal play
+    double valueAfterPlayer(const State& state);
+    
+    // What it does: Computes the win probability of the enemy phase and everything after it
+    // Inputs: state - state before the enemies act
+    // Outputs: Win probability under optimal play
+    double valueEnemyPhase(const State& state);
+    
+    // What it does: Picks the best decision of a first turn state
+    // Inputs: state - state before a player action, value - reference to store its win probability
+    // Outputs: Best decision (attacks come first on ties, then potions, then skipping)
+    SolverDecision bestDecision(const State& state, double& value);
+    
+    // What it does: Returns the swept decision of a state after the first turn
+    // Inputs: state - state before a player action, turn - turn number
+    // Outputs: Best decision
+    SolverDecision sweptDecision(const State& state, int turn);
+    
+    // What it does: Writes the first turn decisions optimal play can reach from a state, collecting the turn 2 nodes
+    // Inputs: state - state at the start of the first turn or before one of its actions, out - stream to write to,
+    //         written - keys of the states already written, reached - turn nodes of turn 2 to mark
+    // Outputs: Number of policy lines written
+    size_t writeFirstTurn(const State& state, std::ostream& out, std::vector<uint64_t>& written, std::vector<bool>& reached);
+    
+    // What it does: Writes one line of the policy
+    // Inputs: out - stream to write to, turns - turn or turn range, state - state before the action,
+    //         decision - decision taken, value - win probability (negative to leave it out)
+    // Outputs: None
+    static void writePolicyLine(std::ostream& out, const std::string& turns, const State& state,
+                                const SolverDecision& decision, double value);
+    
+public:
+    // What it does: Prepares the solver for one battle setup
+    // Inputs: player - player entering the battle, potions - potions the player carries, enemyTypes - enemy type names of the level,
+    //         playerFirst - true if player acts first, enemyDoubleHP - true if enemies have double HP, disabledEquip - equipment disabled for this battle
+    // Outputs: None
+    BattleSolver(const Player& player, const PotionManager& potions, const std::vector<std::string>& enemyTypes,
+                 bool playerFirst, bool enemyDoubleHP = false, EquipmentType disabledEquip = EquipmentType::None);
+    
+    // What it does: Sets how many states a solve may keep before it gives up
+    // Inputs: limit - state count
+    // Outputs: None
+    void setStateLimit(size_t limit);
+    
+    // What it does: Solves the battle from its start
+    // Inputs: winChance - reference to store the win probability under optimal play
+    // Outputs: Returns true if the battle was solved, false if it is too large (more states than the limit,
+    //          not enough memory, or a setup beyond the supported range)
+    bool solve(double& winChance);
+    
+    // What it does: Picks the best decision in a running battle (used by OptimalBattlePolicy)
+    // Inputs: battle - battle waiting for a player action
+    // Outputs: Best decision (Skip for a horde battle, which the solver does not model)
+    SolverDecision chooseDecision(const Battle& battle);
+    
+    // What it does: Returns the best first decision of the battle
+    // Inputs: None
+    // Outputs: Best decision
+    SolverDecision getOpeningDecision();
+    
+    // What it does: Writes the optimal policy of a solved battle: the best decision of every state optimal play
+    // can reach, with the turns it applies in (and the win probability during the first turn)
+    // Inputs: out - stream to write to
+    // Outputs: Number of policy lines written
+    size_t writePolicy(std::ostream& out);
+    
+    // What it does: Returns number of states solved so far
+    // Inputs: None
+    // Outputs: State count
+    size_t getStateCount() const;
+    
+    // What it does: Describes a decision for printing
+    // Inputs: decision - decision to describe
+    // Outputs: Text such as "Attack Batho (60 HP)", "Use Life Potion" or "Skip"
+    static std::string describe(const SolverDecision& decision);
+};
+
+// Battle policy that plays the solver's optimal decisions
+class OptimalBattlePolicy : public BattlePolicy {
+private:
+    BattleSolver* solver;
+    SolverDecision pending;
+    
+public:
+    // What it does: Creates the policy
+    // Inputs: solver - solver of the battle setup being played
+    // Outputs: None
+    explicit OptimalBattlePolicy(BattleSolver* solver);
+    
+    // What it does: Chooses the action with the best win probability
+    // Inputs: battle - battle being played
+    // Outputs: Chosen action
+    BattleAction chooseAction(const Battle& battle) override;
+    
+    // What it does: Returns an alive enemy matching the chosen target
+    // Inputs: battle - battle being played
+    // Outputs: Index of the enemy
+    int chooseTarget(const Battle& battle) override;
+    
+    // What it does: Returns the chosen potion
+    // Inputs: battle - battle being played, potions - player's potion inventory
+    // Outputs: Name of the potion
+    std::string choosePotion(const Battle& battle, const PotionManager& potions) override;
+};
+
+#endif